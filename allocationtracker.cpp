@@ -0,0 +1,275 @@
+#include "allocationtracker.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <prism/log.h>
+
+#include "profiler.h"
+
+using namespace std;
+
+// Counts heap allocations by replacing the global operator new and delete, for the benchmarks.
+// Every block starts with a header holding its size and whether it was counted, so blocks allocated while tracking
+// was off are freed without touching the counters. Only C++ allocations are seen, Prism's allocMemory is plain malloc.
+// The replacements are only compiled with ALLOCATION_TRACKING, which just the Profile configuration of the Windows project
+// defines, so regular builds and Dreamcast keep the plain allocator and report no allocation numbers.
+// With --alloc-profile FILE every allocation of the game thread is also tagged with the innermost profiler zone, see
+// profiler.h, and the profiler hands over every finished frame. When the game screen is unloaded the allocations and bytes
+// per frame of every zone, the worst frame and the number of frames that allocated at all are appended to FILE ("-" for
+// stdout). Allocations outside of a gameplay actor, like the collision callbacks run by Prism, and allocations of other
+// threads are counted as "other".
+
+#define ALLOCATION_ZONE_AMOUNT (PROFILE_ZONE_AMOUNT + 1)
+
+struct AllocationHeader {
+	size_t mSize;
+	size_t mIsTracked;
+};
+
+static struct {
+	atomic<int> mIsActive;
+	atomic<uint64_t> mAllocationAmount;
+	atomic<uint64_t> mAllocatedBytes;
+	atomic<int64_t> mLiveBytes;
+	atomic<int64_t> mPeakLiveBytes;
+
+	atomic<int> mIsProfiling;
+	atomic<int> mZone;
+	thread::id mGameThread;
+	atomic<uint64_t> mZoneAllocationAmounts[ALLOCATION_ZONE_AMOUNT];
+	atomic<uint64_t> mZoneAllocatedBytes[ALLOCATION_ZONE_AMOUNT];
+} gAllocationTracker;
+
+struct AllocationZoneProfile {
+	uint64_t mLastAllocationAmount;
+	uint64_t mLastAllocatedBytes;
+	uint64_t mAllocationAmount;
+	uint64_t mAllocatedBytes;
+	uint64_t mMaxAllocationAmount;
+	int mAllocatingFrames;
+};
+
+static struct {
+	string mReportPath;
+	AllocationZoneProfile mZones[ALLOCATION_ZONE_AMOUNT];
+	int mFrameAmount;
+} gAllocationProfile;
+
+#ifdef ALLOCATION_TRACKING
+
+static void updatePeakLiveBytes(int64_t tLiveBytes) {
+	int64_t peak = gAllocationTracker.mPeakLiveBytes.load(memory_order_relaxed);
+	while (tLiveBytes > peak && !gAllocationTracker.mPeakLiveBytes.compare_exchange_weak(peak, tLiveBytes, memory_order_relaxed)) {}
+}
+
+static void* allocateTracked(size_t tSize) {
+	AllocationHeader* header = (AllocationHeader*)malloc(sizeof(AllocationHeader) + tSize);
+	if (!header) return nullptr;
+
+	header->mSize = tSize;
+	const int isProfiling = gAllocationTracker.mIsProfiling.load(memory_order_relaxed);
+	header->mIsTracked = isProfiling || gAllocationTracker.mIsActive.load(memory_order_relaxed);
+	if (header->mIsTracked) {
+		gAllocationTracker.mAllocationAmount.fetch_add(1, memory_order_relaxed);
+		gAllocationTracker.mAllocatedBytes.fetch_add(tSize, memory_order_relaxed);
+		updatePeakLiveBytes(gAllocationTracker.mLiveBytes.fetch_add(int64_t(tSize), memory_order_relaxed) + int64_t(tSize));
+	}
+	if (isProfiling) {
+		const int zone = this_thread::get_id() == gAllocationTracker.mGameThread ? gAllocationTracker.mZone.load(memory_order_relaxed) : PROFILE_ZONE_AMOUNT;
+		gAllocationTracker.mZoneAllocationAmounts[zone].fetch_add(1, memory_order_relaxed);
+		gAllocationTracker.mZoneAllocatedBytes[zone].fetch_add(tSize, memory_order_relaxed);
+	}
+	return header + 1;
+}
+
+static void freeTracked(void* tData) {
+	if (!tData) return;
+
+	AllocationHeader* header = (AllocationHeader*)tData - 1;
+	if (header->mIsTracked) {
+		gAllocationTracker.mLiveBytes.fetch_sub(int64_t(header->mSize), memory_order_relaxed);
+	}
+	free(header);
+}
+
+static void* allocateTrackedOrThrow(size_t tSize) {
+	void* data = allocateTracked(tSize);
+	if (!data) throw bad_alloc();
+	return data;
+}
+
+void* operator new(size_t tSize) {
+	return allocateTrackedOrThrow(tSize);
+}
+
+void* operator new[](size_t tSize) {
+	return allocateTrackedOrThrow(tSize);
+}
+
+void* operator new(size_t tSize, const nothrow_t&) noexcept {
+	return allocateTracked(tSize);
+}
+
+void* operator new[](size_t tSize, const nothrow_t&) noexcept {
+	return allocateTracked(tSize);
+}
+
+void operator delete(void* tData) noexcept {
+	freeTracked(tData);
+}
+
+void operator delete[](void* tData) noexcept {
+	freeTracked(tData);
+}
+
+void operator delete(void* tData, const nothrow_t&) noexcept {
+	freeTracked(tData);
+}
+
+void operator delete[](void* tData, const nothrow_t&) noexcept {
+	freeTracked(tData);
+}
+
+void operator delete(void* tData, size_t) noexcept {
+	freeTracked(tData);
+}
+
+void operator delete[](void* tData, size_t) noexcept {
+	freeTracked(tData);
+}
+
+int isAllocationTrackingAvailable()
+{
+	return 1;
+}
+
+#else
+
+int isAllocationTrackingAvailable()
+{
+	return 0;
+}
+
+#endif
+
+void setAllocationTrackingActive(int tIsActive)
+{
+	gAllocationTracker.mIsActive = tIsActive;
+}
+
+AllocationStats getAllocationStats()
+{
+	AllocationStats ret;
+	ret.mAllocationAmount = gAllocationTracker.mAllocationAmount.load(memory_order_relaxed);
+	ret.mAllocatedBytes = gAllocationTracker.mAllocatedBytes.load(memory_order_relaxed);
+	ret.mLiveBytes = gAllocationTracker.mLiveBytes.load(memory_order_relaxed);
+	ret.mPeakLiveBytes = gAllocationTracker.mPeakLiveBytes.load(memory_order_relaxed);
+	return ret;
+}
+
+void resetAllocationPeak()
+{
+	gAllocationTracker.mPeakLiveBytes = gAllocationTracker.mLiveBytes.load(memory_order_relaxed);
+}
+
+int parseAllocationProfileArguments(int argc, char** argv)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (!strcmp(argv[i], "--alloc-profile")) gAllocationProfile.mReportPath = argv[++i];
+	}
+	if (gAllocationProfile.mReportPath.empty()) return 0;
+	if (!isAllocationTrackingAvailable()) {
+		logWarning("Allocation profiling is not available in this build, it requires ALLOCATION_TRACKING.");
+		return 0;
+	}
+
+	gAllocationTracker.mGameThread = this_thread::get_id();
+	gAllocationTracker.mZone = PROFILE_ZONE_AMOUNT;
+	gAllocationTracker.mIsProfiling = 1;
+	setProfilerActive(1);
+	return 1;
+}
+
+int isAllocationProfileActive()
+{
+	return gAllocationTracker.mIsProfiling.load(memory_order_relaxed);
+}
+
+void setAllocationZone(int tZone)
+{
+	gAllocationTracker.mZone.store(tZone, memory_order_relaxed);
+}
+
+void startAllocationProfileRun()
+{
+	if (!isAllocationProfileActive()) return;
+
+	for (int i = 0; i < ALLOCATION_ZONE_AMOUNT; i++) {
+		auto& zone = gAllocationProfile.mZones[i];
+		zone = AllocationZoneProfile();
+		zone.mLastAllocationAmount = gAllocationTracker.mZoneAllocationAmounts[i].load(memory_order_relaxed);
+		zone.mLastAllocatedBytes = gAllocationTracker.mZoneAllocatedBytes[i].load(memory_order_relaxed);
+	}
+	gAllocationProfile.mFrameAmount = 0;
+}
+
+void addAllocationProfileFrame()
+{
+	if (!isAllocationProfileActive()) return;
+
+	for (int i = 0; i < ALLOCATION_ZONE_AMOUNT; i++) {
+		auto& zone = gAllocationProfile.mZones[i];
+		const uint64_t allocationAmount = gAllocationTracker.mZoneAllocationAmounts[i].load(memory_order_relaxed);
+		const uint64_t allocatedBytes = gAllocationTracker.mZoneAllocatedBytes[i].load(memory_order_relaxed);
+		const uint64_t frameAllocationAmount = allocationAmount - zone.mLastAllocationAmount;
+		zone.mAllocationAmount += frameAllocationAmount;
+		zone.mAllocatedBytes += allocatedBytes - zone.mLastAllocatedBytes;
+		zone.mMaxAllocationAmount = std::max(zone.mMaxAllocationAmount, frameAllocationAmount);
+		if (frameAllocationAmount) zone.mAllocatingFrames++;
+		zone.mLastAllocationAmount = allocationAmount;
+		zone.mLastAllocatedBytes = allocatedBytes;
+	}
+	gAllocationProfile.mFrameAmount++;
+}
+
+void reportAllocationProfile()
+{
+	if (!isAllocationProfileActive() || !gAllocationProfile.mFrameAmount) return;
+
+	const int isStdout = gAllocationProfile.mReportPath == "-";
+	FILE* file = isStdout ? stdout : fopen(gAllocationProfile.mReportPath.data(), "a");
+	if (!file) {
+		logWarningFormat("Unable to write allocation profile %s.", gAllocationProfile.mReportPath.data());
+		return;
+	}
+
+	int order[ALLOCATION_ZONE_AMOUNT];
+	uint64_t allocationAmount = 0, allocatedBytes = 0;
+	for (int i = 0; i < ALLOCATION_ZONE_AMOUNT; i++) {
+		order[i] = i;
+		allocationAmount += gAllocationProfile.mZones[i].mAllocationAmount;
+		allocatedBytes += gAllocationProfile.mZones[i].mAllocatedBytes;
+	}
+	sort(order, order + ALLOCATION_ZONE_AMOUNT, [](int a, int b) { return gAllocationProfile.mZones[a].mAllocationAmount > gAllocationProfile.mZones[b].mAllocationAmount; });
+
+	const double frameAmount = gAllocationProfile.mFrameAmount;
+	fprintf(file, "Allocation profile over %d frames: %.2f allocations, %.0f bytes per frame\n", gAllocationProfile.mFrameAmount, allocationAmount / frameAmount, allocatedBytes / frameAmount);
+	fprintf(file, "%-20s %12s %12s %12s %12s\n", "zone", "allocs/frame", "bytes/frame", "max_allocs", "frames");
+	for (auto i : order) {
+		const auto& zone = gAllocationProfile.mZones[i];
+		if (!zone.mAllocationAmount) continue;
+		fprintf(file, "%-20s %12.2f %12.0f %12llu %12d\n", getProfileZoneName(i), zone.mAllocationAmount / frameAmount, zone.mAllocatedBytes / frameAmount, (unsigned long long)zone.mMaxAllocationAmount, zone.mAllocatingFrames);
+	}
+	fprintf(file, "\n");
+	if (isStdout) fflush(file);
+	else fclose(file);
+}
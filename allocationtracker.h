@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+struct AllocationStats {
+	uint64_t mAllocationAmount;
+	uint64_t mAllocatedBytes;
+	int64_t mLiveBytes;
+	int64_t mPeakLiveBytes;
+};
+
+int isAllocationTrackingAvailable();
+void setAllocationTrackingActive(int tIsActive);
+AllocationStats getAllocationStats();
+void resetAllocationPeak();
+
+int parseAllocationProfileArguments(int argc, char** argv);
+int isAllocationProfileActive();
+void setAllocationZone(int tZone);
+void startAllocationProfileRun();
+void addAllocationProfileFrame();
+void reportAllocationProfile();
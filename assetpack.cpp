@@ -0,0 +1,241 @@
+#include "assetpack.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <mutex>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <prism/memoryhandler.h>
+#include <prism/log.h>
+
+#include "assetpackformat.h"
+
+using namespace std;
+
+// Reads assets out of the archive built by tools/assetpack.
+// On Linux the archive is mapped once and uncompressed entries are handed out as slices of the mapping.
+// Elsewhere the index stays in memory and entries are read through a single open file handle.
+
+static struct {
+	int mIsMounted = 0;
+
+	AssetPackHeader mHeader;
+	vector<AssetPackEntry> mEntries;
+	string mPathTable;
+
+	uint8_t* mMapping = nullptr;
+	size_t mMappingSize = 0;
+
+	FILE* mFile = nullptr;
+	mutex mFileMutex;
+} gAssetPack;
+
+static string getAssetPackPath(const string& tPath) {
+	string ret = tPath;
+	for (auto& c : ret) {
+		c = char(tolower((unsigned char)c));
+		if (c == '\\') c = '/';
+	}
+	while (!ret.empty() && ret[0] == '/') ret.erase(0, 1);
+	return ret;
+}
+
+static const AssetPackEntry* findAssetPackEntry(const string& tPath) {
+	if (!gAssetPack.mIsMounted) return nullptr;
+
+	const string path = getAssetPackPath(tPath);
+	auto compare = [](const AssetPackEntry& tEntry, const string& tValue) {
+		return gAssetPack.mPathTable.compare(tEntry.mPathOffset, tEntry.mPathLength, tValue) < 0;
+	};
+	auto it = lower_bound(gAssetPack.mEntries.begin(), gAssetPack.mEntries.end(), path, compare);
+	if (it == gAssetPack.mEntries.end() || gAssetPack.mPathTable.compare(it->mPathOffset, it->mPathLength, path)) return nullptr;
+	return &(*it);
+}
+
+static int loadAssetPackIndex(const uint8_t* tData, size_t tSize) {
+	if (tSize < sizeof(AssetPackHeader)) return 0;
+	memcpy(&gAssetPack.mHeader, tData, sizeof(AssetPackHeader));
+	if (memcmp(gAssetPack.mHeader.mMagic, ASSET_PACK_MAGIC, 4) || gAssetPack.mHeader.mVersion != ASSET_PACK_VERSION) return 0;
+
+	const size_t entrySize = gAssetPack.mHeader.mEntryAmount * sizeof(AssetPackEntry);
+	if (tSize < sizeof(AssetPackHeader) + entrySize + gAssetPack.mHeader.mPathTableSize) return 0;
+
+	gAssetPack.mEntries.resize(gAssetPack.mHeader.mEntryAmount);
+	memcpy(gAssetPack.mEntries.data(), tData + sizeof(AssetPackHeader), entrySize);
+	gAssetPack.mPathTable.assign((const char*)tData + sizeof(AssetPackHeader) + entrySize, gAssetPack.mHeader.mPathTableSize);
+	return 1;
+}
+
+#ifdef __linux__
+static int mapAssetPack(const char* tFullPath) {
+	int file = open(tFullPath, O_RDONLY);
+	if (file < 0) return 0;
+
+	struct stat info;
+	if (fstat(file, &info) || !info.st_size) {
+		close(file);
+		return 0;
+	}
+
+	void* mapping = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED) return 0;
+
+	gAssetPack.mMapping = (uint8_t*)mapping;
+	gAssetPack.mMappingSize = info.st_size;
+	if (!loadAssetPackIndex(gAssetPack.mMapping, gAssetPack.mMappingSize)) {
+		munmap(gAssetPack.mMapping, gAssetPack.mMappingSize);
+		gAssetPack.mMapping = nullptr;
+		return 0;
+	}
+	return 1;
+}
+#endif
+
+static int openAssetPackFile(const char* tFullPath) {
+	FILE* file = fopen(tFullPath, "rb");
+	if (!file) return 0;
+
+	AssetPackHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.mMagic, ASSET_PACK_MAGIC, 4) || header.mVersion != ASSET_PACK_VERSION) {
+		fclose(file);
+		return 0;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long fileSize = ftell(file);
+	const uint64_t indexSize = sizeof(AssetPackHeader) + uint64_t(header.mEntryAmount) * sizeof(AssetPackEntry) + header.mPathTableSize;
+	if (fileSize < 0 || indexSize > uint64_t(fileSize)) {
+		fclose(file);
+		return 0;
+	}
+
+	vector<uint8_t> index((size_t)indexSize);
+	fseek(file, 0, SEEK_SET);
+	if (fread(index.data(), 1, index.size(), file) != index.size() || !loadAssetPackIndex(index.data(), index.size())) {
+		fclose(file);
+		return 0;
+	}
+
+	gAssetPack.mFile = file;
+	return 1;
+}
+
+int mountAssetPack(const char* tPath)
+{
+	unmountAssetPack();
+
+	char fullPath[1024];
+	getFullPath(fullPath, tPath);
+
+#ifdef __linux__
+	gAssetPack.mIsMounted = mapAssetPack(fullPath);
+#endif
+	if (!gAssetPack.mIsMounted) {
+		gAssetPack.mIsMounted = openAssetPackFile(fullPath);
+	}
+
+	if (gAssetPack.mIsMounted) {
+		logFormat("Mounted asset pack %s with %d files.", tPath, int(gAssetPack.mEntries.size()));
+	}
+	return gAssetPack.mIsMounted;
+}
+
+void unmountAssetPack()
+{
+#ifdef __linux__
+	if (gAssetPack.mMapping) {
+		munmap(gAssetPack.mMapping, gAssetPack.mMappingSize);
+		gAssetPack.mMapping = nullptr;
+	}
+#endif
+	if (gAssetPack.mFile) {
+		fclose(gAssetPack.mFile);
+		gAssetPack.mFile = nullptr;
+	}
+	gAssetPack.mEntries.clear();
+	gAssetPack.mPathTable.clear();
+	gAssetPack.mIsMounted = 0;
+}
+
+int isAssetPackMounted()
+{
+	return gAssetPack.mIsMounted;
+}
+
+int hasAssetPackFile(const std::string& tPath)
+{
+	return findAssetPackEntry(tPath) != nullptr;
+}
+
+int isAssetPackFileZeroCopy(const std::string& tPath)
+{
+	auto entry = findAssetPackEntry(tPath);
+	if (!entry || !gAssetPack.mMapping || entry->mCompression != ASSET_PACK_COMPRESSION_NONE) return 0;
+
+	// the text parsers need the zero byte the packer stores after each uncompressed entry
+	const size_t end = size_t(entry->mDataOffset) + entry->mSize;
+	return end < gAssetPack.mMappingSize && gAssetPack.mMapping[end] == '\0';
+}
+
+static int readAssetPackEntry(const AssetPackEntry& tEntry, uint8_t* tDst) {
+	vector<uint8_t> stored;
+	const uint8_t* src;
+	if (gAssetPack.mMapping) {
+		if (size_t(tEntry.mDataOffset) + tEntry.mStoredSize > gAssetPack.mMappingSize) return 0;
+		src = gAssetPack.mMapping + tEntry.mDataOffset;
+	}
+	else {
+		stored.resize(tEntry.mStoredSize);
+		lock_guard<mutex> lock(gAssetPack.mFileMutex);
+		fseek(gAssetPack.mFile, tEntry.mDataOffset, SEEK_SET);
+		if (fread(stored.data(), 1, stored.size(), gAssetPack.mFile) != stored.size()) return 0;
+		src = stored.data();
+	}
+
+	if (tEntry.mCompression == ASSET_PACK_COMPRESSION_LZ) {
+		return decompressAssetPackLZ(src, tEntry.mStoredSize, tDst, tEntry.mSize);
+	}
+
+	memcpy(tDst, src, tEntry.mSize);
+	return 1;
+}
+
+Buffer getAssetPackFileBuffer(const std::string& tPath)
+{
+	auto entry = findAssetPackEntry(tPath);
+	if (!entry) return fileToBuffer(tPath.data());
+
+	if (isAssetPackFileZeroCopy(tPath)) {
+		return makeBuffer(gAssetPack.mMapping + entry->mDataOffset, entry->mSize);
+	}
+
+	char* data = (char*)allocMemory(entry->mSize + 1);
+	if (!readAssetPackEntry(*entry, (uint8_t*)data)) {
+		logWarningFormat("Unable to read %s from asset pack, loading it directly.", tPath.data());
+		freeMemory(data);
+		return fileToBuffer(tPath.data());
+	}
+	data[entry->mSize] = '\0';
+	return makeBufferOwned(data, entry->mSize);
+}
+
+int readAssetPackFile(const std::string& tPath, std::vector<uint8_t>& oData)
+{
+	auto entry = findAssetPackEntry(tPath);
+	if (!entry) return 0;
+
+	// leaves room for a terminator, so callers can append one without reallocating
+	oData.reserve(size_t(entry->mSize) + 1);
+	oData.resize(entry->mSize);
+	return readAssetPackEntry(*entry, oData.data());
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <prism/file.h>
+
+int mountAssetPack(const char* tPath);
+void unmountAssetPack();
+int isAssetPackMounted();
+
+int hasAssetPackFile(const std::string& tPath);
+int isAssetPackFileZeroCopy(const std::string& tPath);
+Buffer getAssetPackFileBuffer(const std::string& tPath);
+int readAssetPackFile(const std::string& tPath, std::vector<uint8_t>& oData);
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+// Layout of the single-file asset archive written by tools/assetpack.
+// All integers are little endian, which matches every platform the game ships on.
+//
+// AssetPackHeader
+// AssetPackEntry[mEntryAmount], sorted by lowercase path
+// path table, mPathTableSize bytes of non-terminated lowercase paths
+// entry data, each entry starting at a multiple of ASSET_PACK_ALIGNMENT
+// Uncompressed entries are followed by a zero byte, so their slice of the mapping can be parsed as text in place.
+
+#define ASSET_PACK_MAGIC "YRPK"
+#define ASSET_PACK_VERSION 2
+#define ASSET_PACK_ALIGNMENT 32
+
+enum AssetPackCompression {
+	ASSET_PACK_COMPRESSION_NONE = 0,
+	ASSET_PACK_COMPRESSION_LZ = 1,
+};
+
+struct AssetPackHeader {
+	char mMagic[4];
+	uint32_t mVersion;
+	uint32_t mEntryAmount;
+	uint32_t mPathTableSize;
+};
+
+struct AssetPackEntry {
+	uint32_t mPathOffset;
+	uint32_t mPathLength;
+	uint32_t mDataOffset;
+	uint32_t mStoredSize;
+	uint32_t mSize;
+	uint32_t mCompression;
+};
+
+// LZ4-style block: a token with literal length (high nibble) and match length - 4 (low nibble),
+// both extended by 255-bytes when the nibble is 15, then the literals, then a 16-bit match offset.
+// The last sequence only has literals.
+static inline int decompressAssetPackLZ(const uint8_t* tSrc, uint32_t tSrcSize, uint8_t* tDst, uint32_t tDstSize) {
+	const uint8_t* src = tSrc;
+	const uint8_t* srcEnd = tSrc + tSrcSize;
+	uint8_t* dst = tDst;
+	uint8_t* dstEnd = tDst + tDstSize;
+
+	while (src < srcEnd) {
+		const uint8_t token = *src++;
+
+		uint32_t literalLength = token >> 4;
+		if (literalLength == 15) {
+			uint8_t extra;
+			do {
+				if (src >= srcEnd) return 0;
+				extra = *src++;
+				literalLength += extra;
+			} while (extra == 255);
+		}
+		if (uint32_t(srcEnd - src) < literalLength || uint32_t(dstEnd - dst) < literalLength) return 0;
+		for (uint32_t i = 0; i < literalLength; i++) *dst++ = *src++;
+
+		if (src >= srcEnd) break;
+
+		if (srcEnd - src < 2) return 0;
+		const uint32_t offset = src[0] | (src[1] << 8);
+		src += 2;
+		if (!offset || offset > uint32_t(dst - tDst)) return 0;
+
+		uint32_t matchLength = (token & 15) + 4;
+		if ((token & 15) == 15) {
+			uint8_t extra;
+			do {
+				if (src >= srcEnd) return 0;
+				extra = *src++;
+				matchLength += extra;
+			} while (extra == 255);
+		}
+		if (uint32_t(dstEnd - dst) < matchLength) return 0;
+		const uint8_t* match = dst - offset;
+		for (uint32_t i = 0; i < matchLength; i++) *dst++ = *match++;
+	}
+
+	return dst == dstEnd;
+}
+
+static inline void writeAssetPackLZLength(std::vector<uint8_t>& oOut, uint32_t tLength) {
+	while (tLength >= 255) {
+		oOut.push_back(255);
+		tLength -= 255;
+	}
+	oOut.push_back(uint8_t(tLength));
+}
+
+static inline void writeAssetPackLZSequence(std::vector<uint8_t>& oOut, const uint8_t* tLiterals, uint32_t tLiteralLength, uint32_t tOffset, uint32_t tMatchLength) {
+	const uint32_t matchCode = tMatchLength ? tMatchLength - 4 : 0;
+	oOut.push_back(uint8_t((std::min(tLiteralLength, 15u) << 4) | std::min(matchCode, 15u)));
+	if (tLiteralLength >= 15) writeAssetPackLZLength(oOut, tLiteralLength - 15);
+	oOut.insert(oOut.end(), tLiterals, tLiterals + tLiteralLength);
+	if (!tMatchLength) return;
+
+	oOut.push_back(uint8_t(tOffset & 0xFF));
+	oOut.push_back(uint8_t(tOffset >> 8));
+	if (matchCode >= 15) writeAssetPackLZLength(oOut, matchCode - 15);
+}
+
+// Greedy single-probe hash matcher for the block format above, used by the host tools.
+static inline std::vector<uint8_t> compressAssetPackLZ(const std::vector<uint8_t>& tData) {
+	const int hashBits = 14;
+	std::vector<int> hashTable(1 << hashBits, -1);
+	std::vector<uint8_t> out;
+
+	const uint32_t size = uint32_t(tData.size());
+	uint32_t literalStart = 0;
+	uint32_t position = 0;
+	while (size >= 12 && position + 12 <= size) {
+		uint32_t sequence;
+		memcpy(&sequence, &tData[position], 4);
+		const uint32_t hash = (sequence * 2654435761u) >> (32 - hashBits);
+		const int candidate = hashTable[hash];
+		hashTable[hash] = int(position);
+
+		if (candidate < 0 || position - candidate > 0xFFFF || memcmp(&tData[candidate], &tData[position], 4)) {
+			position++;
+			continue;
+		}
+
+		uint32_t matchLength = 4;
+		while (position + matchLength + 5 < size && tData[candidate + matchLength] == tData[position + matchLength]) matchLength++;
+
+		writeAssetPackLZSequence(out, &tData[literalStart], position - literalStart, position - candidate, matchLength);
+		position += matchLength;
+		literalStart = position;
+	}
+
+	writeAssetPackLZSequence(out, tData.data() + literalStart, size - literalStart, 0, 0);
+	return out;
+}
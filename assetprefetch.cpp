@@ -0,0 +1,215 @@
+#include "assetprefetch.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <prism/memoryhandler.h>
+#include <prism/log.h>
+
+#include "assetpack.h"
+#include "spritecache.h"
+
+using namespace std;
+
+// Reads asset files into memory on a worker thread so a later load only has to parse them.
+// The worker only does plain file I/O; everything that touches Prism state stays on the main thread.
+// Files inside the mounted asset pack are read (and decompressed) from the pack instead.
+// Every file is read with a terminating zero byte for the text parsers. A taken file hands out its storage without a copy,
+// so its buffer has to be given back with freePrefetchedAssetFile instead of freeBuffer.
+
+struct PrefetchedFile {
+	string mPath;
+	string mFullPath;
+	vector<uint8_t> mData;
+	int mIsDone = 0;
+	int mIsValid = 0;
+};
+
+typedef shared_ptr<PrefetchedFile> PrefetchedFilePtr;
+
+static struct {
+	map<string, PrefetchedFilePtr> mFiles;
+	deque<PrefetchedFilePtr> mQueue;
+	map<const void*, PrefetchedFilePtr> mTakenFiles;
+
+	mutex mMutex;
+	condition_variable mQueueCondition;
+	condition_variable mDoneCondition;
+	int mHasWorker = 0;
+} gAssetPrefetch;
+
+static void readPrefetchedFile(PrefetchedFile& tFile) {
+	vector<uint8_t> data;
+	int isValid = 0;
+
+	FILE* file = nullptr;
+	if (hasAssetPackFile(tFile.mPath)) {
+		isValid = readAssetPackFile(tFile.mPath, data);
+	}
+	else {
+		file = fopen(tFile.mFullPath.data(), "rb");
+	}
+	if (file) {
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (size > 0) {
+			data.reserve(size_t(size) + 1);
+			data.resize(size);
+			isValid = fread(data.data(), 1, size, file) == size_t(size);
+		}
+		fclose(file);
+	}
+	data.push_back('\0');
+
+	lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+	tFile.mData = move(data);
+	tFile.mIsValid = isValid;
+	tFile.mIsDone = 1;
+	gAssetPrefetch.mDoneCondition.notify_all();
+}
+
+static void prefetchWorker() {
+	while (true) {
+		PrefetchedFilePtr file;
+		{
+			unique_lock<mutex> lock(gAssetPrefetch.mMutex);
+			gAssetPrefetch.mQueueCondition.wait(lock, [] { return !gAssetPrefetch.mQueue.empty(); });
+			file = gAssetPrefetch.mQueue.front();
+			gAssetPrefetch.mQueue.pop_front();
+		}
+		readPrefetchedFile(*file);
+	}
+}
+
+void prefetchAssetFile(const std::string& tPath)
+{
+	if (isAssetPackFileZeroCopy(tPath)) return;
+
+	char fullPath[1024];
+	getFullPath(fullPath, tPath.data());
+
+	auto file = make_shared<PrefetchedFile>();
+	file->mPath = tPath;
+	file->mFullPath = fullPath;
+
+	{
+		lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+		if (gAssetPrefetch.mFiles.count(tPath)) return;
+		gAssetPrefetch.mFiles[tPath] = file;
+	}
+
+#ifdef __EMSCRIPTEN__
+	readPrefetchedFile(*file);
+#else
+	lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+	if (!gAssetPrefetch.mHasWorker) {
+		thread(prefetchWorker).detach();
+		gAssetPrefetch.mHasWorker = 1;
+	}
+	gAssetPrefetch.mQueue.push_back(file);
+	gAssetPrefetch.mQueueCondition.notify_one();
+#endif
+}
+
+int isAssetFilePrefetchQueued(const std::string& tPath)
+{
+	lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+	return gAssetPrefetch.mFiles.count(tPath) != 0;
+}
+
+int isAssetFilePrefetched(const std::string& tPath)
+{
+	if (isAssetPackFileZeroCopy(tPath)) return 1;
+
+	lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+	auto it = gAssetPrefetch.mFiles.find(tPath);
+	return it != gAssetPrefetch.mFiles.end() && it->second->mIsDone;
+}
+
+Buffer takePrefetchedAssetFile(const std::string& tPath)
+{
+	PrefetchedFilePtr file;
+	{
+		unique_lock<mutex> lock(gAssetPrefetch.mMutex);
+		auto it = gAssetPrefetch.mFiles.find(tPath);
+		if (it != gAssetPrefetch.mFiles.end()) {
+			file = it->second;
+			gAssetPrefetch.mDoneCondition.wait(lock, [&file] { return file->mIsDone != 0; });
+			gAssetPrefetch.mFiles.erase(it);
+		}
+	}
+
+	if (!file || !file->mIsValid) {
+		if (file) logWarningFormat("Prefetching %s failed, loading it directly.", tPath.data());
+		return getAssetPackFileBuffer(tPath);
+	}
+
+	Buffer ret = makeBuffer(file->mData.data(), uint32_t(file->mData.size() - 1));
+	lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+	gAssetPrefetch.mTakenFiles[ret.mData] = file;
+	return ret;
+}
+
+// Buffers that were not prefetched are read directly and owned, those are freed as usual.
+void freePrefetchedAssetFile(Buffer tBuffer)
+{
+	{
+		lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+		if (gAssetPrefetch.mTakenFiles.erase(tBuffer.mData)) return;
+	}
+	freeBuffer(tBuffer);
+}
+
+// Called when a game starts and when it returns to the menu, so speculative files nobody loaded do not stay in memory.
+// A file the worker is still reading is only referenced by the worker afterwards and freed when it is done.
+void discardPrefetchedAssetFiles()
+{
+	lock_guard<mutex> lock(gAssetPrefetch.mMutex);
+	gAssetPrefetch.mFiles.clear();
+	gAssetPrefetch.mQueue.clear();
+}
+
+static int isLoadedFromBuffer(const std::string& tPath) {
+	return isAssetFilePrefetchQueued(tPath) || hasAssetPackFile(tPath);
+}
+
+MugenSpriteFile loadPrefetchedMugenSpriteFileWithoutPalette(const std::string& tPath)
+{
+	if (!isLoadedFromBuffer(tPath) && !isDecodedSpriteCacheEnabled()) return loadMugenSpriteFileWithoutPalette(tPath);
+
+	Buffer buffer = takePrefetchedAssetFile(tPath);
+	MugenSpriteFile ret = loadMugenSpriteFileWithDecodedSpriteCache(tPath, buffer);
+	freePrefetchedAssetFile(buffer);
+	return ret;
+}
+
+MugenAnimations loadPrefetchedMugenAnimationFile(const std::string& tPath)
+{
+	if (!isLoadedFromBuffer(tPath)) return loadMugenAnimationFile(tPath);
+
+	Buffer buffer = takePrefetchedAssetFile(tPath);
+	MugenAnimations ret = loadMugenAnimationFileFromBuffer(buffer);
+	freePrefetchedAssetFile(buffer);
+	return ret;
+}
+
+void loadPrefetchedMugenDefScript(MugenDefScript* oScript, const std::string& tPath)
+{
+	if (!isLoadedFromBuffer(tPath)) {
+		loadMugenDefScript(oScript, tPath.data());
+		return;
+	}
+
+	Buffer buffer = takePrefetchedAssetFile(tPath);
+	loadMugenDefScriptFromBufferAndFreeBuffer(oScript, buffer);
+	if (!buffer.mIsOwned) freePrefetchedAssetFile(buffer);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <prism/file.h>
+#include <prism/mugendefreader.h>
+#include <prism/mugenspritefilereader.h>
+#include <prism/mugenanimationreader.h>
+
+void prefetchAssetFile(const std::string& tPath);
+int isAssetFilePrefetchQueued(const std::string& tPath);
+int isAssetFilePrefetched(const std::string& tPath);
+Buffer takePrefetchedAssetFile(const std::string& tPath);
+void freePrefetchedAssetFile(Buffer tBuffer);
+void discardPrefetchedAssetFiles();
+
+MugenSpriteFile loadPrefetchedMugenSpriteFileWithoutPalette(const std::string& tPath);
+MugenAnimations loadPrefetchedMugenAnimationFile(const std::string& tPath);
+void loadPrefetchedMugenDefScript(MugenDefScript* oScript, const std::string& tPath);
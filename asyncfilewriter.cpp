@@ -0,0 +1,84 @@
+#include "asyncfilewriter.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Writes a file on its own thread, for the recordings that are appended to every frame while playing.
+// Appending only collects the data on the calling thread. A flush hands it to the writer thread,
+// which writes and flushes the file, so the game never waits on the disk.
+
+struct AsyncFileWriter {
+	FILE* mFile;
+	vector<uint8_t> mPending;
+
+	thread mThread;
+	mutex mMutex;
+	condition_variable mCondition;
+	vector<uint8_t> mQueue;
+	int mIsStopping = 0;
+};
+
+static void writeAsyncFileQueue(AsyncFileWriter* tWriter) {
+	unique_lock<mutex> lock(tWriter->mMutex);
+	while (true) {
+		tWriter->mCondition.wait(lock, [tWriter] { return !tWriter->mQueue.empty() || tWriter->mIsStopping; });
+		vector<uint8_t> data;
+		data.swap(tWriter->mQueue);
+		const int isStopping = tWriter->mIsStopping;
+		lock.unlock();
+		if (!data.empty()) {
+			fwrite(data.data(), 1, data.size(), tWriter->mFile);
+			fflush(tWriter->mFile);
+		}
+		lock.lock();
+		if (isStopping && tWriter->mQueue.empty()) break;
+	}
+}
+
+AsyncFileWriter* openAsyncFileWriter(const std::string& tPath)
+{
+	FILE* file = fopen(tPath.data(), "wb");
+	if (!file) return NULL;
+
+	AsyncFileWriter* writer = new AsyncFileWriter();
+	writer->mFile = file;
+	writer->mThread = thread(writeAsyncFileQueue, writer);
+	return writer;
+}
+
+void appendAsyncFileWriter(AsyncFileWriter* tWriter, const void* tData, size_t tSize)
+{
+	const uint8_t* data = (const uint8_t*)tData;
+	tWriter->mPending.insert(tWriter->mPending.end(), data, data + tSize);
+}
+
+void flushAsyncFileWriter(AsyncFileWriter* tWriter)
+{
+	if (tWriter->mPending.empty()) return;
+	{
+		lock_guard<mutex> lock(tWriter->mMutex);
+		tWriter->mQueue.insert(tWriter->mQueue.end(), tWriter->mPending.begin(), tWriter->mPending.end());
+	}
+	tWriter->mPending.clear();
+	tWriter->mCondition.notify_one();
+}
+
+void closeAsyncFileWriter(AsyncFileWriter* tWriter)
+{
+	flushAsyncFileWriter(tWriter);
+	{
+		lock_guard<mutex> lock(tWriter->mMutex);
+		tWriter->mIsStopping = 1;
+	}
+	tWriter->mCondition.notify_one();
+	tWriter->mThread.join();
+	fclose(tWriter->mFile);
+	delete tWriter;
+}
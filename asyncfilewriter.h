@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+struct AsyncFileWriter;
+
+AsyncFileWriter* openAsyncFileWriter(const std::string& tPath);
+void appendAsyncFileWriter(AsyncFileWriter* tWriter, const void* tData, size_t tSize);
+void flushAsyncFileWriter(AsyncFileWriter* tWriter);
+void closeAsyncFileWriter(AsyncFileWriter* tWriter);
@@ -0,0 +1,401 @@
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <prism/log.h>
+#include <prism/wrapper.h>
+
+#include "allocationtracker.h"
+#include "boss.h"
+#include "debug.h"
+#include "gameinput.h"
+#include "gamescreen.h"
+#include "gimmickstats.h"
+#include "headless.h"
+#include "level.h"
+#include "player.h"
+#include "replay.h"
+#include "shothandler.h"
+
+using namespace std;
+
+// Stress benchmark that jumps straight into the heaviest boss phases, see gBenchmarkScenarios.
+// Started with --benchmark all|NAME[,NAME...] [--frames N] [--seed N] [--player NAME] [--input FILE] [--report FILE]
+// [--baseline FILE] [--tolerance PERCENT], usually together with --headless so drawing is not measured.
+// Every scenario restarts the game screen on the level of its boss, skips the level script past the boss and starts the boss
+// at the given stage and spell card. The player is invincible, so deaths do not clear the bullets halfway through.
+// The report has one line per scenario, so a report stored from an earlier run can be read back as the baseline.
+// Every metric that ends up more than the tolerance above its baseline value is a regression. Timings only compare
+// between runs on the same machine.
+
+#define BENCHMARK_DEFAULT_TOLERANCE 10.0
+
+struct BenchmarkScenario {
+	const char* mName;
+	int mLevel;
+	const char* mBoss;
+	int mStage;
+	int mSpellCard;
+	int mLife;
+	int mFrameAmount;
+};
+
+static const BenchmarkScenario gBenchmarkScenarios[] = {
+	{ "ausmoot_s3", 2, "AusMoot", 2, 1, 1400, 900 },
+	{ "shii_s5", 3, "Shii", 4, 0, 2000, 1800 },
+	{ "hiro_s6", 4, "Hiro", 5, 0, 2000, 1800 },
+	{ "crisis_s7", 4, "Crisis", 0, 0, 1000, 1800 },
+	{ "moot_s9", 5, "Moot", 8, 0, 3000, 1800 },
+};
+
+enum BenchmarkMetric {
+	BENCHMARK_METRIC_UPDATE_MEAN,
+	BENCHMARK_METRIC_UPDATE_P99,
+	BENCHMARK_METRIC_UPDATE_MAX,
+	BENCHMARK_METRIC_PEAK_SHOTS,
+	BENCHMARK_METRIC_ALLOCATIONS_PER_FRAME,
+	BENCHMARK_METRIC_ALLOCATED_BYTES_PER_FRAME,
+	BENCHMARK_METRIC_HEAP_PEAK_BYTES,
+	BENCHMARK_METRIC_AMOUNT,
+};
+
+struct BenchmarkMetricInfo {
+	const char* mName;
+	const char* mFormat;
+	int mIsCompared;
+};
+
+static const BenchmarkMetricInfo gBenchmarkMetrics[BENCHMARK_METRIC_AMOUNT] = {
+	{ "update_ms_mean", "%.4f", 1 },
+	{ "update_ms_p99", "%.4f", 1 },
+	{ "update_ms_max", "%.4f", 0 },
+	{ "peak_shots", "%.0f", 1 },
+	{ "allocations_per_frame", "%.2f", 1 },
+	{ "allocated_bytes_per_frame", "%.1f", 1 },
+	{ "heap_peak_bytes", "%.0f", 1 },
+};
+
+struct BenchmarkResult {
+	string mName;
+	int mFrameAmount;
+	double mMetrics[BENCHMARK_METRIC_AMOUNT];
+};
+
+struct BenchmarkRegression {
+	string mScenario;
+	int mMetric;
+	double mBaseline;
+	double mValue;
+};
+
+static struct {
+	int mIsActive = 0;
+	vector<const BenchmarkScenario*> mScenarios;
+	int mFrameAmountOverride = 0;
+	unsigned int mSeed = 0;
+	string mPlayerName = "AEROLITE";
+	string mInputPath;
+	string mReportPath;
+	string mBaselinePath;
+	double mTolerance = BENCHMARK_DEFAULT_TOLERANCE;
+
+	size_t mCurrentScenario;
+	vector<BenchmarkResult> mResults;
+	vector<BenchmarkRegression> mRegressions;
+
+	int mFrame;
+	int mIsScenarioOver;
+	chrono::steady_clock::time_point mLastUpdateTime;
+	int mHasDrawn;
+	AllocationStats mLastAllocations;
+	vector<double> mFrameTimes;
+	uint64_t mAllocationAmount;
+	uint64_t mAllocatedBytes;
+	int mPeakShotAmount;
+} gBenchmark;
+
+static void addBenchmarkScenarios(const string& tNames) {
+	stringstream ss(tNames);
+	string name;
+	while (getline(ss, name, ',')) {
+		int isFound = 0;
+		for (const auto& scenario : gBenchmarkScenarios) {
+			if (name != "all" && name != scenario.mName) continue;
+			gBenchmark.mScenarios.push_back(&scenario);
+			isFound = 1;
+		}
+		if (!isFound) logWarningFormat("Unknown benchmark scenario %s.", name.data());
+	}
+}
+
+int parseBenchmarkArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) {
+		const int hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--benchmark") && hasValue) {
+			gBenchmark.mIsActive = 1;
+			addBenchmarkScenarios(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--frames") && hasValue) gBenchmark.mFrameAmountOverride = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && hasValue) gBenchmark.mSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (!strcmp(argv[i], "--player") && hasValue) gBenchmark.mPlayerName = argv[++i];
+		else if (!strcmp(argv[i], "--input") && hasValue) gBenchmark.mInputPath = argv[++i];
+		else if (!strcmp(argv[i], "--report") && hasValue) gBenchmark.mReportPath = argv[++i];
+		else if (!strcmp(argv[i], "--baseline") && hasValue) gBenchmark.mBaselinePath = argv[++i];
+		else if (!strcmp(argv[i], "--tolerance") && hasValue) gBenchmark.mTolerance = atof(argv[++i]);
+	}
+	return gBenchmark.mIsActive;
+}
+
+int isBenchmarkActive()
+{
+	return gBenchmark.mIsActive;
+}
+
+static const BenchmarkScenario& getCurrentBenchmarkScenario() {
+	return *gBenchmark.mScenarios[gBenchmark.mCurrentScenario];
+}
+
+static int getBenchmarkFrameAmount(const BenchmarkScenario& tScenario) {
+	return gBenchmark.mFrameAmountOverride ? gBenchmark.mFrameAmountOverride : tScenario.mFrameAmount;
+}
+
+static void prepareBenchmarkScenario() {
+	setPlayerName(gBenchmark.mPlayerName);
+	if (gBenchmark.mInputPath.empty() || !loadGameInputScript(gBenchmark.mInputPath)) setGameInputIdle();
+	setNextGameSeed(gBenchmark.mSeed);
+	resetGameAtLevel(getCurrentBenchmarkScenario().mLevel);
+}
+
+void startBenchmarks()
+{
+	if (gBenchmark.mScenarios.empty()) return;
+
+	gGameVars.invinciblePlayer = 1;
+	setAllocationTrackingActive(1);
+	gBenchmark.mCurrentScenario = 0;
+	gBenchmark.mResults.clear();
+	gBenchmark.mRegressions.clear();
+	prepareBenchmarkScenario();
+	startScreenHandling(getGameScreen());
+}
+
+int hasBenchmarkRegressions()
+{
+	return !gBenchmark.mRegressions.empty();
+}
+
+static int findBenchmarkValue(const string& tLine, const char* tKey, size_t& oPosition) {
+	const string key = string("\"") + tKey + "\": ";
+	oPosition = tLine.find(key);
+	if (oPosition == string::npos) return 0;
+	oPosition += key.size();
+	return 1;
+}
+
+static vector<BenchmarkResult> loadBenchmarkBaseline(const string& tPath) {
+	vector<BenchmarkResult> ret;
+	ifstream file(tPath);
+	if (!file) {
+		logWarningFormat("Unable to open benchmark baseline %s.", tPath.data());
+		return ret;
+	}
+
+	string line;
+	while (getline(file, line)) {
+		size_t position;
+		if (!findBenchmarkValue(line, "name", position) || line[position] != '"') continue;
+
+		BenchmarkResult result;
+		result.mName = line.substr(position + 1, line.find('"', position + 1) - position - 1);
+		result.mFrameAmount = findBenchmarkValue(line, "frames", position) ? atoi(line.data() + position) : 0;
+		int isComplete = 1;
+		for (int i = 0; i < BENCHMARK_METRIC_AMOUNT; i++) {
+			if (findBenchmarkValue(line, gBenchmarkMetrics[i].mName, position)) result.mMetrics[i] = atof(line.data() + position);
+			else isComplete = 0;
+		}
+		if (isComplete) ret.push_back(result);
+	}
+	return ret;
+}
+
+static void compareBenchmarkBaseline() {
+	if (gBenchmark.mBaselinePath.empty()) return;
+
+	const auto baseline = loadBenchmarkBaseline(gBenchmark.mBaselinePath);
+	const double factor = 1 + gBenchmark.mTolerance / 100.0;
+	for (const auto& result : gBenchmark.mResults) {
+		auto previous = find_if(baseline.begin(), baseline.end(), [&result](const BenchmarkResult& tEntry) { return tEntry.mName == result.mName; });
+		if (previous == baseline.end()) continue;
+		if (previous->mFrameAmount != result.mFrameAmount) {
+			logWarningFormat("Benchmark %s ran %d frames, the baseline %d, not compared.", result.mName.data(), result.mFrameAmount, previous->mFrameAmount);
+			continue;
+		}
+
+		for (int i = 0; i < BENCHMARK_METRIC_AMOUNT; i++) {
+			if (!gBenchmarkMetrics[i].mIsCompared || result.mMetrics[i] <= previous->mMetrics[i] * factor) continue;
+			gBenchmark.mRegressions.push_back(BenchmarkRegression{ result.mName, i, previous->mMetrics[i], result.mMetrics[i] });
+			logWarningFormat("Benchmark %s regressed in %s: %f, baseline %f.", result.mName.data(), gBenchmarkMetrics[i].mName, result.mMetrics[i], previous->mMetrics[i]);
+		}
+	}
+}
+
+static void writeBenchmarkReport(FILE* tFile) {
+	fprintf(tFile, "{\n");
+	fprintf(tFile, "\t\"seed\": %u,\n", gBenchmark.mSeed);
+	fprintf(tFile, "\t\"player\": \"%s\",\n", gBenchmark.mPlayerName.data());
+	fprintf(tFile, "\t\"headless\": %d,\n", isHeadless());
+	fprintf(tFile, "\t\"allocation_tracking\": %d,\n", isAllocationTrackingAvailable());
+	fprintf(tFile, "\t\"scenarios\": [\n");
+	for (size_t i = 0; i < gBenchmark.mResults.size(); i++) {
+		const auto& result = gBenchmark.mResults[i];
+		fprintf(tFile, "\t\t{ \"name\": \"%s\", \"frames\": %d", result.mName.data(), result.mFrameAmount);
+		for (int j = 0; j < BENCHMARK_METRIC_AMOUNT; j++) {
+			fprintf(tFile, ", \"%s\": ", gBenchmarkMetrics[j].mName);
+			fprintf(tFile, gBenchmarkMetrics[j].mFormat, result.mMetrics[j]);
+		}
+		fprintf(tFile, " }%s\n", i + 1 < gBenchmark.mResults.size() ? "," : "");
+	}
+	fprintf(tFile, "\t],\n");
+	fprintf(tFile, "\t\"tolerance_percent\": %.1f,\n", gBenchmark.mTolerance);
+	fprintf(tFile, "\t\"regressions\": [\n");
+	for (size_t i = 0; i < gBenchmark.mRegressions.size(); i++) {
+		const auto& regression = gBenchmark.mRegressions[i];
+		fprintf(tFile, "\t\t{ \"scenario\": \"%s\", \"metric\": \"%s\", \"baseline\": %f, \"value\": %f }%s\n", regression.mScenario.data(), gBenchmarkMetrics[regression.mMetric].mName, regression.mBaseline, regression.mValue, i + 1 < gBenchmark.mRegressions.size() ? "," : "");
+	}
+	fprintf(tFile, "\t]\n");
+	fprintf(tFile, "}\n");
+}
+
+static void finishBenchmarks() {
+	setAllocationTrackingActive(0);
+	compareBenchmarkBaseline();
+
+	writeBenchmarkReport(stdout);
+	if (!gBenchmark.mReportPath.empty()) {
+		FILE* file = fopen(gBenchmark.mReportPath.data(), "w");
+		if (file) {
+			writeBenchmarkReport(file);
+			fclose(file);
+		}
+		else {
+			logWarningFormat("Unable to write benchmark report %s.", gBenchmark.mReportPath.data());
+		}
+	}
+	abortScreenHandling();
+}
+
+static void addBenchmarkResult() {
+	const auto& times = gBenchmark.mFrameTimes;
+	double total = 0, maximum = 0;
+	for (auto time : times) {
+		total += time;
+		maximum = std::max(maximum, time);
+	}
+	// Every update after the first is a measured frame, the timing leaves out the ones spanning a draw.
+	const int measuredFrameAmount = std::max(gBenchmark.mFrame - 1, 0);
+	const double frameAmount = std::max(1.0, double(measuredFrameAmount));
+
+	BenchmarkResult result;
+	result.mName = getCurrentBenchmarkScenario().mName;
+	result.mFrameAmount = measuredFrameAmount;
+	result.mMetrics[BENCHMARK_METRIC_UPDATE_MEAN] = times.empty() ? 0 : total / times.size();
+	result.mMetrics[BENCHMARK_METRIC_UPDATE_P99] = getFrameTimePercentile(times, 0.99);
+	result.mMetrics[BENCHMARK_METRIC_UPDATE_MAX] = maximum;
+	result.mMetrics[BENCHMARK_METRIC_PEAK_SHOTS] = gBenchmark.mPeakShotAmount;
+	result.mMetrics[BENCHMARK_METRIC_ALLOCATIONS_PER_FRAME] = gBenchmark.mAllocationAmount / frameAmount;
+	result.mMetrics[BENCHMARK_METRIC_ALLOCATED_BYTES_PER_FRAME] = gBenchmark.mAllocatedBytes / frameAmount;
+	result.mMetrics[BENCHMARK_METRIC_HEAP_PEAK_BYTES] = double(getAllocationStats().mPeakLiveBytes);
+	gBenchmark.mResults.push_back(result);
+}
+
+static void finishBenchmarkScenario() {
+	if (gBenchmark.mIsScenarioOver) return;
+	gBenchmark.mIsScenarioOver = 1;
+
+	addBenchmarkResult();
+	gBenchmark.mCurrentScenario++;
+	if (gBenchmark.mCurrentScenario < gBenchmark.mScenarios.size()) {
+		prepareBenchmarkScenario();
+		setNewScreen(getGameScreen());
+	}
+	else {
+		finishBenchmarks();
+	}
+}
+
+static void startBenchmarkScenario() {
+	const auto& scenario = getCurrentBenchmarkScenario();
+	if (!skipLevelToBoss(scenario.mBoss) || !startBossAtPhase(scenario.mBoss, scenario.mStage, scenario.mSpellCard, scenario.mLife)) {
+		logWarningFormat("Unable to start benchmark scenario %s.", scenario.mName);
+	}
+	resetAllocationPeak();
+}
+
+static void loadBenchmarkRunner(void* tData) {
+	(void)tData;
+	gBenchmark.mFrame = 0;
+	gBenchmark.mIsScenarioOver = 0;
+	gBenchmark.mFrameTimes.clear();
+	gBenchmark.mFrameTimes.reserve(getBenchmarkFrameAmount(getCurrentBenchmarkScenario()));
+	gBenchmark.mAllocationAmount = 0;
+	gBenchmark.mAllocatedBytes = 0;
+	gBenchmark.mPeakShotAmount = 0;
+	setGimmickStatsRunName(string("benchmark ") + getCurrentBenchmarkScenario().mName);
+}
+
+static void unloadBenchmarkRunner(void* tData) {
+	(void)tData;
+	if (gBenchmark.mIsScenarioOver) return;
+
+	logWarningFormat("Benchmark scenario %s left the game screen early.", getCurrentBenchmarkScenario().mName);
+	gBenchmark.mIsScenarioOver = 1;
+	addBenchmarkResult();
+	finishBenchmarks();
+}
+
+static void updateBenchmarkRunner(void* tData) {
+	(void)tData;
+	if (gBenchmark.mIsScenarioOver) return;
+
+	if (!gBenchmark.mFrame) {
+		startBenchmarkScenario();
+	}
+	else {
+		const auto now = chrono::steady_clock::now();
+		const auto allocations = getAllocationStats();
+		if (!gBenchmark.mHasDrawn) gBenchmark.mFrameTimes.push_back(chrono::duration<double, milli>(now - gBenchmark.mLastUpdateTime).count());
+		gBenchmark.mAllocationAmount += allocations.mAllocationAmount - gBenchmark.mLastAllocations.mAllocationAmount;
+		gBenchmark.mAllocatedBytes += allocations.mAllocatedBytes - gBenchmark.mLastAllocations.mAllocatedBytes;
+		gBenchmark.mPeakShotAmount = std::max(gBenchmark.mPeakShotAmount, getActiveShotAmount());
+	}
+
+	gBenchmark.mFrame++;
+	if (gBenchmark.mFrame > getBenchmarkFrameAmount(getCurrentBenchmarkScenario())) {
+		finishBenchmarkScenario();
+		return;
+	}
+	gBenchmark.mLastAllocations = getAllocationStats();
+	gBenchmark.mLastUpdateTime = chrono::steady_clock::now();
+	gBenchmark.mHasDrawn = 0;
+}
+
+// Headless runs draw once per batch of updates. The sample that spans that draw and its vsync wait is not counted as a frame time.
+static void drawBenchmarkRunner(void* tData) {
+	(void)tData;
+	if (isHeadless()) gBenchmark.mHasDrawn = 1;
+}
+
+ActorBlueprint getBenchmarkRunner()
+{
+	return makeActorBlueprint(loadBenchmarkRunner, unloadBenchmarkRunner, updateBenchmarkRunner, drawBenchmarkRunner);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <prism/actorhandler.h>
+
+int parseBenchmarkArguments(int argc, char** argv);
+int isBenchmarkActive();
+void startBenchmarks();
+int hasBenchmarkRegressions();
+
+ActorBlueprint getBenchmarkRunner();
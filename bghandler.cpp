@@ -2,10 +2,17 @@
 
 #include <prism/blitz.h>
 #include <memory>
+#include <set>
 #include "level.h"
 #include "debug.h"
 
 #define BG_Z 1
+#define BG_BRIGHTNESS 0.7
+
+// The background is dimmed so the shots stay readable. Darkening the sprites when they are uploaded
+// gives the same image as a black overlay with 1 - BG_BRIGHTNESS alpha, without blending every screen pixel each frame.
+// The overlay used to sit at BG_Z + 2, so every level animation drawn below that layer has to be darkened the same way,
+// which is what darkenBackgroundLayerAnimation is for. The overlay is only used when the level sprites could not be darkened.
 
 struct BGHandler {
 
@@ -13,12 +20,47 @@ struct BGHandler {
 	int mBlitzEntity2;
 	Vector3DI mSize;
 
+	std::set<int> mDarkenedAnimations;
+	int mHasOverlay = 0;
 	TextureData mWhiteTexture;
 	int blackAnimationID;
 
 	BGHandler(){
+		addBackgroundEntities();
+	}
+
+	void addOverlay() {
+		if (mHasOverlay) return;
+		mWhiteTexture = createWhiteTexture();
+		blackAnimationID = playOneFrameAnimationLoop(makePosition(0, 0, BG_Z + 2), &mWhiteTexture);
+		setAnimationSize(blackAnimationID, makePosition(320, 240, 1), makePosition(0, 0, 0));
+		setAnimationColor(blackAnimationID, 0, 0, 0);
+		setAnimationTransparency(blackAnimationID, 1 - BG_BRIGHTNESS);
+		mHasOverlay = 1;
+	}
+
+	void removeOverlay() {
+		if (!mHasOverlay) return;
+		removeHandledAnimation(blackAnimationID);
+		unloadTexture(mWhiteTexture);
+		mHasOverlay = 0;
+	}
+
+	void darkenAnimation(int tAnimation) {
+		if (mHasOverlay || mDarkenedAnimations.count(tAnimation)) return;
+		if (!setLevelAnimationBrightness(tAnimation, BG_BRIGHTNESS)) {
+			logWarningFormat("Unable to darken the sprites of background animation %d, using an overlay instead.", tAnimation);
+			addOverlay();
+			return;
+		}
+		mDarkenedAnimations.insert(tAnimation);
+	}
+
+	void addBackgroundEntities() {
+		darkenAnimation(1);
+
 		auto animations = getLevelAnimations();
-		auto sprites = getLevelSprites();
+		auto sprites = getLevelSpritesForAnimation(1);
 		auto animation = getMugenAnimation(animations, 1);
 		mSize = getAnimationFirstElementSpriteSize(animation, sprites);
 
@@ -34,12 +76,14 @@ struct BGHandler {
 		if (getCurrentLevel() != 4) {
 			addBlitzPhysicsVelocityY(mBlitzEntity2, 6);
 		}
+	}
 
-		mWhiteTexture = createWhiteTexture();
-		blackAnimationID = playOneFrameAnimationLoop(makePosition(0, 0, BG_Z + 2), &mWhiteTexture);
-		setAnimationSize(blackAnimationID, makePosition(320, 240, 1), makePosition(0, 0, 0));
-		setAnimationColor(blackAnimationID, 0, 0, 0);
-		setAnimationTransparency(blackAnimationID, 0.3);
+	void reload() {
+		removeBlitzEntity(mBlitzEntity1);
+		removeBlitzEntity(mBlitzEntity2);
+		removeOverlay();
+		mDarkenedAnimations.clear();
+		addBackgroundEntities();
 	}
 
 	void updateSingle(int entityID) {
@@ -57,3 +101,13 @@ struct BGHandler {
 };
 
 EXPORT_ACTOR_CLASS(BGHandler);
+
+void reloadBGHandler()
+{
+	gBGHandler->reload();
+}
+
+void darkenBackgroundLayerAnimation(int tAnimation)
+{
+	gBGHandler->darkenAnimation(tAnimation);
+}
@@ -2,4 +2,6 @@
 
 #include <prism/actorhandler.h>
 
-ActorBlueprint getBGHandler();
\ No newline at end of file
+ActorBlueprint getBGHandler();
+void reloadBGHandler();
+void darkenBackgroundLayerAnimation(int tAnimation);
\ No newline at end of file
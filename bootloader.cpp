@@ -0,0 +1,168 @@
+#include "bootloader.h"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <prism/file.h>
+#include <prism/log.h>
+
+#include "assetpack.h"
+#include "assetprefetch.h"
+#include "spritecache.h"
+#include "spritedecoder.h"
+
+using namespace std;
+
+// Reads and decodes the warning, title, UI and shot sprites on a small thread pool,
+// while the main thread initializes Prism, registers the fonts, runs the framerate select and shows the warning screen.
+// The decoded pixels are handed over through spritecache.cpp, the animation files go through the prefetcher.
+// Prism itself is only ever called from the main thread.
+
+struct BootTask {
+	string mName;
+	vector<int> mDependencies;
+	function<void()> mWork;
+	int mIsStarted = 0;
+	int mIsDone = 0;
+};
+
+static struct {
+	vector<BootTask> mTasks;
+	int mRemainingTasks = 0;
+	int mIsStarted = 0;
+
+	mutex mMutex;
+	condition_variable mCondition;
+
+	chrono::steady_clock::time_point mStartTime;
+	double mTitleAssetsTime = 0;
+	double mTasksTime = 0;
+	int mHasReportedTitle = 0;
+} gBootLoader;
+
+static double getBootTime() {
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - gBootLoader.mStartTime).count();
+}
+
+static int addBootTask(const string& tName, function<void()> tWork, const vector<int>& tDependencies = vector<int>()) {
+	BootTask task;
+	task.mName = tName;
+	task.mWork = tWork;
+	task.mDependencies = tDependencies;
+	gBootLoader.mTasks.push_back(task);
+	return int(gBootLoader.mTasks.size()) - 1;
+}
+
+static int isBootTaskRunnable(const BootTask& tTask) {
+	if (tTask.mIsStarted) return 0;
+	for (auto dependency : tTask.mDependencies) {
+		if (!gBootLoader.mTasks[dependency].mIsDone) return 0;
+	}
+	return 1;
+}
+
+static void bootWorker() {
+	unique_lock<mutex> lock(gBootLoader.mMutex);
+	while (true) {
+		BootTask* task = nullptr;
+		gBootLoader.mCondition.wait(lock, [&task] {
+			if (!gBootLoader.mRemainingTasks) return true;
+			for (auto& candidate : gBootLoader.mTasks) {
+				if (isBootTaskRunnable(candidate)) {
+					task = &candidate;
+					return true;
+				}
+			}
+			return false;
+		});
+		if (!task) return;
+
+		task->mIsStarted = 1;
+		lock.unlock();
+		task->mWork();
+		lock.lock();
+
+		task->mIsDone = 1;
+		if (!--gBootLoader.mRemainingTasks) gBootLoader.mTasksTime = getBootTime();
+		gBootLoader.mCondition.notify_all();
+	}
+}
+
+static vector<uint8_t> readBootFile(const string& tPath, const string& tFullPath) {
+	vector<uint8_t> data;
+	if (hasAssetPackFile(tPath)) {
+		readAssetPackFile(tPath, data);
+		return data;
+	}
+
+	FILE* file = fopen(tFullPath.data(), "rb");
+	if (!file) return data;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size > 0) {
+		data.resize(size);
+		if (fread(data.data(), 1, size, file) != size_t(size)) data.clear();
+	}
+	fclose(file);
+	return data;
+}
+
+// Adds a read task and a decode task that depends on it, returns the decode task.
+static int addSpriteFileTasks(const string& tPath) {
+	char fullPath[1024];
+	getFullPath(fullPath, tPath.data());
+	queueMugenSpriteFilePredecode(tPath);
+
+	auto source = make_shared<vector<uint8_t>>();
+	const string fullPathString = fullPath;
+	int readTask = addBootTask("read " + tPath, [tPath, fullPathString, source]() { *source = readBootFile(tPath, fullPathString); });
+	return addBootTask("decode " + tPath, [tPath, source]() {
+		predecodeMugenSpriteFile(tPath, *source);
+		source->clear();
+	}, { readTask });
+}
+
+void startBootLoading()
+{
+	gBootLoader.mStartTime = chrono::steady_clock::now();
+	if (!isDecodedSpriteCacheEnabled()) return;
+
+	prefetchAssetFile("title/TITLE.air");
+	prefetchAssetFile("data/UI.air");
+	prefetchAssetFile("data/SHOTS.air");
+
+	addSpriteFileTasks("title/WARNING.sff");
+	vector<int> titleTasks = { addSpriteFileTasks("title/TITLE.sff") };
+	addBootTask("title assets", []() { gBootLoader.mTitleAssetsTime = getBootTime(); }, titleTasks);
+	addSpriteFileTasks("data/UI.sff");
+	addSpriteFileTasks("data/SHOTS.sff");
+
+	gBootLoader.mRemainingTasks = int(gBootLoader.mTasks.size());
+	gBootLoader.mIsStarted = 1;
+	const int threadAmount = getSpriteDecoderThreadAmount();
+	for (int i = 0; i < threadAmount; i++) {
+		thread(bootWorker).detach();
+	}
+}
+
+void reportBootTitleInteractive()
+{
+	if (gBootLoader.mHasReportedTitle) return;
+	gBootLoader.mHasReportedTitle = 1;
+
+	if (gBootLoader.mIsStarted) {
+		lock_guard<mutex> lock(gBootLoader.mMutex);
+		if (gBootLoader.mRemainingTasks) logFormat("Boot: %d boot tasks still running.", gBootLoader.mRemainingTasks);
+		else logFormat("Boot: title assets decoded after %.1f ms, all boot tasks after %.1f ms.", gBootLoader.mTitleAssetsTime, gBootLoader.mTasksTime);
+	}
+	logFormat("Boot: title interactive after %.1f ms.", getBootTime());
+}
@@ -2,6 +2,7 @@
 
 #include <prism/blitz.h>
 
+#include "bghandler.h"
 #include "shothandler.h"
 #include "collision.h"
 #include "level.h"
@@ -11,6 +12,8 @@
 #include "enemyhandler.h"
 #include "debug.h"
 #include "player.h"
+#include "statehash.h"
+#include "profiler.h"
 
 #define BOSS_Z 20
 
@@ -40,6 +43,7 @@ struct Boss {
 	int mSurvivalTimerTextID;
 	int mSurvivalTimerID;
 	int mIsInvincible = 0;
+	int mAnimation = -1;
 
 	Boss() {
 		mEntityID = addBlitzEntity(makePosition(0,0,0));
@@ -65,6 +69,7 @@ struct Boss {
 		int id = addMugenAnimation(getMugenAnimation(getUIAnimations(), 16), getUISprites(), getBlitzEntityPosition(mEntityID) + makePosition(0, 0, 1));
 		setMugenAnimationNoLoop(id);
 		removeBlitzEntity(mEntityID);
+		if (mAnimation != -1) releaseLevelAnimationSprites(mAnimation);
 		removeMugenAnimation(mHealthBarID);
 		removeMugenAnimation(mHealthBarBGID);
 		removeMugenText(mNumberTextID);
@@ -209,8 +214,9 @@ struct Boss {
 	}
 
 	void createAtPosition(Position tPos, int tAnimation, double tRadius) {
+		mAnimation = tAnimation;
 		setBlitzEntityPosition(mEntityID, tPos);
-		addBlitzMugenAnimationComponent(mEntityID, getLevelSprites(), getLevelAnimations(), tAnimation);
+		addBlitzMugenAnimationComponent(mEntityID, getLevelSpritesForAnimation(tAnimation), getLevelAnimations(), tAnimation);
 		addBlitzCollisionComponent(mEntityID);
 		int collisionID = addBlitzCollisionCirc(mEntityID, getEnemyCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), tRadius));
 		addBlitzCollisionCB(mEntityID, collisionID, bossHitCB, NULL);
@@ -227,6 +233,14 @@ struct Boss {
 		}
 	}
 
+	void startAtPhase(int tStage, int tSpellCard, int tLife) {
+		setBlitzEntityPosition(mEntityID, makePosition(96 + 16, 62 + 8, BOSS_Z));
+		reshowHealthBar();
+		mStage = tStage - 1;
+		increaseStage(tLife);
+		mSpellCard = tSpellCard;
+	}
+
 	void startSurvival(int tSeconds) {
 		mIsInvincible = 1;
 		mTimeLeftInCard = tSeconds * 60 + 59;
@@ -260,6 +274,7 @@ static void unloadBossHandler(void* tData) {
 
 static void updateBossHandler(void* tData) {
 	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_BOSS);
 	if (!gBossData.mIsActive) return;
 
 	gBossData.mBoss->mCurrentFrame++;
@@ -491,7 +506,7 @@ struct AckBoss : Boss {
 		if (mSpellcard2Stage == 0) {
 			if (mTimeInCard == 0) {
 				mEntityID2 = addBlitzEntity(makePosition(96 + 16, 62 + 8, BOSS_Z));
-				addBlitzMugenAnimationComponent(mEntityID2, getLevelSprites(), getLevelAnimations(), 1002);
+				addBlitzMugenAnimationComponent(mEntityID2, getLevelSpritesForAnimation(1002), getLevelAnimations(), 1002);
 				addBlitzCollisionComponent(mEntityID2);
 				int collisionID = addBlitzCollisionCirc(mEntityID2, getEnemyCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), 13));
 				addBlitzCollisionCB(mEntityID2, collisionID, bossHitCB, NULL);
@@ -552,6 +567,7 @@ struct AckBoss : Boss {
 
 				if (!mLife) {
 					removeBlitzEntity(mEntityID2);
+					releaseLevelAnimationSprites(1002);
 					increaseStageAfter();
 				}
 			}
@@ -1226,13 +1242,14 @@ struct ShiiBoss : Boss {
 	Position mTarget;
 	void loadWorld() {
 		mWorldEntity = addBlitzEntity(getScreenPositionFromGamePosition(0.5, 0.1, 0));
-		addBlitzMugenAnimationComponent(mWorldEntity, getLevelSprites(), getLevelAnimations(), 1002);
+		addBlitzMugenAnimationComponent(mWorldEntity, getLevelSpritesForAnimation(1002), getLevelAnimations(), 1002);
 		addBlitzCollisionComponent(mWorldEntity);
 		addBlitzCollisionCirc(mWorldEntity, getEnemyShotCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), 30));
 	}
 
 	void unloadWorld() {
 		removeBlitzEntity(mWorldEntity);
+		releaseLevelAnimationSprites(1002);
 	}
 
 	void findWorldTarget() {
@@ -1654,7 +1671,8 @@ struct CrisisBoss : Boss {
 	void updateSpellCard7() {
 		if (mTimeInCard == 0) {
 			addShot(this, getBlitzEntityPosition(mEntityID), "crisis", getEnemyShotCollisionList());
-			mErrorEntity = addMugenAnimation(getMugenAnimation(getLevelAnimations(), 2), getLevelSprites(), makePosition(0, 0, 2));
+			darkenBackgroundLayerAnimation(2);
+			mErrorEntity = addMugenAnimation(getMugenAnimation(getLevelAnimations(), 2), getLevelSpritesForAnimation(2), makePosition(0, 0, 2));
 			setMugenAnimationTransparency(mErrorEntity, 0);
 		}
 
@@ -1672,6 +1690,8 @@ struct CrisisBoss : Boss {
 
 
 			if (!mLife) {
+				removeMugenAnimation(mErrorEntity);
+				releaseLevelAnimationSprites(2);
 				increaseStageAfter();
 			}
 
@@ -1803,6 +1823,12 @@ struct MootBoss : Boss {
 		mStageAmount = 9;
 	}
 
+	~MootBoss() {
+		if (mSnacksEntity == -1) return;
+		removeBlitzEntity(mSnacksEntity);
+		releaseLevelAnimationSprites(1003);
+	}
+
 	virtual void customCB() override {
 		if (mStage == -1) {
 			reshowHealthBar();
@@ -1852,11 +1878,11 @@ struct MootBoss : Boss {
 
 	};
 	int mCurrentTarget = 0;
-	int mSnacksEntity;
+	int mSnacksEntity = -1;
 	
 	void createSnacks() {
 		mSnacksEntity = addBlitzEntity(makePosition(96 + 16, 62 + 38, BOSS_Z));
-		addBlitzMugenAnimationComponent(mSnacksEntity, getLevelSprites(), getLevelAnimations(), 1003);
+		addBlitzMugenAnimationComponent(mSnacksEntity, getLevelSpritesForAnimation(1003), getLevelAnimations(), 1003);
 		addBlitzCollisionComponent(mSnacksEntity);
 		int collisionID = addBlitzCollisionCirc(mSnacksEntity, getEnemyCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), 12));
 		addBlitzCollisionCB(mSnacksEntity, collisionID, bossHitCB, NULL);
@@ -1956,7 +1982,7 @@ struct MootBoss : Boss {
 	int mEntity4;
 	void createNewCharacter(int& entityID, Position tPos, int tAnimation) {
 		entityID = addBlitzEntity(tPos);
-		addBlitzMugenAnimationComponent(entityID, getLevelSprites(), getLevelAnimations(), tAnimation);
+		addBlitzMugenAnimationComponent(entityID, getLevelSpritesForAnimation(tAnimation), getLevelAnimations(), tAnimation);
 		addBlitzCollisionComponent(entityID);
 		int collisionID = addBlitzCollisionCirc(entityID, getEnemyCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), 13));
 		addBlitzCollisionCB(entityID, collisionID, bossHitCB, NULL);
@@ -1981,7 +2007,9 @@ struct MootBoss : Boss {
 	{
 		int id = addMugenAnimation(getMugenAnimation(getUIAnimations(), 16), getUISprites(), getBlitzEntityPosition(tEntity) + makePosition(0, 0, 1));
 		setMugenAnimationNoLoop(id);
+		int animation = getBlitzMugenAnimationAnimationNumber(tEntity);
 		removeBlitzEntity(tEntity);
+		releaseLevelAnimationSprites(animation);
 	}
 
 	void removeCharacters()
@@ -2321,11 +2349,35 @@ void addBoss(std::string tName)
 	gBossData.mIsActive = 1;
 }
 
+int startBossAtPhase(std::string tName, int tStage, int tSpellCard, int tLife)
+{
+	addBoss(tName);
+	if (!gBossData.mIsActive) return 0;
+
+	gBossData.mBoss->startAtPhase(tStage, tSpellCard, tLife);
+	return 1;
+}
+
 int hasActiveBoss()
 {
 	return gBossData.mIsActive;
 }
 
+void addBossStateHash(StateHash& oHash)
+{
+	addStateHashInt(oHash, gBossData.mIsActive);
+	if (!gBossData.mIsActive) return;
+
+	const auto& boss = *gBossData.mBoss;
+	addStateHashPosition(oHash, getBlitzEntityPosition(boss.mEntityID));
+	addStateHashInt(oHash, boss.mCurrentFrame);
+	addStateHashInt(oHash, boss.mLife);
+	addStateHashInt(oHash, boss.mStage);
+	addStateHashInt(oHash, boss.mSpellCard);
+	addStateHashInt(oHash, boss.mTimeLeftInCard);
+	addStateHashInt(oHash, boss.mIsInvincible);
+}
+
 Position getBossPosition()
 {
 	if (!gBossData.mIsActive) return makePosition(0, 0, 0);
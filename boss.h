@@ -7,6 +7,7 @@
 ActorBlueprint getBossHandler();
 
 void addBoss(std::string tName);
+int startBossAtPhase(std::string tName, int tStage, int tSpellCard, int tLife);
 
 int hasActiveBoss();
 Position getBossPosition();
@@ -15,3 +16,6 @@ Position getAnonPosition(void* tCaller);
 void bossFinishedDialogCB();
 void addBossDamage(int tDamage);
 void introBoss(void(*tFunc)(void*), int tNow);
+
+struct StateHash;
+void addBossStateHash(StateHash& oHash);
@@ -0,0 +1,437 @@
+#include "bulletrenderer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <prism/blitz.h>
+#include <prism/drawing.h>
+#include <prism/log.h>
+#include <prism/memoryhandler.h>
+
+#include "assetpack.h"
+#include "profiler.h"
+#include "resourcecache.h"
+#include "spriteatlas.h"
+#include "spriteatlasformat.h"
+#include "spritedecoder.h"
+#include "spriterotation.h"
+
+using namespace std;
+
+// Draws all shots and items in one pass per frame from the sprite atlas instead of one animation component each.
+// The shot and item handlers register a fill function that the draw calls to rebuild their batch with position, angle,
+// animation and phase arrays, so shots spawned later in the frame are drawn in the same frame,
+// and the draw groups the bullets of each z layer by page so each page's texture is bound once per layer.
+// Animations run on one shared clock per animation that is stepped once per frame, so hundreds of bullets
+// playing the same loop cost a single animation step. A bullet with a nonzero phase is offset from that clock.
+// Only animations whose every frame is in the atlas are batched, the others keep their animation component.
+// Shot sprites are also rendered at BULLET_ROTATION_STEPS angles at load into extra pages, so an angled bullet
+// draws its nearest pre-rotated frame without a rotation. Sprites larger than BULLET_ROTATION_MAX_SIZE,
+// which are few on screen but would take most of the space, are still rotated when drawn.
+// The grouping is one draw queue bucketed by integer z layer and then page with a counting pass,
+// so the order within a bucket is the stable submission order instead of the result of comparison sorting.
+
+#define BULLET_ATLAS_PATH "data/SPRITES.atl"
+#define BULLET_ROTATION_STEPS 32
+#define BULLET_ROTATION_MAX_SIZE 32
+#define BULLET_LAYER_AMOUNT 100
+
+struct BulletAnimationFrame {
+	const SpriteAtlasRegion* mRegion;
+	int mOffsetX;
+	int mOffsetY;
+	int mDuration;
+	int mRotation;
+};
+
+struct BulletRotation {
+	SpriteAtlasRegion mRegions[BULLET_ROTATION_STEPS];
+};
+
+struct BulletAnimation {
+	vector<BulletAnimationFrame> mFrames;
+	int mLoopDuration;
+	const BulletAnimationFrame* mCurrentFrame;
+};
+
+struct BulletBatch {
+	BulletBatch(const char* tSheetPath, const char* tAnimationPath) : mSheetPath(tSheetPath), mAnimationPath(tAnimationPath), mFill(nullptr) {}
+
+	const char* mSheetPath;
+	const char* mAnimationPath;
+	void(*mFill)();
+	map<int, BulletAnimation> mAnimations;
+
+	vector<Position> mPositions;
+	vector<double> mAngles;
+	vector<int> mAnimationIDs;
+	vector<int> mPhases;
+	vector<Vector3D> mColors;
+	vector<double> mTransparencies;
+};
+
+struct BulletDrawCommand {
+	const SpriteAtlasRegion* mRegion;
+	Position mCenter;
+	double mAngle;
+	Vector3D mColor;
+	double mTransparency;
+	int mPage;
+	int mBucket;
+};
+
+static struct {
+	SpriteAtlas* mAtlas;
+	vector<TextureData> mRotationPages;
+	vector<BulletRotation> mRotations;
+	int mTick;
+	BulletBatch mBatches[BULLET_BATCH_TYPE_AMOUNT] = {
+		{ "data/SHOTS.sff", "data/SHOTS.air" },
+		{ "data/UI.sff", "data/UI.air" },
+	};
+
+	vector<BulletDrawCommand> mCommands;
+	vector<BulletDrawCommand> mSortedCommands;
+	vector<int> mBucketStarts;
+} gBulletRenderer;
+
+static void addAnimationFrame(BulletAnimation* tAnimation, const SpriteAtlasSheet* tSheet, const string& tLine) {
+	int group, item, offsetX, offsetY, duration;
+	if (sscanf(tLine.data(), " %d , %d , %d , %d , %d", &group, &item, &offsetX, &offsetY, &duration) != 5) return;
+
+	BulletAnimationFrame frame;
+	frame.mRegion = getSpriteAtlasRegion(tSheet, group, item);
+	frame.mOffsetX = offsetX;
+	frame.mOffsetY = offsetY;
+	frame.mDuration = duration;
+	frame.mRotation = -1;
+	tAnimation->mFrames.push_back(frame);
+}
+
+static void loadBulletAnimations(BulletBatch& tBatch) {
+	tBatch.mAnimations.clear();
+	const SpriteAtlasSheet* sheet = getSpriteAtlasSheet(gBulletRenderer.mAtlas, tBatch.mSheetPath);
+	if (!sheet) return;
+
+	Buffer buffer = getAssetPackFileBuffer(tBatch.mAnimationPath);
+	string text((const char*)buffer.mData, buffer.mLength);
+	freeBuffer(buffer);
+
+	stringstream ss(text);
+	string line;
+	BulletAnimation* currentAnimation = nullptr;
+	while (getline(ss, line)) {
+		auto comment = line.find(';');
+		if (comment != string::npos) line = line.substr(0, comment);
+		for (auto& c : line) c = char(tolower((unsigned char)c));
+
+		int animation;
+		if (sscanf(line.data(), " [ begin action %d", &animation) == 1) {
+			currentAnimation = &tBatch.mAnimations[animation];
+			continue;
+		}
+		if (currentAnimation) addAnimationFrame(currentAnimation, sheet, line);
+	}
+
+	auto it = tBatch.mAnimations.begin();
+	while (it != tBatch.mAnimations.end()) {
+		auto& frames = it->second.mFrames;
+		const int isInAtlas = !frames.empty() && all_of(frames.begin(), frames.end(), [](const BulletAnimationFrame& tFrame) { return tFrame.mRegion != nullptr; });
+		if (!isInAtlas) {
+			it = tBatch.mAnimations.erase(it);
+			continue;
+		}
+
+		it->second.mLoopDuration = 0;
+		for (auto& frame : frames) it->second.mLoopDuration += std::max(frame.mDuration, 1);
+		it->second.mCurrentFrame = &frames[0];
+		++it;
+	}
+}
+
+struct RotatedBulletSprite {
+	int mRotation;
+	int mStep;
+	DecodedSprite mSprite;
+};
+
+static void uploadBulletRotationPage(vector<RotatedBulletSprite>& tSprites, const vector<int>& tOrder, const vector<pair<uint32_t, uint32_t>>& tPositions, uint32_t tWidth, uint32_t tHeight) {
+	const uint32_t pixelSize = tWidth * tHeight * 4;
+	uint8_t* pixels = (uint8_t*)allocMemory(int(pixelSize));
+	memset(pixels, 0, pixelSize);
+
+	const int page = int(gBulletRenderer.mRotationPages.size());
+	for (size_t i = 0; i < tPositions.size(); i++) {
+		auto& rotated = tSprites[tOrder[i]];
+		const auto& sprite = rotated.mSprite;
+		for (uint32_t y = 0; y < sprite.mHeight; y++) {
+			memcpy(pixels + (size_t(tPositions[i].second + y) * tWidth + tPositions[i].first) * 4, sprite.mPixels.data() + size_t(y) * sprite.mWidth * 4, sprite.mWidth * 4);
+		}
+
+		SpriteAtlasRegion& region = gBulletRenderer.mRotations[rotated.mRotation].mRegions[rotated.mStep];
+		region.mPage = page;
+		region.mX = int(tPositions[i].first);
+		region.mY = int(tPositions[i].second);
+		region.mWidth = int(sprite.mWidth);
+		region.mHeight = int(sprite.mHeight);
+		region.mAxisX = sprite.mAxisX;
+		region.mAxisY = sprite.mAxisY;
+	}
+
+	Buffer buffer = makeBufferOwned(pixels, pixelSize);
+	gBulletRenderer.mRotationPages.push_back(loadTextureFromARGB32Buffer(buffer, int(tWidth), int(tHeight)));
+	freeBuffer(buffer);
+}
+
+static void loadBulletRotations(BulletBatch& tBatch) {
+	Buffer buffer = getAssetPackFileBuffer(tBatch.mSheetPath);
+	vector<DecodedSprite> sprites;
+	const int isDecoded = decodeSpriteFilePixels((const uint8_t*)buffer.mData, buffer.mLength, sprites, getSpriteDecoderThreadAmount());
+	freeBuffer(buffer);
+	if (!isDecoded) return;
+
+	map<pair<int, int>, int> rotationIndices;
+	vector<RotatedBulletSprite> rotatedSprites;
+	for (auto& sprite : sprites) {
+		if (sprite.mWidth > BULLET_ROTATION_MAX_SIZE || sprite.mHeight > BULLET_ROTATION_MAX_SIZE) continue;
+
+		const int rotation = int(gBulletRenderer.mRotations.size());
+		gBulletRenderer.mRotations.push_back(BulletRotation());
+		rotationIndices[make_pair(sprite.mGroup, sprite.mItem)] = rotation;
+		for (int step = 1; step < BULLET_ROTATION_STEPS; step++) {
+			RotatedBulletSprite rotated;
+			rotated.mRotation = rotation;
+			rotated.mStep = step;
+			rotateDecodedSprite(sprite, step * 2 * M_PI / BULLET_ROTATION_STEPS, rotated.mSprite);
+			rotatedSprites.push_back(move(rotated));
+		}
+	}
+
+	vector<int> remaining;
+	for (size_t i = 0; i < rotatedSprites.size(); i++) remaining.push_back(int(i));
+	sort(remaining.begin(), remaining.end(), [&rotatedSprites](int a, int b) { return rotatedSprites[a].mSprite.mHeight > rotatedSprites[b].mSprite.mHeight; });
+	while (!remaining.empty()) {
+		vector<pair<uint32_t, uint32_t>> sizes;
+		for (auto index : remaining) sizes.push_back(make_pair(rotatedSprites[index].mSprite.mWidth, rotatedSprites[index].mSprite.mHeight));
+		uint32_t width, height;
+		vector<pair<uint32_t, uint32_t>> positions;
+		if (!packSpriteAtlasPage(sizes, &width, &height, positions)) break;
+		uploadBulletRotationPage(rotatedSprites, remaining, positions, width, height);
+		remaining.erase(remaining.begin(), remaining.begin() + positions.size());
+	}
+
+	for (auto& animation : tBatch.mAnimations) {
+		for (auto& frame : animation.second.mFrames) {
+			auto it = rotationIndices.find(make_pair(frame.mRegion->mGroup, frame.mRegion->mItem));
+			if (it == rotationIndices.end()) continue;
+			frame.mRotation = it->second;
+			gBulletRenderer.mRotations[it->second].mRegions[0] = *frame.mRegion;
+		}
+	}
+}
+
+static void unloadBulletRotations() {
+	for (auto& page : gBulletRenderer.mRotationPages) {
+		unloadTexture(page);
+	}
+	gBulletRenderer.mRotationPages.clear();
+	gBulletRenderer.mRotations.clear();
+}
+
+static void clearBulletBatch(BulletBatchType tType) {
+	auto& batch = gBulletRenderer.mBatches[tType];
+	batch.mPositions.clear();
+	batch.mAngles.clear();
+	batch.mAnimationIDs.clear();
+	batch.mPhases.clear();
+	batch.mColors.clear();
+	batch.mTransparencies.clear();
+}
+
+static void loadBulletRenderer(void* tData) {
+	(void)tData;
+	gBulletRenderer.mAtlas = acquireCachedSpriteAtlas(BULLET_ATLAS_PATH);
+	gBulletRenderer.mTick = 0;
+	for (int i = 0; i < BULLET_BATCH_TYPE_AMOUNT; i++) {
+		auto& batch = gBulletRenderer.mBatches[i];
+		loadBulletAnimations(batch);
+		clearBulletBatch(BulletBatchType(i));
+		logFormat("Batching %d animations of %s.", int(batch.mAnimations.size()), batch.mSheetPath);
+	}
+	loadBulletRotations(gBulletRenderer.mBatches[BULLET_BATCH_SHOTS]);
+}
+
+static void unloadBulletRenderer(void* tData) {
+	(void)tData;
+	for (int i = 0; i < BULLET_BATCH_TYPE_AMOUNT; i++) {
+		clearBulletBatch(BulletBatchType(i));
+		gBulletRenderer.mBatches[i].mAnimations.clear();
+	}
+	unloadBulletRotations();
+	releaseCachedSpriteAtlas(BULLET_ATLAS_PATH);
+	gBulletRenderer.mAtlas = NULL;
+}
+
+static const BulletAnimationFrame* getBulletAnimationFrame(const BulletAnimation& tAnimation, int tTick) {
+	if (tAnimation.mFrames.size() == 1) return &tAnimation.mFrames[0];
+
+	int time = tTick % tAnimation.mLoopDuration;
+	for (auto& frame : tAnimation.mFrames) {
+		if (frame.mDuration < 0) return &frame;
+		time -= std::max(frame.mDuration, 1);
+		if (time < 0) return &frame;
+	}
+	return &tAnimation.mFrames.back();
+}
+
+static void updateBulletRenderer(void* tData) {
+	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_BULLET_ANIMATION);
+	gBulletRenderer.mTick++;
+	for (auto& batch : gBulletRenderer.mBatches) {
+		for (auto& animation : batch.mAnimations) {
+			animation.second.mCurrentFrame = getBulletAnimationFrame(animation.second, gBulletRenderer.mTick);
+		}
+	}
+}
+
+static const BulletAnimationFrame* getBulletFrame(const BulletBatch& tBatch, int tAnimation, int tPhase) {
+	const auto& animation = tBatch.mAnimations.at(tAnimation);
+	if (!tPhase) return animation.mCurrentFrame;
+	return getBulletAnimationFrame(animation, gBulletRenderer.mTick + tPhase);
+}
+
+// Bullets attached to Blitz entities are drawn relative to the Blitz camera, including the boss spell card camera rotation.
+static Position getBulletScreenPosition(Position tPosition, double* oAngle) {
+	const double cameraAngle = *getBlitzCameraHandlerRotationZReference();
+	const Position effectPosition = *getBlitzCameraHandlerEffectPositionReference();
+	Position ret = tPosition - getBlitzCameraHandlerPosition();
+	if (cameraAngle) {
+		ret = vecRotateZ(ret - effectPosition, cameraAngle) + effectPosition;
+		*oAngle += cameraAngle;
+	}
+	ret.z = tPosition.z;
+	return ret;
+}
+
+static TextureData* getBulletPageTexture(int tPage) {
+	const int atlasPageAmount = int(gBulletRenderer.mAtlas->mPages.size());
+	if (tPage < atlasPageAmount) return getSpriteAtlasPageTexture(gBulletRenderer.mAtlas, tPage);
+	return &gBulletRenderer.mRotationPages[tPage - atlasPageAmount];
+}
+
+static int getBulletPageAmount() {
+	return int(gBulletRenderer.mAtlas->mPages.size() + gBulletRenderer.mRotationPages.size());
+}
+
+// Picks the atlas region to draw and the rotation that is left to do when drawing it.
+// Pages of pre-rotated frames are numbered after the atlas pages.
+static void resolveBulletRegion(const BulletAnimationFrame* tFrame, BulletDrawCommand* oCommand) {
+	oCommand->mRegion = tFrame->mRegion;
+	oCommand->mPage = tFrame->mRegion->mPage;
+	if (!oCommand->mAngle || tFrame->mRotation < 0) return;
+
+	const double stepAngle = 2 * M_PI / BULLET_ROTATION_STEPS;
+	const int step = ((int(lround(oCommand->mAngle / stepAngle)) % BULLET_ROTATION_STEPS) + BULLET_ROTATION_STEPS) % BULLET_ROTATION_STEPS;
+	oCommand->mRegion = &gBulletRenderer.mRotations[tFrame->mRotation].mRegions[step];
+	if (step) oCommand->mPage = int(gBulletRenderer.mAtlas->mPages.size()) + oCommand->mRegion->mPage;
+	oCommand->mAngle = 0;
+}
+
+static void queueBulletBatch(const BulletBatch& tBatch) {
+	const int pageAmount = getBulletPageAmount();
+	const int amount = int(tBatch.mPositions.size());
+	for (int i = 0; i < amount; i++) {
+		const BulletAnimationFrame* frame = getBulletFrame(tBatch, tBatch.mAnimationIDs[i], tBatch.mPhases[i]);
+		BulletDrawCommand command;
+		command.mAngle = tBatch.mAngles[i];
+		command.mCenter = getBulletScreenPosition(tBatch.mPositions[i], &command.mAngle) + makePosition(frame->mOffsetX, frame->mOffsetY, 0);
+		command.mColor = tBatch.mColors[i];
+		command.mTransparency = tBatch.mTransparencies[i];
+		resolveBulletRegion(frame, &command);
+
+		const int layer = std::min(std::max(int(floor(command.mCenter.z)), 0), BULLET_LAYER_AMOUNT - 1);
+		command.mBucket = layer * pageAmount + command.mPage;
+		gBulletRenderer.mCommands.push_back(command);
+	}
+}
+
+// Counting sort by bucket, which keeps the submission order inside each bucket.
+static void sortBulletDrawCommands() {
+	auto& commands = gBulletRenderer.mCommands;
+	auto& starts = gBulletRenderer.mBucketStarts;
+	starts.assign(BULLET_LAYER_AMOUNT * getBulletPageAmount() + 1, 0);
+	for (auto& command : commands) starts[command.mBucket + 1]++;
+	for (size_t i = 1; i < starts.size(); i++) starts[i] += starts[i - 1];
+
+	gBulletRenderer.mSortedCommands.resize(commands.size());
+	for (auto& command : commands) {
+		gBulletRenderer.mSortedCommands[starts[command.mBucket]++] = command;
+	}
+}
+
+static void drawBullet(const BulletDrawCommand& tCommand) {
+	const SpriteAtlasRegion* region = tCommand.mRegion;
+	const Vector3D& color = tCommand.mColor;
+	const int isColored = color.x != 1 || color.y != 1 || color.z != 1;
+
+	if (tCommand.mAngle) setDrawingRotationZ(tCommand.mAngle, tCommand.mCenter);
+	if (isColored) setDrawingBaseColorAdvanced(color.x, color.y, color.z);
+	if (tCommand.mTransparency != 1) setDrawingTransparency(tCommand.mTransparency);
+
+	// Texture rectangles are inclusive of their bottom right pixel.
+	drawSprite(*getBulletPageTexture(tCommand.mPage), tCommand.mCenter - makePosition(region->mAxisX, region->mAxisY, 0), makeRectangle(region->mX, region->mY, region->mWidth - 1, region->mHeight - 1));
+	if (tCommand.mAngle || isColored || tCommand.mTransparency != 1) setDrawingParametersToIdentity();
+}
+
+static void drawBulletRenderer(void* tData) {
+	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_DRAW_BULLETS);
+	gBulletRenderer.mCommands.clear();
+	for (int i = 0; i < BULLET_BATCH_TYPE_AMOUNT; i++) {
+		auto& batch = gBulletRenderer.mBatches[i];
+		clearBulletBatch(BulletBatchType(i));
+		if (batch.mFill) batch.mFill();
+		queueBulletBatch(batch);
+	}
+	if (gBulletRenderer.mCommands.empty()) return;
+
+	sortBulletDrawCommands();
+	for (auto& command : gBulletRenderer.mSortedCommands) {
+		drawBullet(command);
+	}
+}
+
+ActorBlueprint getBulletRenderer()
+{
+	return makeActorBlueprint(loadBulletRenderer, unloadBulletRenderer, updateBulletRenderer, drawBulletRenderer);
+}
+
+void setBulletBatchFill(BulletBatchType tType, void(*tFill)())
+{
+	gBulletRenderer.mBatches[tType].mFill = tFill;
+}
+
+int canBatchBulletAnimation(BulletBatchType tType, int tAnimation)
+{
+	return gBulletRenderer.mBatches[tType].mAnimations.count(tAnimation) != 0;
+}
+
+void addBatchedBullet(BulletBatchType tType, const Position& tPosition, double tAngle, int tAnimation, int tPhase, const Vector3D& tColor, double tTransparency)
+{
+	auto& batch = gBulletRenderer.mBatches[tType];
+	batch.mPositions.push_back(tPosition);
+	batch.mAngles.push_back(tAngle);
+	batch.mAnimationIDs.push_back(tAnimation);
+	batch.mPhases.push_back(tPhase);
+	batch.mColors.push_back(tColor);
+	batch.mTransparencies.push_back(tTransparency);
+}
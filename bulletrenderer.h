@@ -0,0 +1,16 @@
+#pragma once
+
+#include <prism/actorhandler.h>
+#include <prism/geometry.h>
+
+enum BulletBatchType {
+	BULLET_BATCH_SHOTS,
+	BULLET_BATCH_ITEMS,
+	BULLET_BATCH_TYPE_AMOUNT,
+};
+
+ActorBlueprint getBulletRenderer();
+
+void setBulletBatchFill(BulletBatchType tType, void(*tFill)());
+int canBatchBulletAnimation(BulletBatchType tType, int tAnimation);
+void addBatchedBullet(BulletBatchType tType, const Position& tPosition, double tAngle, int tAnimation, int tPhase, const Vector3D& tColor, double tTransparency);
@@ -0,0 +1,162 @@
+#include "compactsprite.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+// Lossless in-memory storage for decoded 32-bit BGRA sprites.
+// If a whole sheet uses at most 256 colors every sprite becomes 8-bit indices into one shared palette,
+// otherwise sprites are kept as 32-bit pixels. Either form is additionally run-length encoded when that is smaller.
+// The run-length encoding is PackBits style: a control byte with the top bit set repeats the next element
+// (control & 0x7F) + 1 times, otherwise control + 1 literal elements follow.
+
+static void encodeRuns(const uint8_t* tElements, uint32_t tAmount, uint32_t tElementSize, vector<uint8_t>& oData) {
+	uint32_t i = 0;
+	while (i < tAmount) {
+		uint32_t run = 1;
+		while (i + run < tAmount && run < 128 && !memcmp(tElements + (i + run) * tElementSize, tElements + i * tElementSize, tElementSize)) run++;
+		if (run > 1) {
+			oData.push_back(uint8_t(0x80 | (run - 1)));
+			oData.insert(oData.end(), tElements + i * tElementSize, tElements + (i + 1) * tElementSize);
+			i += run;
+			continue;
+		}
+
+		uint32_t literals = 1;
+		while (i + literals < tAmount && literals < 128) {
+			const uint8_t* next = tElements + (i + literals) * tElementSize;
+			if (i + literals + 1 < tAmount && !memcmp(next, next + tElementSize, tElementSize)) break;
+			literals++;
+		}
+		oData.push_back(uint8_t(literals - 1));
+		oData.insert(oData.end(), tElements + i * tElementSize, tElements + (i + literals) * tElementSize);
+		i += literals;
+	}
+}
+
+static void decodeRuns(const vector<uint8_t>& tData, uint32_t tElementSize, uint8_t* oElements, uint32_t tAmount) {
+	const uint8_t* src = tData.data();
+	const uint8_t* end = src + tData.size();
+	uint8_t* dst = oElements;
+	uint8_t* dstEnd = oElements + size_t(tAmount) * tElementSize;
+	while (src < end && dst < dstEnd) {
+		const uint8_t control = *src++;
+		const uint32_t amount = (control & 0x7F) + 1;
+		if (control & 0x80) {
+			for (uint32_t i = 0; i < amount && dst < dstEnd; i++, dst += tElementSize) memcpy(dst, src, tElementSize);
+			src += tElementSize;
+		}
+		else {
+			const uint32_t size = std::min(uint32_t(dstEnd - dst), amount * tElementSize);
+			memcpy(dst, src, size);
+			dst += size;
+			src += amount * tElementSize;
+		}
+	}
+}
+
+static int buildSharedPalette(const vector<DecodedSprite>& tSprites, vector<uint32_t>& oPalette, unordered_map<uint32_t, uint8_t>& oIndices) {
+	for (auto& sprite : tSprites) {
+		const uint32_t* pixels = (const uint32_t*)sprite.mPixels.data();
+		const size_t amount = sprite.mPixels.size() / 4;
+		for (size_t i = 0; i < amount; i++) {
+			if (oIndices.count(pixels[i])) continue;
+			if (oPalette.size() == 256) return 0;
+			oIndices[pixels[i]] = uint8_t(oPalette.size());
+			oPalette.push_back(pixels[i]);
+		}
+	}
+	return 1;
+}
+
+static void compactIndexedSprite(const DecodedSprite& tSprite, const unordered_map<uint32_t, uint8_t>& tIndices, CompactSprite& oSprite) {
+	const uint32_t* pixels = (const uint32_t*)tSprite.mPixels.data();
+	const uint32_t amount = tSprite.mWidth * tSprite.mHeight;
+	vector<uint8_t> indices(amount);
+	for (uint32_t i = 0; i < amount; i++) indices[i] = tIndices.at(pixels[i]);
+
+	encodeRuns(indices.data(), amount, 1, oSprite.mData);
+	if (oSprite.mData.size() < indices.size()) {
+		oSprite.mFormat = COMPACT_SPRITE_INDEXED_RLE;
+	}
+	else {
+		oSprite.mFormat = COMPACT_SPRITE_INDEXED;
+		oSprite.mData = move(indices);
+	}
+}
+
+static void compactTrueColorSprite(const DecodedSprite& tSprite, CompactSprite& oSprite) {
+	encodeRuns(tSprite.mPixels.data(), tSprite.mWidth * tSprite.mHeight, 4, oSprite.mData);
+	if (oSprite.mData.size() < tSprite.mPixels.size()) {
+		oSprite.mFormat = COMPACT_SPRITE_RLE;
+	}
+	else {
+		oSprite.mFormat = COMPACT_SPRITE_RAW;
+		oSprite.mData = tSprite.mPixels;
+	}
+}
+
+void compactSpriteSheet(const std::vector<DecodedSprite>& tSprites, CompactSpriteSheet& oSheet)
+{
+	oSheet.mPalette.clear();
+	oSheet.mSprites.clear();
+	oSheet.mSprites.resize(tSprites.size());
+
+	unordered_map<uint32_t, uint8_t> indices;
+	const int isIndexed = buildSharedPalette(tSprites, oSheet.mPalette, indices);
+	if (!isIndexed) oSheet.mPalette.clear();
+
+	for (size_t i = 0; i < tSprites.size(); i++) {
+		auto& sprite = oSheet.mSprites[i];
+		sprite.mWidth = tSprites[i].mWidth;
+		sprite.mHeight = tSprites[i].mHeight;
+		if (isIndexed) compactIndexedSprite(tSprites[i], indices, sprite);
+		else compactTrueColorSprite(tSprites[i], sprite);
+	}
+}
+
+void expandCompactSprite(const CompactSpriteSheet& tSheet, const CompactSprite& tSprite, std::vector<uint8_t>& oPixels)
+{
+	const uint32_t amount = tSprite.mWidth * tSprite.mHeight;
+	oPixels.resize(size_t(amount) * 4);
+	uint32_t* pixels = (uint32_t*)oPixels.data();
+
+	switch (tSprite.mFormat) {
+	case COMPACT_SPRITE_RAW:
+		memcpy(pixels, tSprite.mData.data(), oPixels.size());
+		break;
+	case COMPACT_SPRITE_RLE:
+		decodeRuns(tSprite.mData, 4, oPixels.data(), amount);
+		break;
+	case COMPACT_SPRITE_INDEXED:
+		for (uint32_t i = 0; i < amount; i++) pixels[i] = tSheet.mPalette[tSprite.mData[i]];
+		break;
+	case COMPACT_SPRITE_INDEXED_RLE: {
+		vector<uint8_t> indices(amount);
+		decodeRuns(tSprite.mData, 1, indices.data(), amount);
+		for (uint32_t i = 0; i < amount; i++) pixels[i] = tSheet.mPalette[indices[i]];
+		break;
+	}
+	}
+}
+
+uint32_t getCompactSpriteSheetSize(const CompactSpriteSheet& tSheet)
+{
+	uint32_t ret = uint32_t(tSheet.mPalette.size() * 4);
+	for (auto& sprite : tSheet.mSprites) ret += uint32_t(sprite.mData.size());
+	return ret;
+}
+
+const char* getCompactSpriteFormatName(CompactSpriteFormat tFormat)
+{
+	switch (tFormat) {
+	case COMPACT_SPRITE_RAW: return "raw";
+	case COMPACT_SPRITE_RLE: return "rle";
+	case COMPACT_SPRITE_INDEXED: return "indexed";
+	case COMPACT_SPRITE_INDEXED_RLE: return "indexed rle";
+	}
+	return "";
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "spritedecoder.h"
+
+enum CompactSpriteFormat {
+	COMPACT_SPRITE_RAW = 0,
+	COMPACT_SPRITE_RLE = 1,
+	COMPACT_SPRITE_INDEXED = 2,
+	COMPACT_SPRITE_INDEXED_RLE = 3,
+};
+
+struct CompactSprite {
+	CompactSpriteFormat mFormat;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	std::vector<uint8_t> mData;
+};
+
+struct CompactSpriteSheet {
+	std::vector<uint32_t> mPalette;
+	std::vector<CompactSprite> mSprites;
+};
+
+void compactSpriteSheet(const std::vector<DecodedSprite>& tSprites, CompactSpriteSheet& oSheet);
+void expandCompactSprite(const CompactSpriteSheet& tSheet, const CompactSprite& tSprite, std::vector<uint8_t>& oPixels);
+uint32_t getCompactSpriteSheetSize(const CompactSpriteSheet& tSheet);
+const char* getCompactSpriteFormatName(CompactSpriteFormat tFormat);
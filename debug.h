@@ -9,6 +9,7 @@ using namespace std;
 class GameVars {
 public:
 	int drawPaths = 0;
+	int invinciblePlayer = 0;
 
 	Vector3DI gameScreen = makeVector3DI(192, 224, 1);
 	Vector3DI gameScreenOffset = makeVector3DI(16, 8, 0);
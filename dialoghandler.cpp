@@ -6,6 +6,9 @@
 #include "level.h"
 #include "boss.h"
 #include "player.h"
+#include "assetprefetch.h"
+#include "gameinput.h"
+#include "profiler.h"
 
 #define DIALOG_Z 85
 
@@ -37,6 +40,7 @@ struct ActiveDialog{
 	int mNameTextID;
 	int mTextTextID;
 	int mPortraitID[2];
+	int mPortraitLevelAnimation[2] = { -1, -1 };
 	int mIsInIntro = 0;
 	int mIntroNow;
 	static ActiveDialog* mSelf;
@@ -46,7 +50,11 @@ struct ActiveDialog{
 		mCurrentStep = 0;
 		mSelf = this;
 
-		for (int i = 0; i < 2; i++) mPortraitID[i] = addMugenAnimation(getMugenAnimation((i == 0) ? getPlayerAnimations() : getLevelAnimations(), getSpeaker(i).mMoodAnimations[mData->mBeginMoods[i]]), (i == 0) ? getPlayerSprites() : getLevelSprites(), makePosition(50 + i * 120, 200, DIALOG_Z));
+		for (int i = 0; i < 2; i++) {
+			int animation = getSpeaker(i).mMoodAnimations[mData->mBeginMoods[i]];
+			if (i != 0) mPortraitLevelAnimation[i] = animation;
+			mPortraitID[i] = addMugenAnimation(getMugenAnimation((i == 0) ? getPlayerAnimations() : getLevelAnimations(), animation), (i == 0) ? getPlayerSprites() : getLevelSpritesForAnimation(animation), makePosition(50 + i * 120, 200, DIALOG_Z));
+		}
 		mTextBoxID = addMugenAnimation(getMugenAnimation(getUIAnimations(), 1000), getUISprites(), makePosition(96 + 16, 220, DIALOG_Z + 1));
 		mNameTextID = addMugenTextMugenStyle("", makePosition(60, 174, DIALOG_Z + 2), makeVector3DI(4, 0, 1));
 		mTextTextID = addMugenTextMugenStyle("", makePosition(60, 184, DIALOG_Z + 2), makeVector3DI(3, 0, 1));
@@ -58,7 +66,10 @@ struct ActiveDialog{
 
 	~ActiveDialog() {
 		removeMugenAnimation(mTextBoxID);
-		for (int i = 0; i < 2; i++) removeMugenAnimation(mPortraitID[i]);
+		for (int i = 0; i < 2; i++) {
+			removeMugenAnimation(mPortraitID[i]);
+			if (mPortraitLevelAnimation[i] != -1) releaseLevelAnimationSprites(mPortraitLevelAnimation[i]);
+		}
 		removeMugenText(mNameTextID);
 		removeMugenText(mTextTextID);
 	}
@@ -81,7 +92,11 @@ struct ActiveDialog{
 		setMugenTextBuildup(mTextTextID, 1);
 
 		if (mData->mSteps[mCurrentStep].mMood != "") {
-			changeMugenAnimation(mPortraitID[speaker.mIndex], getMugenAnimation(getLevelAnimations(), speaker.mMoodAnimations[mData->mSteps[mCurrentStep].mMood]));
+			int animation = speaker.mMoodAnimations[mData->mSteps[mCurrentStep].mMood];
+			acquireLevelAnimationSprites(animation);
+			changeMugenAnimation(mPortraitID[speaker.mIndex], getMugenAnimation(getLevelAnimations(), animation));
+			if (mPortraitLevelAnimation[speaker.mIndex] != -1) releaseLevelAnimationSprites(mPortraitLevelAnimation[speaker.mIndex]);
+			mPortraitLevelAnimation[speaker.mIndex] = animation;
 		}
 	}
 
@@ -97,7 +112,7 @@ struct ActiveDialog{
 			mIntroNow++;
 		}
 		else {
-			if (hasPressedAFlank() || hasPressedB()) {
+			if (hasGamePressedAFlank() || hasGamePressedB()) {
 				if (!isMugenTextBuiltUp(mTextTextID)) {
 					setMugenTextBuiltUp(mTextTextID);
 				}
@@ -242,11 +257,10 @@ static void loadDialogHandler(void* tData) {
 	gDialogHandler.mPreDialog = Dialog();
 	gDialogHandler.mPostDialog = Dialog();
 
-	stringstream ss;
-	ss << "level/DIALOG" << getPlayerName() << getCurrentLevel() << ".txt";
 	MugenDefScript script;
-	loadMugenDefScript(&script, ss.str().data());
+	loadPrefetchedMugenDefScript(&script, getDialogFilePath(getCurrentLevel()));
 	loadDialogFromScript(script);
+	unloadMugenDefScript(script);
 }
 
 static void unloadDialogHandler(void* tData) {
@@ -259,6 +273,7 @@ static void unloadDialogHandler(void* tData) {
 
 static void updateDialogHandler(void* tData) {
 	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_DIALOG);
 	if (!gDialogHandler.mActiveDialog) return;
 
 	if (gDialogHandler.mActiveDialog->update()) {
@@ -271,6 +286,23 @@ ActorBlueprint getDialogHandler()
 	return makeActorBlueprint(loadDialogHandler, unloadDialogHandler, updateDialogHandler);
 }
 
+void reloadDialogHandler()
+{
+	loadDialogHandler(NULL);
+}
+
+std::string getDialogFilePath(int tLevel)
+{
+	return getDialogFilePath(getPlayerName(), tLevel);
+}
+
+std::string getDialogFilePath(const std::string& tPlayerName, int tLevel)
+{
+	stringstream ss;
+	ss << "level/DIALOG" << tPlayerName << tLevel << ".txt";
+	return ss.str();
+}
+
 void startPreDialog()
 {
 	gDialogHandler.mActiveDialog = make_unique<ActiveDialog>(&gDialogHandler.mPreDialog);
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <string>
 #include <prism/actorhandler.h>
 
 ActorBlueprint getDialogHandler();
+void reloadDialogHandler();
+std::string getDialogFilePath(int tLevel);
+std::string getDialogFilePath(const std::string& tPlayerName, int tLevel);
 
 
 void startPreDialog();
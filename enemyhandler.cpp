@@ -9,12 +9,15 @@
 #include "debug.h"
 #include "player.h"
 #include "uihandler.h"
+#include "resourcecache.h"
+#include "statehash.h"
+#include "profiler.h"
 
 typedef std::unique_ptr<ActiveEnemy> ActiveEnemyPtr;
 
 static struct {
-	MugenSpriteFile mSprites;
-	MugenAnimations mAnimations;
+	MugenSpriteFile* mSprites;
+	MugenAnimations* mAnimations;
 
 	map<int, ActiveEnemyPtr> mEnemies;
 	ActiveEnemy* mClosestEnemy;
@@ -22,8 +25,8 @@ static struct {
 
 static void loadEnemyHandler(void* tData) {
 	(void)tData;
-	gEnemyHandler.mSprites = loadMugenSpriteFileWithoutPalette("level/ENEMY.sff");
-	gEnemyHandler.mAnimations = loadMugenAnimationFile("level/ENEMY.air");
+	gEnemyHandler.mSprites = acquireCachedMugenSpriteFile("level/ENEMY.sff");
+	gEnemyHandler.mAnimations = acquireCachedMugenAnimationFile("level/ENEMY.air");
 
 	gEnemyHandler.mEnemies.clear();
 }
@@ -31,6 +34,8 @@ static void loadEnemyHandler(void* tData) {
 static void unloadEnemyHandler(void* tData) {
 	(void)tData;	
 	gEnemyHandler.mEnemies.clear();
+	releaseCachedMugenSpriteFile("level/ENEMY.sff");
+	releaseCachedMugenAnimationFile("level/ENEMY.air");
 }
 
 static void setEnemyPosition(ActiveEnemy& tEnemy, Position tPos) {
@@ -130,6 +135,7 @@ static int updateSingleEnemy(ActiveEnemy& tEnemy) {
 
 static void updateEnemyHandler(void* tData) {
 	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_ENEMIES);
 	gEnemyHandler.mClosestEnemy = nullptr;
 	stl_int_map_remove_predicate(gEnemyHandler.mEnemies, updateSingleEnemy);
 	
@@ -148,6 +154,7 @@ static int drawSingleEnemy(ActiveEnemy& tEnemy) {
 
 static void drawEnemyHandler(void* tData) {
 	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_DRAW_ENEMIES);
 	if (!gGameVars.drawPaths) return;
 	stl_int_map_remove_predicate(gEnemyHandler.mEnemies, drawSingleEnemy);
 
@@ -160,12 +167,12 @@ ActorBlueprint getEnemyHandler()
 
 MugenSpriteFile * getEnemySprites()
 {
-	return &gEnemyHandler.mSprites;
+	return gEnemyHandler.mSprites;
 }
 
 MugenAnimations * getEnemyAnimations()
 {
-	return &gEnemyHandler.mAnimations;
+	return gEnemyHandler.mAnimations;
 }
 
 void addActiveEnemy(LevelEnemy * tEnemy)
@@ -226,7 +233,7 @@ ActiveEnemy::ActiveEnemy(LevelEnemy* tEnemy, int tID) {
 	mChangeAnimationNow = 0;
 	mLifeNow = mData->mLife;
 
-	addBlitzMugenAnimationComponent(mEntityID, &gEnemyHandler.mSprites, &gEnemyHandler.mAnimations, getAnimationIDFromName(tEnemy->mName));
+	addBlitzMugenAnimationComponent(mEntityID, gEnemyHandler.mSprites, gEnemyHandler.mAnimations, getAnimationIDFromName(tEnemy->mName));
 	addBlitzCollisionComponent(mEntityID);
 	int collisionID = addBlitzCollisionCirc(mEntityID, getEnemyCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), tEnemy->mRadius));
 	addBlitzCollisionCB(mEntityID, collisionID, activeEnemyHitCB, this);
@@ -288,6 +295,14 @@ int getActiveEnemyAmount()
 	return gEnemyHandler.mEnemies.size();
 }
 
+void getActiveEnemies(std::vector<ActiveEnemy*>& oEnemies)
+{
+	oEnemies.clear();
+	for (auto& enemyPair : gEnemyHandler.mEnemies) {
+		oEnemies.push_back(enemyPair.second.get());
+	}
+}
+
 typedef struct {
 	int mDamage;
 
@@ -309,6 +324,19 @@ ActiveEnemy* getClosestEnemy()
 	return gEnemyHandler.mClosestEnemy;
 }
 
+void addEnemyStateHash(StateHash& oHash)
+{
+	for (auto& enemyPair : gEnemyHandler.mEnemies) {
+		const auto& enemy = *enemyPair.second;
+		addStateHashPosition(oHash, getBlitzEntityPosition(enemy.mEntityID));
+		addStateHashInt(oHash, enemy.mCurrentPathPosition);
+		addStateHashDouble(oHash, enemy.mPathSectionPosition);
+		addStateHashInt(oHash, enemy.mLifeNow);
+		addStateHashInt(oHash, enemy.mIsInvincible);
+		addStateHashInt(oHash, enemy.m_shotFrequencyNow);
+	}
+}
+
 static double quadBezierPoint(double a0, double a1, double a2, double t) {
 	return pow(1 - t, 2) * a0 + 2 * (1 - t) * t * a1 + pow(t, 2) * a2;
 }
@@ -36,5 +36,9 @@ std::vector<Position> getFullControlPointsForEnemyPath(const std::vector<EnemyPa
 void removeAllEnemies();
 
 int getActiveEnemyAmount();
+void getActiveEnemies(std::vector<ActiveEnemy*>& oEnemies);
 void addDamageToAllEnemies(int tDamage);
-ActiveEnemy* getClosestEnemy();
\ No newline at end of file
+ActiveEnemy* getClosestEnemy();
+
+struct StateHash;
+void addEnemyStateHash(StateHash& oHash);
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "gameinput.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <prism/input.h>
+#include <prism/log.h>
+
+#include "profiler.h"
+#include "replay.h"
+
+using namespace std;
+
+// Gameplay reads its buttons from here instead of from Prism, so the player and dialog can be driven by a script.
+// The handler is the first actor of the game screen and latches the buttons once per frame,
+// which gives every later actor the same state and makes the flanks relative to the previous gameplay frame.
+// A script is a text file of "<frames> [buttons]" lines, e.g. "60 A LEFT", played once or forever after a "loop" line.
+// A replay gives the buttons of every frame directly, and whatever the source, the buttons are passed on to the replay recorder.
+// Menus keep using Prism input directly.
+
+struct GameInputScriptStep {
+	int mDuration;
+	uint32_t mButtons;
+};
+
+enum GameInputSource {
+	GAME_INPUT_SOURCE_PRISM,
+	GAME_INPUT_SOURCE_SCRIPT,
+	GAME_INPUT_SOURCE_FRAMES,
+};
+
+static struct {
+	GameInputSource mSource = GAME_INPUT_SOURCE_PRISM;
+	vector<GameInputScriptStep> mScript;
+	vector<uint8_t> mFrames;
+	size_t mFrame;
+	int mIsScriptLooping;
+	size_t mScriptStep;
+	int mScriptStepFrame;
+
+	uint32_t mButtons = 0;
+	uint32_t mPreviousButtons = 0;
+} gGameInput;
+
+static uint32_t getPrismButtons() {
+	uint32_t buttons = 0;
+	if (hasPressedUp()) buttons |= GAME_BUTTON_UP;
+	if (hasPressedDown()) buttons |= GAME_BUTTON_DOWN;
+	if (hasPressedLeft()) buttons |= GAME_BUTTON_LEFT;
+	if (hasPressedRight()) buttons |= GAME_BUTTON_RIGHT;
+	if (hasPressedA()) buttons |= GAME_BUTTON_A;
+	if (hasPressedB()) buttons |= GAME_BUTTON_B;
+	if (hasPressedR()) buttons |= GAME_BUTTON_R;
+	return buttons;
+}
+
+static uint32_t getScriptButtons() {
+	auto& script = gGameInput.mScript;
+	while (gGameInput.mScriptStep < script.size() && gGameInput.mScriptStepFrame >= script[gGameInput.mScriptStep].mDuration) {
+		gGameInput.mScriptStep++;
+		gGameInput.mScriptStepFrame = 0;
+		if (gGameInput.mScriptStep == script.size() && gGameInput.mIsScriptLooping) gGameInput.mScriptStep = 0;
+	}
+	if (gGameInput.mScriptStep >= script.size()) return 0;
+
+	gGameInput.mScriptStepFrame++;
+	return script[gGameInput.mScriptStep].mButtons;
+}
+
+static uint32_t getFrameButtons() {
+	if (gGameInput.mFrame >= gGameInput.mFrames.size()) return 0;
+	return gGameInput.mFrames[gGameInput.mFrame++];
+}
+
+static void loadGameInputHandler(void* tData) {
+	(void)tData;
+	gGameInput.mButtons = gGameInput.mPreviousButtons = 0;
+	gGameInput.mScriptStep = 0;
+	gGameInput.mScriptStepFrame = 0;
+	gGameInput.mFrame = 0;
+}
+
+static void unloadGameInputHandler(void* tData) {
+	(void)tData;
+	finishReplayRecording();
+}
+
+static void updateGameInputHandler(void* tData) {
+	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_INPUT);
+	gGameInput.mPreviousButtons = gGameInput.mButtons;
+	switch (gGameInput.mSource) {
+	case GAME_INPUT_SOURCE_SCRIPT:
+		gGameInput.mButtons = getScriptButtons();
+		break;
+	case GAME_INPUT_SOURCE_FRAMES:
+		gGameInput.mButtons = getFrameButtons();
+		break;
+	default:
+		gGameInput.mButtons = getPrismButtons();
+		break;
+	}
+	recordReplayFrame(gGameInput.mButtons);
+}
+
+ActorBlueprint getGameInputHandler()
+{
+	return makeActorBlueprint(loadGameInputHandler, unloadGameInputHandler, updateGameInputHandler);
+}
+
+uint32_t parseGameInputButtons(const std::string& tText)
+{
+	static const struct {
+		const char* mName;
+		GameButton mButton;
+	} names[] = {
+		{ "UP", GAME_BUTTON_UP }, { "DOWN", GAME_BUTTON_DOWN }, { "LEFT", GAME_BUTTON_LEFT }, { "RIGHT", GAME_BUTTON_RIGHT },
+		{ "A", GAME_BUTTON_A }, { "B", GAME_BUTTON_B }, { "R", GAME_BUTTON_R },
+	};
+
+	uint32_t buttons = 0;
+	stringstream ss(tText);
+	string word;
+	while (ss >> word) {
+		for (auto& c : word) c = char(toupper((unsigned char)c));
+		int isKnown = 0;
+		for (auto& name : names) {
+			if (word == name.mName) {
+				buttons |= name.mButton;
+				isKnown = 1;
+			}
+		}
+		if (!isKnown) logWarningFormat("Unknown button %s in input script.", word.data());
+	}
+	return buttons;
+}
+
+int loadGameInputScript(const std::string& tPath)
+{
+	ifstream file(tPath);
+	if (!file) {
+		logWarningFormat("Unable to open input script %s.", tPath.data());
+		return 0;
+	}
+
+	gGameInput.mScript.clear();
+	gGameInput.mIsScriptLooping = 0;
+	string line;
+	while (getline(file, line)) {
+		auto comment = line.find(';');
+		if (comment != string::npos) line = line.substr(0, comment);
+
+		stringstream ss(line);
+		string first;
+		if (!(ss >> first)) continue;
+		if (first == "loop") {
+			gGameInput.mIsScriptLooping = 1;
+			continue;
+		}
+
+		GameInputScriptStep step;
+		step.mDuration = atoi(first.data());
+		string rest;
+		getline(ss, rest);
+		step.mButtons = parseGameInputButtons(rest);
+		if (step.mDuration > 0) gGameInput.mScript.push_back(step);
+	}
+
+	if (gGameInput.mScript.empty()) gGameInput.mIsScriptLooping = 0;
+	gGameInput.mSource = GAME_INPUT_SOURCE_SCRIPT;
+	return 1;
+}
+
+void setGameInputIdle()
+{
+	gGameInput.mScript.clear();
+	gGameInput.mIsScriptLooping = 0;
+	gGameInput.mSource = GAME_INPUT_SOURCE_SCRIPT;
+}
+
+void setGameInputConstant(uint32_t tButtons)
+{
+	gGameInput.mScript.assign(1, GameInputScriptStep{ 1, tButtons });
+	gGameInput.mIsScriptLooping = 1;
+	gGameInput.mScriptStep = 0;
+	gGameInput.mScriptStepFrame = 0;
+	gGameInput.mSource = GAME_INPUT_SOURCE_SCRIPT;
+}
+
+void setGameInputFrames(const std::vector<uint8_t>& tFrames)
+{
+	gGameInput.mFrames = tFrames;
+	gGameInput.mSource = GAME_INPUT_SOURCE_FRAMES;
+}
+
+void resetGameInputSource()
+{
+	gGameInput.mSource = GAME_INPUT_SOURCE_PRISM;
+	gGameInput.mScript.clear();
+	gGameInput.mFrames.clear();
+}
+
+uint32_t getGameInputButtons()
+{
+	return gGameInput.mButtons;
+}
+
+static int isGameButtonHeld(uint32_t tButton) {
+	return (gGameInput.mButtons & tButton) != 0;
+}
+
+static int isGameButtonFlank(uint32_t tButton) {
+	return (gGameInput.mButtons & tButton) && !(gGameInput.mPreviousButtons & tButton);
+}
+
+int hasGamePressedUp()
+{
+	return isGameButtonHeld(GAME_BUTTON_UP);
+}
+
+int hasGamePressedDown()
+{
+	return isGameButtonHeld(GAME_BUTTON_DOWN);
+}
+
+int hasGamePressedLeft()
+{
+	return isGameButtonHeld(GAME_BUTTON_LEFT);
+}
+
+int hasGamePressedRight()
+{
+	return isGameButtonHeld(GAME_BUTTON_RIGHT);
+}
+
+int hasGamePressedA()
+{
+	return isGameButtonHeld(GAME_BUTTON_A);
+}
+
+int hasGamePressedAFlank()
+{
+	return isGameButtonFlank(GAME_BUTTON_A);
+}
+
+int hasGamePressedB()
+{
+	return isGameButtonHeld(GAME_BUTTON_B);
+}
+
+int hasGamePressedBFlank()
+{
+	return isGameButtonFlank(GAME_BUTTON_B);
+}
+
+int hasGamePressedR()
+{
+	return isGameButtonHeld(GAME_BUTTON_R);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <prism/actorhandler.h>
+
+enum GameButton {
+	GAME_BUTTON_UP = 1 << 0,
+	GAME_BUTTON_DOWN = 1 << 1,
+	GAME_BUTTON_LEFT = 1 << 2,
+	GAME_BUTTON_RIGHT = 1 << 3,
+	GAME_BUTTON_A = 1 << 4,
+	GAME_BUTTON_B = 1 << 5,
+	GAME_BUTTON_R = 1 << 6,
+};
+
+ActorBlueprint getGameInputHandler();
+
+int loadGameInputScript(const std::string& tPath);
+void setGameInputIdle();
+void setGameInputConstant(uint32_t tButtons);
+void setGameInputFrames(const std::vector<uint8_t>& tFrames);
+void resetGameInputSource();
+uint32_t getGameInputButtons();
+uint32_t parseGameInputButtons(const std::string& tText);
+
+int hasGamePressedUp();
+int hasGamePressedDown();
+int hasGamePressedLeft();
+int hasGamePressedRight();
+int hasGamePressedA();
+int hasGamePressedAFlank();
+int hasGamePressedB();
+int hasGamePressedBFlank();
+int hasGamePressedR();
@@ -14,11 +14,24 @@
 #include "debug.h"
 #include "levelintro.h"
 #include "bghandler.h"
+#include "bulletrenderer.h"
 #include "inmenu.h"
+#include "gameinput.h"
+#include "assetprefetch.h"
+#include "headless.h"
+#include "benchmark.h"
+#include "loadgenerator.h"
+#include "profiler.h"
+#include "replay.h"
+#include "statehash.h"
 
 struct GameScreen {
 
 	GameScreen() {
+		beginGameReplay(getCurrentLevel());
+		int id = instantiateActor(getProfilerFrameBegin());
+		setActorUnpausable(id);
+		instantiateActor(getGameInputHandler());
 		instantiateActor(getBlitzCameraHandler());
 
 		loadGameCollisions();
@@ -30,10 +43,27 @@ struct GameScreen {
 		instantiateActor(getEnemyHandler());
 		instantiateActor(getLevelHandler());
 		instantiateActor(getPlayerHandler());
+		instantiateActor(getBulletRenderer());
 		instantiateActor(getShotHandler());
 		instantiateActor(getBGHandler());
-		int id = instantiateActor(getInMenu());
+		instantiateActor(getStateHashHandler());
+		id = instantiateActor(getInMenu());
+		setActorUnpausable(id);
+		if (isBenchmarkActive()) {
+			id = instantiateActor(getBenchmarkRunner());
+			setActorUnpausable(id);
+		}
+		else if (isLoadGeneratorActive()) {
+			id = instantiateActor(getLoadGeneratorRunner());
+			setActorUnpausable(id);
+		}
+		else if (isSimulationRunnerActive()) {
+			id = instantiateActor(getHeadlessRunner());
+			setActorUnpausable(id);
+		}
+		id = instantiateActor(getProfilerFrameEnd());
 		setActorUnpausable(id);
+		discardPrefetchedAssetFiles();
 	}
 
 	void update()
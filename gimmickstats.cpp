@@ -0,0 +1,230 @@
+#include "gimmickstats.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <prism/log.h>
+
+#include "level.h"
+
+using namespace std;
+
+// Cost and spawn attribution per shot gimmick, started with --gimmick-stats FILE.
+// Every entry is a gimmick together with the SHOTS.def template of the shot running it. Lambdas passed to addShot are
+// entries of their own, named after the gimmick that spawned them, so "mootS9 lambda" is the bullets mootS9 steers.
+// An entry counts its invocations, the time spent in them without the time of nested gimmicks, the shots spawned while
+// it ran and the average lifetime in frames of those of its shots that ended during the run. Shots still alive when the run
+// is reported are only counted as alive, and their lifetime is dropped. Shots spawned outside of any gimmick, by enemies,
+// bosses and the player, go to the "(direct)" entry of their template.
+// The shot handler starts a run when it is loaded and reports it when it is unloaded, and the level reports and restarts
+// the run when it moves on to the next level, so there is one report per level, retry or benchmark scenario,
+// appended to FILE ("-" for stdout) and sorted by time.
+
+#define GIMMICK_STATS_STACK_SIZE 32
+#define GIMMICK_STATS_DIRECT_NAME "(direct)"
+
+struct GimmickStatsEntry {
+	string mGimmick;
+	string mTemplate;
+	uint64_t mInvocations;
+	int64_t mTime;
+	uint64_t mSpawns;
+	uint64_t mFinishedSpawns;
+	uint64_t mLifetimeFrames;
+};
+
+struct GimmickStatsStackEntry {
+	int mID;
+	int mIsInvocation;
+	chrono::steady_clock::time_point mStart;
+	int64_t mChildTime;
+};
+
+static struct {
+	int mIsActive = 0;
+	string mReportPath;
+
+	vector<GimmickStatsEntry> mEntries;
+	map<pair<string, string>, int> mIDs;
+	map<pair<int, int>, int> mInlineIDs;
+
+	GimmickStatsStackEntry mStack[GIMMICK_STATS_STACK_SIZE];
+	int mStackSize;
+
+	string mRunName;
+	int mRun;
+	int mFrameAmount;
+} gGimmickStats;
+
+int parseGimmickStatsArguments(int argc, char** argv)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (!strcmp(argv[i], "--gimmick-stats")) {
+			gGimmickStats.mReportPath = argv[++i];
+			gGimmickStats.mIsActive = 1;
+		}
+	}
+	return gGimmickStats.mIsActive;
+}
+
+int isGimmickStatsActive()
+{
+	return gGimmickStats.mIsActive;
+}
+
+int getGimmickStatsID(const string& tGimmick, const string& tTemplate)
+{
+	if (!gGimmickStats.mIsActive) return -1;
+
+	const auto key = make_pair(tGimmick.empty() ? string(GIMMICK_STATS_DIRECT_NAME) : tGimmick, tTemplate);
+	auto it = gGimmickStats.mIDs.find(key);
+	if (it != gGimmickStats.mIDs.end()) return it->second;
+
+	GimmickStatsEntry entry = {};
+	entry.mGimmick = key.first;
+	entry.mTemplate = key.second;
+	gGimmickStats.mEntries.push_back(entry);
+	const int id = int(gGimmickStats.mEntries.size()) - 1;
+	gGimmickStats.mIDs[key] = id;
+	return id;
+}
+
+int getInlineGimmickStatsID(int tSpawnerID, int tTemplateID)
+{
+	if (!gGimmickStats.mIsActive || tTemplateID < 0) return -1;
+
+	const auto key = make_pair(tSpawnerID, tTemplateID);
+	auto it = gGimmickStats.mInlineIDs.find(key);
+	if (it != gGimmickStats.mInlineIDs.end()) return it->second;
+
+	const string spawner = tSpawnerID >= 0 ? gGimmickStats.mEntries[tSpawnerID].mGimmick : string(GIMMICK_STATS_DIRECT_NAME);
+	const int id = getGimmickStatsID(spawner + " lambda", gGimmickStats.mEntries[tTemplateID].mTemplate);
+	gGimmickStats.mInlineIDs[key] = id;
+	return id;
+}
+
+int getActiveGimmickStats()
+{
+	if (!gGimmickStats.mStackSize) return -1;
+	return gGimmickStats.mStack[std::min(gGimmickStats.mStackSize, GIMMICK_STATS_STACK_SIZE) - 1].mID;
+}
+
+void beginGimmickStats(int tID, int tIsInvocation)
+{
+	if (gGimmickStats.mStackSize >= GIMMICK_STATS_STACK_SIZE) {
+		gGimmickStats.mStackSize++;
+		return;
+	}
+
+	auto& entry = gGimmickStats.mStack[gGimmickStats.mStackSize++];
+	entry.mID = tID;
+	entry.mIsInvocation = tIsInvocation;
+	entry.mChildTime = 0;
+	if (tIsInvocation) entry.mStart = chrono::steady_clock::now();
+}
+
+void endGimmickStats()
+{
+	if (!gGimmickStats.mStackSize) return;
+	gGimmickStats.mStackSize--;
+	if (gGimmickStats.mStackSize >= GIMMICK_STATS_STACK_SIZE) return;
+
+	const auto& entry = gGimmickStats.mStack[gGimmickStats.mStackSize];
+	int64_t time = entry.mChildTime;
+	if (entry.mIsInvocation) {
+		time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - entry.mStart).count();
+		gGimmickStats.mEntries[entry.mID].mInvocations++;
+		gGimmickStats.mEntries[entry.mID].mTime += time - entry.mChildTime;
+	}
+	if (gGimmickStats.mStackSize) gGimmickStats.mStack[gGimmickStats.mStackSize - 1].mChildTime += time;
+}
+
+void addGimmickStatsSpawn(int tID)
+{
+	gGimmickStats.mEntries[tID].mSpawns++;
+}
+
+void addGimmickStatsLifetime(int tID, int tFrames)
+{
+	gGimmickStats.mEntries[tID].mFinishedSpawns++;
+	gGimmickStats.mEntries[tID].mLifetimeFrames += tFrames;
+}
+
+void addGimmickStatsFrame()
+{
+	gGimmickStats.mFrameAmount++;
+}
+
+void startGimmickStatsRun()
+{
+	if (!gGimmickStats.mIsActive) return;
+
+	for (auto& entry : gGimmickStats.mEntries) {
+		entry.mInvocations = entry.mSpawns = entry.mFinishedSpawns = entry.mLifetimeFrames = 0;
+		entry.mTime = 0;
+	}
+	gGimmickStats.mStackSize = 0;
+	gGimmickStats.mFrameAmount = 0;
+	gGimmickStats.mRunName = "level " + to_string(getCurrentLevel());
+	gGimmickStats.mRun++;
+}
+
+int getGimmickStatsRun()
+{
+	return gGimmickStats.mRun;
+}
+
+void setGimmickStatsRunName(const string& tName)
+{
+	gGimmickStats.mRunName = tName;
+}
+
+// Ends the run, so shots that were alive when it was reported do not add their lifetime to it or the next one.
+void reportGimmickStats()
+{
+	if (!gGimmickStats.mIsActive) return;
+	gGimmickStats.mRun++;
+
+	const int isStdout = gGimmickStats.mReportPath == "-";
+	FILE* file = isStdout ? stdout : fopen(gGimmickStats.mReportPath.data(), "a");
+	if (!file) {
+		logWarningFormat("Unable to write gimmick stats %s.", gGimmickStats.mReportPath.data());
+		return;
+	}
+
+	vector<int> order;
+	int64_t totalTime = 0;
+	for (size_t i = 0; i < gGimmickStats.mEntries.size(); i++) {
+		const auto& entry = gGimmickStats.mEntries[i];
+		if (!entry.mInvocations && !entry.mSpawns) continue;
+		order.push_back(int(i));
+		totalTime += entry.mTime;
+	}
+	sort(order.begin(), order.end(), [](int a, int b) {
+		const auto& first = gGimmickStats.mEntries[a];
+		const auto& second = gGimmickStats.mEntries[b];
+		return first.mTime != second.mTime ? first.mTime > second.mTime : first.mSpawns > second.mSpawns;
+	});
+
+	const double frameAmount = std::max(1, gGimmickStats.mFrameAmount);
+	fprintf(file, "Gimmick stats for %s: %d frames, %.4f ms of gimmicks per frame\n", gGimmickStats.mRunName.data(), gGimmickStats.mFrameAmount, totalTime / (1000000.0 * frameAmount));
+	fprintf(file, "%-28s %-32s %10s %10s %10s %10s %10s %10s %10s\n", "gimmick", "template", "calls", "total_ms", "ms/frame", "us/call", "spawned", "alive", "avg_life");
+	for (auto i : order) {
+		const auto& entry = gGimmickStats.mEntries[i];
+		const double totalMilliseconds = entry.mTime / 1000000.0;
+		const double callMicroseconds = entry.mInvocations ? entry.mTime / (1000.0 * entry.mInvocations) : 0;
+		const double lifetime = entry.mFinishedSpawns ? double(entry.mLifetimeFrames) / entry.mFinishedSpawns : 0;
+		fprintf(file, "%-28s %-32s %10llu %10.3f %10.4f %10.3f %10llu %10llu %10.1f\n", entry.mGimmick.data(), entry.mTemplate.data(), (unsigned long long)entry.mInvocations,
+			totalMilliseconds, totalMilliseconds / frameAmount, callMicroseconds, (unsigned long long)entry.mSpawns, (unsigned long long)(entry.mSpawns - entry.mFinishedSpawns), lifetime);
+	}
+	fprintf(file, "\n");
+	if (isStdout) fflush(file);
+	else fclose(file);
+}
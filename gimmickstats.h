@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+int parseGimmickStatsArguments(int argc, char** argv);
+int isGimmickStatsActive();
+
+int getGimmickStatsID(const std::string& tGimmick, const std::string& tTemplate);
+int getInlineGimmickStatsID(int tSpawnerID, int tTemplateID);
+int getActiveGimmickStats();
+
+void beginGimmickStats(int tID, int tIsInvocation);
+void endGimmickStats();
+void addGimmickStatsSpawn(int tID);
+void addGimmickStatsLifetime(int tID, int tFrames);
+void addGimmickStatsFrame();
+
+void startGimmickStatsRun();
+int getGimmickStatsRun();
+void setGimmickStatsRunName(const std::string& tName);
+void reportGimmickStats();
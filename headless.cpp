@@ -0,0 +1,215 @@
+#include "headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <prism/drawing.h>
+#include <prism/log.h>
+#include <prism/wrapper.h>
+
+#include "benchmark.h"
+#include "boss.h"
+#include "enemyhandler.h"
+#include "gameinput.h"
+#include "gamescreen.h"
+#include "itemhandler.h"
+#include "level.h"
+#include "loadgenerator.h"
+#include "player.h"
+#include "replay.h"
+#include "shothandler.h"
+#include "statehash.h"
+
+using namespace std;
+
+// Plays a level without drawing for a fixed number of frames and reports timing and game state, for machines without a GPU.
+// Started with --headless [--frames N] [--level N] [--player NAME] [--input FILE] [--seed N] [--report FILE].
+// Drawing is disabled in Prism and the wrapper runs HEADLESS_TIME_DILATATION updates per loop, so the simulation is not capped
+// by the display. The player and dialog read their buttons from the input script, an empty script is idle input.
+// With --benchmark the boss phase scenarios of benchmark.cpp run instead of a level, with --load-sweep or --load the
+// synthetic load of loadgenerator.cpp.
+// With --replay FILE the character, level, seed and buttons come from the replay and the run lasts as long as the replay.
+// Without --headless the replay is drawn and plays at normal speed, with the same report at the end.
+// The runner is updated after all gameplay actors, so the time between two of its updates is one full gameplay frame.
+// Headless, the wrapper still draws and waits for vsync once per HEADLESS_TIME_DILATATION updates. The runner's draw marks
+// that, and the frame time sample that spans it is left out so the timing only covers gameplay updates.
+// It keeps counting while the game is paused, so a game over on the continue screen still ends the run.
+
+#define HEADLESS_TIME_DILATATION 1000
+
+static struct {
+	int mIsActive = 0;
+	int mHasFrameAmount = 0;
+	int mFrameAmount = 3600;
+	int mLevel = 0;
+	string mPlayerName = "AEROLITE";
+	string mInputPath;
+	unsigned int mSeed = 0;
+	string mReportPath;
+
+	int mFrame;
+	int mIsReported;
+	int mHasLastUpdate;
+	chrono::steady_clock::time_point mStartTime;
+	chrono::steady_clock::time_point mLastUpdateTime;
+	vector<double> mFrameTimes;
+	int mPeakShotAmount;
+} gHeadless;
+
+int parseHeadlessArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) {
+		const int hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--headless")) gHeadless.mIsActive = 1;
+		else if (!strcmp(argv[i], "--frames") && hasValue) {
+			gHeadless.mFrameAmount = atoi(argv[++i]);
+			gHeadless.mHasFrameAmount = 1;
+		}
+		else if (!strcmp(argv[i], "--level") && hasValue) gHeadless.mLevel = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--player") && hasValue) gHeadless.mPlayerName = argv[++i];
+		else if (!strcmp(argv[i], "--input") && hasValue) gHeadless.mInputPath = argv[++i];
+		else if (!strcmp(argv[i], "--seed") && hasValue) gHeadless.mSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (!strcmp(argv[i], "--report") && hasValue) gHeadless.mReportPath = argv[++i];
+	}
+	return gHeadless.mIsActive;
+}
+
+int isHeadless()
+{
+	return gHeadless.mIsActive;
+}
+
+int isSimulationRunnerActive()
+{
+	return gHeadless.mIsActive || isReplayPlayback();
+}
+
+void startHeadlessSimulation()
+{
+	if (gHeadless.mIsActive) {
+		disableDrawing();
+		setWrapperTimeDilatation(HEADLESS_TIME_DILATATION);
+	}
+
+	if (isBenchmarkActive()) {
+		startBenchmarks();
+		return;
+	}
+	if (isLoadGeneratorActive()) {
+		startLoadGenerator();
+		return;
+	}
+
+	if (isReplayPlayback()) {
+		setPlayerName(getReplayPlayerName());
+		setGameInputFrames(getReplayFrames());
+		if (!gHeadless.mHasFrameAmount) gHeadless.mFrameAmount = int(getReplayFrames().size());
+		resetGameAtLevel(getReplayLevel());
+	}
+	else {
+		setPlayerName(gHeadless.mPlayerName);
+		if (gHeadless.mInputPath.empty() || !loadGameInputScript(gHeadless.mInputPath)) setGameInputIdle();
+		setNextGameSeed(gHeadless.mSeed);
+		resetGameAtLevel(gHeadless.mLevel);
+	}
+	startScreenHandling(getGameScreen());
+}
+
+double getFrameTimePercentile(std::vector<double> tValues, double tPercentile)
+{
+	if (tValues.empty()) return 0;
+	const size_t index = std::min(tValues.size() - 1, size_t(tPercentile * tValues.size()));
+	nth_element(tValues.begin(), tValues.begin() + index, tValues.end());
+	return tValues[index];
+}
+
+static void writeHeadlessReport(FILE* tFile, int tIsComplete) {
+	const auto& times = gHeadless.mFrameTimes;
+	double total = 0, maximum = 0;
+	for (auto time : times) {
+		total += time;
+		maximum = std::max(maximum, time);
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - gHeadless.mStartTime).count();
+
+	fprintf(tFile, "{\n");
+	fprintf(tFile, "\t\"complete\": %d,\n", tIsComplete);
+	fprintf(tFile, "\t\"frames\": %d,\n", gHeadless.mFrame);
+	fprintf(tFile, "\t\"seconds\": %.3f,\n", seconds);
+	fprintf(tFile, "\t\"frames_per_second\": %.1f,\n", seconds > 0 ? gHeadless.mFrame / seconds : 0.0);
+	fprintf(tFile, "\t\"frame_ms\": { \"mean\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n", times.empty() ? 0.0 : total / times.size(), getFrameTimePercentile(times, 0.99), maximum);
+	fprintf(tFile, "\t\"level\": %d,\n", getCurrentLevel());
+	fprintf(tFile, "\t\"player\": { \"name\": \"%s\", \"score\": %llu, \"life\": %d, \"bombs\": %d, \"power\": %d },\n", getPlayerName().data(), (unsigned long long)getPlayerScore(), getPlayerLife(), getPlayerBombs(), getPlayerPower());
+	fprintf(tFile, "\t\"shots\": %d,\n", getActiveShotAmount());
+	fprintf(tFile, "\t\"peak_shots\": %d,\n", gHeadless.mPeakShotAmount);
+	fprintf(tFile, "\t\"enemies\": %d,\n", getActiveEnemyAmount());
+	fprintf(tFile, "\t\"items\": %d,\n", getActiveItemAmount());
+	fprintf(tFile, "\t\"boss\": %d%s\n", hasActiveBoss(), isVerifyingStateHashes() ? "," : "");
+	if (isVerifyingStateHashes()) {
+		fprintf(tFile, "\t\"desync_frame\": %d,\n", getStateHashDesyncFrame());
+		fprintf(tFile, "\t\"desync_subsystem\": \"%s\"\n", getStateHashDesyncSubsystem());
+	}
+	fprintf(tFile, "}\n");
+}
+
+static void finishHeadlessSimulation(int tIsComplete) {
+	if (gHeadless.mIsReported) return;
+	gHeadless.mIsReported = 1;
+
+	writeHeadlessReport(stdout, tIsComplete);
+	if (!gHeadless.mReportPath.empty()) {
+		FILE* file = fopen(gHeadless.mReportPath.data(), "w");
+		if (file) {
+			writeHeadlessReport(file, tIsComplete);
+			fclose(file);
+		}
+		else {
+			logWarningFormat("Unable to write headless report %s.", gHeadless.mReportPath.data());
+		}
+	}
+	abortScreenHandling();
+}
+
+static void loadHeadlessRunner(void* tData) {
+	(void)tData;
+	gHeadless.mFrame = 0;
+	gHeadless.mIsReported = 0;
+	gHeadless.mHasLastUpdate = 0;
+	gHeadless.mFrameTimes.clear();
+	gHeadless.mFrameTimes.reserve(gHeadless.mFrameAmount);
+	gHeadless.mPeakShotAmount = 0;
+	gHeadless.mStartTime = chrono::steady_clock::now();
+}
+
+static void unloadHeadlessRunner(void* tData) {
+	(void)tData;
+	finishHeadlessSimulation(0);
+}
+
+static void drawHeadlessRunner(void* tData) {
+	(void)tData;
+	if (gHeadless.mIsActive) gHeadless.mHasLastUpdate = 0;
+}
+
+static void updateHeadlessRunner(void* tData) {
+	(void)tData;
+	const auto now = chrono::steady_clock::now();
+	if (gHeadless.mHasLastUpdate) gHeadless.mFrameTimes.push_back(chrono::duration<double, milli>(now - gHeadless.mLastUpdateTime).count());
+	gHeadless.mLastUpdateTime = now;
+	gHeadless.mHasLastUpdate = 1;
+
+	gHeadless.mPeakShotAmount = std::max(gHeadless.mPeakShotAmount, getActiveShotAmount());
+	gHeadless.mFrame++;
+	if (gHeadless.mFrame >= gHeadless.mFrameAmount) finishHeadlessSimulation(1);
+}
+
+ActorBlueprint getHeadlessRunner()
+{
+	return makeActorBlueprint(loadHeadlessRunner, unloadHeadlessRunner, updateHeadlessRunner, drawHeadlessRunner);
+}
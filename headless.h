@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+#include <prism/actorhandler.h>
+
+int parseHeadlessArguments(int argc, char** argv);
+int isHeadless();
+int isSimulationRunnerActive();
+void startHeadlessSimulation();
+double getFrameTimePercentile(std::vector<double> tValues, double tPercentile);
+
+ActorBlueprint getHeadlessRunner();
@@ -0,0 +1,86 @@
+#include "hudframe.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+using namespace std;
+
+// Cuts the full-screen HUD frame into the rectangles around the playfield hole, so the hole is never drawn.
+// The top and bottom regions span the full width and the left and right ones the height of the hole.
+// Slicing fails when the hole is not fully transparent, since the regions would then lose part of the frame.
+
+static int isHoleTransparent(const DecodedSprite& tFrame, int tHoleX, int tHoleY, int tHoleWidth, int tHoleHeight) {
+	for (int y = tHoleY; y < tHoleY + tHoleHeight; y++) {
+		for (int x = tHoleX; x < tHoleX + tHoleWidth; x++) {
+			if (tFrame.mPixels[(size_t(y) * tFrame.mWidth + x) * 4 + 3]) return 0;
+		}
+	}
+	return 1;
+}
+
+static void addHUDFrameRegion(const DecodedSprite& tFrame, int tX, int tY, int tWidth, int tHeight, vector<HUDFrameRegion>& oRegions) {
+	if (tWidth <= 0 || tHeight <= 0) return;
+
+	HUDFrameRegion region;
+	region.mX = tX;
+	region.mY = tY;
+	region.mWidth = tWidth;
+	region.mHeight = tHeight;
+	region.mPixels.resize(size_t(tWidth) * tHeight * 4);
+	for (int y = 0; y < tHeight; y++) {
+		memcpy(&region.mPixels[size_t(y) * tWidth * 4], &tFrame.mPixels[(size_t(tY + y) * tFrame.mWidth + tX) * 4], size_t(tWidth) * 4);
+	}
+
+	region.mIsOpaque = 1;
+	for (size_t i = 3; i < region.mPixels.size(); i += 4) {
+		if (region.mPixels[i] != 255) {
+			region.mIsOpaque = 0;
+			break;
+		}
+	}
+	oRegions.push_back(move(region));
+}
+
+int sliceHUDFrame(const DecodedSprite& tFrame, int tHoleX, int tHoleY, int tHoleWidth, int tHoleHeight, vector<HUDFrameRegion>& oRegions)
+{
+	oRegions.clear();
+	const int width = int(tFrame.mWidth);
+	const int height = int(tFrame.mHeight);
+	if (tHoleX < 0 || tHoleY < 0 || tHoleWidth <= 0 || tHoleHeight <= 0 || tHoleX + tHoleWidth > width || tHoleY + tHoleHeight > height) return 0;
+	if (!isHoleTransparent(tFrame, tHoleX, tHoleY, tHoleWidth, tHoleHeight)) return 0;
+
+	addHUDFrameRegion(tFrame, 0, 0, width, tHoleY, oRegions);
+	addHUDFrameRegion(tFrame, 0, tHoleY + tHoleHeight, width, height - tHoleY - tHoleHeight, oRegions);
+	addHUDFrameRegion(tFrame, 0, tHoleY, tHoleX, tHoleHeight, oRegions);
+	addHUDFrameRegion(tFrame, tHoleX + tHoleWidth, tHoleY, width - tHoleX - tHoleWidth, tHoleHeight, oRegions);
+	return 1;
+}
+
+int findHUDFrameRegion(const vector<HUDFrameRegion>& tRegions, int tX, int tY)
+{
+	for (size_t i = 0; i < tRegions.size(); i++) {
+		const auto& region = tRegions[i];
+		if (tX >= region.mX && tY >= region.mY && tX < region.mX + region.mWidth && tY < region.mY + region.mHeight) return int(i);
+	}
+	return -1;
+}
+
+// Source-over blend of the sprite with its axis at frame position (tX, tY), clipped to the region.
+void blendHUDFrameSprite(HUDFrameRegion& oRegion, const DecodedSprite& tSprite, int tX, int tY)
+{
+	const int left = tX - tSprite.mAxisX - oRegion.mX;
+	const int top = tY - tSprite.mAxisY - oRegion.mY;
+	for (int y = std::max(0, -top); y < int(tSprite.mHeight) && top + y < oRegion.mHeight; y++) {
+		for (int x = std::max(0, -left); x < int(tSprite.mWidth) && left + x < oRegion.mWidth; x++) {
+			const uint8_t* src = &tSprite.mPixels[(size_t(y) * tSprite.mWidth + x) * 4];
+			uint8_t* dst = &oRegion.mPixels[(size_t(top + y) * oRegion.mWidth + left + x) * 4];
+			const uint32_t alpha = src[3];
+			if (!alpha) continue;
+			for (int channel = 0; channel < 3; channel++) {
+				dst[channel] = uint8_t((src[channel] * alpha + dst[channel] * (255 - alpha) + 127) / 255);
+			}
+			dst[3] = uint8_t(alpha + (dst[3] * (255 - alpha) + 127) / 255);
+		}
+	}
+}
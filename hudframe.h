@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include "spritedecoder.h"
+
+struct HUDFrameRegion {
+	int mX;
+	int mY;
+	int mWidth;
+	int mHeight;
+	int mIsOpaque;
+	std::vector<uint8_t> mPixels;
+};
+
+int sliceHUDFrame(const DecodedSprite& tFrame, int tHoleX, int tHoleY, int tHoleWidth, int tHoleHeight, std::vector<HUDFrameRegion>& oRegions);
+int findHUDFrameRegion(const std::vector<HUDFrameRegion>& tRegions, int tX, int tY);
+void blendHUDFrameSprite(HUDFrameRegion& oRegion, const DecodedSprite& tSprite, int tX, int tY);
@@ -5,6 +5,7 @@
 #include "player.h"
 #include "menuscreen.h"
 #include "enemyhandler.h"
+#include "assetprefetch.h"
 
 #define IN_MENU_BASE_Z 80
 
@@ -202,6 +203,7 @@ struct InMenu
 	void gotoTitle()
 	{
 		setInactive();
+		discardPrefetchedAssetFiles();
 		setNewScreen(getMenuScreen());
 	}
 
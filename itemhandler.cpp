@@ -2,11 +2,14 @@
 
 #include <prism/blitz.h>
 
+#include "bulletrenderer.h"
 #include "uihandler.h"
 #include "collision.h"
 #include "player.h"
 #include "debug.h"
 #include "level.h"
+#include "statehash.h"
+#include "profiler.h"
 
 #define ITEM_Z 10
 
@@ -18,6 +21,8 @@ struct Item {
 	int m_isHuge;
 	int m_id;
 	int mIsAutocollected = 0;
+	int mAnimation;
+	int mIsBatched;
 
 	enum ItemType {
 		POWER,
@@ -30,6 +35,7 @@ struct Item {
 		m_tType = tType;
 		m_isHuge = isHuge;
 		m_id = tID;
+		// Every item shares one layer, the bullet renderer keeps them in spawn order within it.
 		tPos.z = ITEM_Z;
 		m_entityID = addBlitzEntity(tPos);
 		int animation;
@@ -50,7 +56,9 @@ struct Item {
 			animation = 11;
 			break;
 		}
-		addBlitzMugenAnimationComponent(m_entityID, getUISprites(), getUIAnimations(), animation);
+		mAnimation = animation;
+		mIsBatched = canBatchBulletAnimation(BULLET_BATCH_ITEMS, animation);
+		if (!mIsBatched) addBlitzMugenAnimationComponent(m_entityID, getUISprites(), getUIAnimations(), animation);
 		addBlitzCollisionComponent(m_entityID);
 		const int collisionID = addBlitzCollisionCirc(m_entityID, getItemCollisionList(), makeCollisionCirc(makePosition(0, 0, 0), isHuge ? 10 : 5));
 		addBlitzCollisionCB(m_entityID, collisionID, itemHitCB, this);
@@ -89,6 +97,11 @@ struct Item {
 		return y > getScreenPositionFromGamePositionY(1.2);
 	}
 
+	void addToBatch() {
+		if (!mIsBatched) return;
+		addBatchedBullet(BULLET_BATCH_ITEMS, getBlitzEntityPosition(m_entityID), 0, mAnimation, 0, makePosition(1, 1, 1), 1);
+	}
+
 	~Item() {
 		removeBlitzEntity(m_entityID);
 	}
@@ -100,17 +113,26 @@ static struct {
 	map<int, ItemPtr> mItems;
 } gItemHandler;
 
+static void fillItemBatch() {
+	for (auto& item : gItemHandler.mItems) {
+		item.second->addToBatch();
+	}
+}
+
 static void loadItemHandler(void* tCaller) {
 	(void)tCaller;
 	gItemHandler.mItems.clear();
+	setBulletBatchFill(BULLET_BATCH_ITEMS, fillItemBatch);
 }
 
 static void unloadItemHandler(void* tCaller) {
 	(void)tCaller;
+	setBulletBatchFill(BULLET_BATCH_ITEMS, nullptr);
 	gItemHandler.mItems.clear();
 }
 
 static void updateItemHandler(void* tCaller) {
+	ProfileScope profileScope(PROFILE_ZONE_ITEMS);
 	stl_int_map_remove_predicate(gItemHandler.mItems, &Item::update);
 }
 
@@ -153,7 +175,6 @@ void addPowerItems(Position tPos, int tPower)
 {
 	while (tPower >= 10) {
 		Position finalPos = tPos + makePosition(randfrom(-10, 10), randfrom(-10, 10), 0);
-		finalPos.z = randfrom(11.5, 12.5);
 		int id = stl_int_map_get_id();
 		gItemHandler.mItems.insert(make_pair(id, make_unique<Item>(finalPos, Item::ItemType::POWER, 1, id)));
 		tPower -= 10;
@@ -161,7 +182,6 @@ void addPowerItems(Position tPos, int tPower)
 
 	while(tPower--) {
 		Position finalPos = tPos + makePosition(randfrom(-5, 5), randfrom(-5, 5), 0);
-		finalPos.z = randfrom(11.5, 12.5);
 		int id = stl_int_map_get_id();
 		gItemHandler.mItems.insert(make_pair(id, make_unique<Item>(finalPos, Item::ItemType::POWER, 0, id)));
 	}
@@ -180,7 +200,6 @@ void addScoreItems(Position tPos, int tScore)
 {
 	while (tScore--) {
 		Position finalPos = tPos + makePosition(randfrom(-5, 5), randfrom(-5, 5), 0);
-		finalPos.z = randfrom(11.5, 12.5);
 		int id = stl_int_map_get_id();
 		gItemHandler.mItems.insert(make_pair(id, make_unique<Item>(finalPos, Item::ItemType::SCORE, 0, id)));
 	}
@@ -189,7 +208,6 @@ void addScoreItems(Position tPos, int tScore)
 void addBombItem(Position tPos)
 {
 	Position finalPos = tPos + makePosition(randfrom(-10, 10), randfrom(-10, 10), 0);
-	finalPos.z = randfrom(11.5, 12.5);
 	int id = stl_int_map_get_id();
 	gItemHandler.mItems.insert(make_pair(id, make_unique<Item>(finalPos, Item::ItemType::BOMB, 1, id)));
 }
@@ -197,11 +215,30 @@ void addBombItem(Position tPos)
 void addLifeItem(Position tPos)
 {
 	Position finalPos = tPos + makePosition(randfrom(-10, 10), randfrom(-10, 10), 0);
-	finalPos.z = randfrom(11.5, 12.5);
 	int id = stl_int_map_get_id();
 	gItemHandler.mItems.insert(make_pair(id, make_unique<Item>(finalPos, Item::ItemType::LIFE, 1, id)));
 }
 
+void removeAllItems()
+{
+	gItemHandler.mItems.clear();
+}
+
+int getActiveItemAmount()
+{
+	return int(gItemHandler.mItems.size());
+}
+
+void addItemStateHash(StateHash& oHash)
+{
+	for (auto& itemPair : gItemHandler.mItems) {
+		const auto& item = *itemPair.second;
+		addStateHashInt(oHash, item.m_tType);
+		addStateHashInt(oHash, item.mIsAutocollected);
+		addStateHashPosition(oHash, getBlitzEntityPosition(item.m_entityID));
+	}
+}
+
 void setItemsAutocollect()
 {
 	for (auto& item : gItemHandler.mItems) {
@@ -10,4 +10,9 @@ void addDeathPowerItems(Position tPos);
 void addScoreItems(Position tPos, int tPower);
 void addBombItem(Position tPos);
 void addLifeItem(Position tPos);
-void setItemsAutocollect();
\ No newline at end of file
+void setItemsAutocollect();
+void removeAllItems();
+int getActiveItemAmount();
+
+struct StateHash;
+void addItemStateHash(StateHash& oHash);
\ No newline at end of file
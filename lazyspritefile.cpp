@@ -0,0 +1,304 @@
+#include "lazyspritefile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <prism/log.h>
+
+#include "assetpack.h"
+#include "assetprefetch.h"
+#include "compactsprite.h"
+#include "spritedecoder.h"
+
+using namespace std;
+
+// Sprite files that only keep their compressed data and an index in memory.
+// A sprite is decoded and uploaded when it is first acquired. Once nothing references it anymore
+// it stays resident until the sprites of all lazy files exceed LAZY_SPRITE_RESIDENT_BUDGET,
+// then the least recently released ones are removed again.
+// With LAZY_SPRITE_STORAGE_COMPACT the file is decoded once at load and kept in the lossless compact form
+// from compactsprite.h instead, which turns a later upload into a cheap expansion instead of a PNG decode.
+// The PNG sources are usually smaller than their compact form (see tools/spritemem), so source storage is the default,
+// and a sheet is only kept compact when it measures smaller than its source.
+// Sprites can be given a brightness that is baked into their pixels on upload, to darken them without an overlay.
+
+#if defined(DREAMCAST) || defined(__EMSCRIPTEN__)
+#define LAZY_SPRITE_RESIDENT_BUDGET (1024 * 1024)
+#else
+#define LAZY_SPRITE_RESIDENT_BUDGET (8 * 1024 * 1024)
+#endif
+
+struct LazySprite;
+typedef list<pair<LazySpriteFile*, LazySprite*>> LazySpriteList;
+
+struct LazySprite {
+	DecodedSprite mInfo;
+	SpriteFileNode mNode;
+	int mCompactIndex;
+	double mBrightness = 1;
+	int mReferences = 0;
+	int mIsResident = 0;
+	int mIsInLRU = 0;
+	LazySpriteList::iterator mLRUPosition;
+};
+
+struct LazySpriteFile {
+	string mPath;
+	MugenSpriteFile mSprites;
+	int mIsLazy;
+
+	int mIsCompact;
+
+	vector<uint8_t> mSource;
+	CompactSpriteSheet mCompact;
+	map<pair<int, int>, LazySprite> mSpriteIndex;
+	map<int, vector<pair<int, int>>> mAnimationSprites;
+};
+
+static struct {
+	LazySpriteFileStorage mStorage = LAZY_SPRITE_STORAGE_SOURCE;
+	LazySpriteList mUnreferencedSprites;
+	int mResidentSize = 0;
+	int mResidentPeakSize = 0;
+} gLazySprites;
+
+static int getSpriteSize(const LazySprite& tSprite) {
+	return int(tSprite.mInfo.mWidth * tSprite.mInfo.mHeight * 4);
+}
+
+static void removeFromLRU(LazySprite& tSprite) {
+	if (!tSprite.mIsInLRU) return;
+	gLazySprites.mUnreferencedSprites.erase(tSprite.mLRUPosition);
+	tSprite.mIsInLRU = 0;
+}
+
+static void evictLazySprite(LazySpriteFile* tFile, LazySprite& tSprite) {
+	removeFromLRU(tSprite);
+	removeMugenSpriteFileSprite(&tFile->mSprites, tSprite.mInfo.mGroup, tSprite.mInfo.mItem);
+	tSprite.mIsResident = 0;
+	gLazySprites.mResidentSize -= getSpriteSize(tSprite);
+}
+
+static void enforceLazySpriteBudget(int tIncomingSize) {
+	while (gLazySprites.mResidentSize + tIncomingSize > LAZY_SPRITE_RESIDENT_BUDGET && !gLazySprites.mUnreferencedSprites.empty()) {
+		auto coldest = gLazySprites.mUnreferencedSprites.front();
+		evictLazySprite(coldest.first, *coldest.second);
+	}
+}
+
+static void applySpriteBrightness(vector<uint8_t>& tPixels, double tBrightness) {
+	const uint32_t factor = uint32_t(std::min(std::max(tBrightness, 0.0), 1.0) * 256 + 0.5);
+	for (size_t i = 0; i < tPixels.size(); i += 4) {
+		tPixels[i + 0] = uint8_t((tPixels[i + 0] * factor) >> 8);
+		tPixels[i + 1] = uint8_t((tPixels[i + 1] * factor) >> 8);
+		tPixels[i + 2] = uint8_t((tPixels[i + 2] * factor) >> 8);
+	}
+}
+
+static int makeLazySpriteResident(LazySpriteFile* tFile, LazySprite& tSprite) {
+	if (tSprite.mIsResident) return 1;
+
+	DecodedSprite decoded = tSprite.mInfo;
+	if (tFile->mIsCompact) {
+		expandCompactSprite(tFile->mCompact, tFile->mCompact.mSprites[tSprite.mCompactIndex], decoded.mPixels);
+	}
+	else if (!decodeSpriteFileSprite(tFile->mSource.data(), tSprite.mNode, decoded)) {
+		logWarningFormat("Unable to decode sprite %d %d of %s", tSprite.mInfo.mGroup, tSprite.mInfo.mItem, tFile->mPath.data());
+		return 0;
+	}
+
+	if (tSprite.mBrightness != 1) applySpriteBrightness(decoded.mPixels, tSprite.mBrightness);
+
+	Buffer pixels = makeBuffer(decoded.mPixels.data(), uint32_t(decoded.mPixels.size()));
+	auto sprite = makeMugenSpriteFileSpriteFromARGB32Buffer(pixels, decoded.mWidth, decoded.mHeight, Vector2D(decoded.mAxisX, decoded.mAxisY));
+	addMugenSpriteFileSprite(&tFile->mSprites, decoded.mGroup, decoded.mItem, sprite);
+
+	tSprite.mIsResident = 1;
+	gLazySprites.mResidentSize += getSpriteSize(tSprite);
+	gLazySprites.mResidentPeakSize = std::max(gLazySprites.mResidentPeakSize, gLazySprites.mResidentSize);
+	return 1;
+}
+
+static void readAnimationSprites(LazySpriteFile* tFile, const string& tAnimationPath) {
+	Buffer buffer = getAssetPackFileBuffer(tAnimationPath);
+	string text((const char*)buffer.mData, buffer.mLength);
+	freeBuffer(buffer);
+
+	stringstream ss(text);
+	string line;
+	vector<pair<int, int>>* currentAnimation = nullptr;
+	while (getline(ss, line)) {
+		auto comment = line.find(';');
+		if (comment != string::npos) line = line.substr(0, comment);
+		string lowerLine = line;
+		for (auto& c : lowerLine) c = char(tolower((unsigned char)c));
+
+		int animation;
+		if (sscanf(lowerLine.data(), " [ begin action %d", &animation) == 1) {
+			currentAnimation = &tFile->mAnimationSprites[animation];
+			continue;
+		}
+
+		int group, item;
+		if (currentAnimation && sscanf(lowerLine.data(), " %d , %d", &group, &item) == 2) {
+			if (find(currentAnimation->begin(), currentAnimation->end(), make_pair(group, item)) == currentAnimation->end()) {
+				currentAnimation->push_back(make_pair(group, item));
+			}
+		}
+	}
+}
+
+static void logSpriteSheetSizes(LazySpriteFile* tFile, const vector<DecodedSprite>& tSprites, uint32_t tSourceSize) {
+	uint32_t expandedSize = 0;
+	for (auto& sprite : tSprites) expandedSize += uint32_t(sprite.mPixels.size());
+	const char* format = tFile->mCompact.mPalette.empty() ? "32 bit" : "indexed";
+	logFormat("Sprite sheet %s: %u bytes expanded, %u bytes source, %u bytes compact (%s).", tFile->mPath.data(), expandedSize, tSourceSize, getCompactSpriteSheetSize(tFile->mCompact), format);
+}
+
+void setLazySpriteFileStorage(LazySpriteFileStorage tStorage)
+{
+	gLazySprites.mStorage = tStorage;
+}
+
+LazySpriteFile* loadLazySpriteFile(const std::string& tPath, const std::string& tAnimationPath)
+{
+	auto file = new LazySpriteFile();
+	file->mPath = tPath;
+
+	Buffer buffer = takePrefetchedAssetFile(tPath);
+	vector<DecodedSprite> sprites;
+	vector<SpriteFileNode> nodes;
+	file->mIsLazy = readSpriteFileIndex((const uint8_t*)buffer.mData, buffer.mLength, sprites, nodes);
+	if (!file->mIsLazy) {
+		file->mSprites = loadMugenSpriteFileWithoutPaletteFromBuffer(buffer);
+		freePrefetchedAssetFile(buffer);
+		return file;
+	}
+
+	vector<DecodedSprite> decodedSprites;
+	file->mIsCompact = gLazySprites.mStorage == LAZY_SPRITE_STORAGE_COMPACT && decodeSpriteFilePixels((const uint8_t*)buffer.mData, buffer.mLength, decodedSprites, getSpriteDecoderThreadAmount());
+	if (file->mIsCompact) {
+		compactSpriteSheet(decodedSprites, file->mCompact);
+		logSpriteSheetSizes(file, decodedSprites, buffer.mLength);
+		if (getCompactSpriteSheetSize(file->mCompact) >= buffer.mLength) {
+			file->mCompact = CompactSpriteSheet();
+			file->mIsCompact = 0;
+		}
+	}
+	if (!file->mIsCompact) {
+		file->mSource.assign((const uint8_t*)buffer.mData, (const uint8_t*)buffer.mData + buffer.mLength);
+	}
+	freePrefetchedAssetFile(buffer);
+
+	file->mSprites = makeEmptyMugenSpriteFile();
+	for (size_t i = 0; i < sprites.size(); i++) {
+		auto& sprite = file->mSpriteIndex[make_pair(sprites[i].mGroup, sprites[i].mItem)];
+		sprite.mInfo = sprites[i];
+		sprite.mNode = nodes[i];
+		sprite.mCompactIndex = int(i);
+	}
+	if (!tAnimationPath.empty()) readAnimationSprites(file, tAnimationPath);
+	return file;
+}
+
+void unloadLazySpriteFile(LazySpriteFile* tFile)
+{
+	logFormat("Unloading %s, lazy sprites resident %d bytes, peak %d bytes.", tFile->mPath.data(), gLazySprites.mResidentSize, gLazySprites.mResidentPeakSize);
+	for (auto& entry : tFile->mSpriteIndex) {
+		auto& sprite = entry.second;
+		removeFromLRU(sprite);
+		if (sprite.mIsResident) gLazySprites.mResidentSize -= getSpriteSize(sprite);
+	}
+	unloadMugenSpriteFile(&tFile->mSprites);
+	delete tFile;
+}
+
+MugenSpriteFile* getLazySpriteFileSprites(LazySpriteFile* tFile)
+{
+	return &tFile->mSprites;
+}
+
+void acquireLazySprite(LazySpriteFile* tFile, int tGroup, int tItem)
+{
+	if (!tFile->mIsLazy) return;
+	auto it = tFile->mSpriteIndex.find(make_pair(tGroup, tItem));
+	if (it == tFile->mSpriteIndex.end()) return;
+
+	auto& sprite = it->second;
+	removeFromLRU(sprite);
+	sprite.mReferences++;
+	if (!sprite.mIsResident) enforceLazySpriteBudget(getSpriteSize(sprite));
+	makeLazySpriteResident(tFile, sprite);
+}
+
+void releaseLazySprite(LazySpriteFile* tFile, int tGroup, int tItem)
+{
+	if (!tFile->mIsLazy) return;
+	auto it = tFile->mSpriteIndex.find(make_pair(tGroup, tItem));
+	if (it == tFile->mSpriteIndex.end() || !it->second.mReferences) return;
+
+	auto& sprite = it->second;
+	if (--sprite.mReferences || !sprite.mIsResident) return;
+	sprite.mLRUPosition = gLazySprites.mUnreferencedSprites.insert(gLazySprites.mUnreferencedSprites.end(), make_pair(tFile, &sprite));
+	sprite.mIsInLRU = 1;
+	enforceLazySpriteBudget(0);
+}
+
+void acquireLazyAnimationSprites(LazySpriteFile* tFile, int tAnimation)
+{
+	auto it = tFile->mAnimationSprites.find(tAnimation);
+	if (it == tFile->mAnimationSprites.end()) return;
+
+	for (auto& sprite : it->second) {
+		acquireLazySprite(tFile, sprite.first, sprite.second);
+	}
+}
+
+void releaseLazyAnimationSprites(LazySpriteFile* tFile, int tAnimation)
+{
+	auto it = tFile->mAnimationSprites.find(tAnimation);
+	if (it == tFile->mAnimationSprites.end()) return;
+
+	for (auto& sprite : it->second) {
+		releaseLazySprite(tFile, sprite.first, sprite.second);
+	}
+}
+
+int setLazyAnimationSpritesBrightness(LazySpriteFile* tFile, int tAnimation, double tBrightness)
+{
+	if (!tFile->mIsLazy) return 0;
+	auto it = tFile->mAnimationSprites.find(tAnimation);
+	if (it == tFile->mAnimationSprites.end()) return 0;
+
+	for (auto& key : it->second) {
+		auto spriteIt = tFile->mSpriteIndex.find(key);
+		if (spriteIt == tFile->mSpriteIndex.end()) continue;
+		auto& sprite = spriteIt->second;
+		if (sprite.mBrightness == tBrightness) continue;
+		if (sprite.mReferences) {
+			logWarningFormat("Unable to change the brightness of sprite %d %d of %s while it is in use", key.first, key.second, tFile->mPath.data());
+			return 0;
+		}
+
+		sprite.mBrightness = tBrightness;
+		if (sprite.mIsResident) evictLazySprite(tFile, sprite);
+	}
+	return 1;
+}
+
+int getLazySpriteResidentSize()
+{
+	return gLazySprites.mResidentSize;
+}
+
+int getLazySpriteResidentPeakSize()
+{
+	return gLazySprites.mResidentPeakSize;
+}
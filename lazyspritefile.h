@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <prism/mugenspritefilereader.h>
+
+struct LazySpriteFile;
+
+enum LazySpriteFileStorage {
+	LAZY_SPRITE_STORAGE_SOURCE,
+	LAZY_SPRITE_STORAGE_COMPACT,
+};
+
+void setLazySpriteFileStorage(LazySpriteFileStorage tStorage);
+
+LazySpriteFile* loadLazySpriteFile(const std::string& tPath, const std::string& tAnimationPath);
+void unloadLazySpriteFile(LazySpriteFile* tFile);
+MugenSpriteFile* getLazySpriteFileSprites(LazySpriteFile* tFile);
+
+void acquireLazySprite(LazySpriteFile* tFile, int tGroup, int tItem);
+void releaseLazySprite(LazySpriteFile* tFile, int tGroup, int tItem);
+void acquireLazyAnimationSprites(LazySpriteFile* tFile, int tAnimation);
+void releaseLazyAnimationSprites(LazySpriteFile* tFile, int tAnimation);
+int setLazyAnimationSpritesBrightness(LazySpriteFile* tFile, int tAnimation, double tBrightness);
+
+int getLazySpriteResidentSize();
+int getLazySpriteResidentPeakSize();
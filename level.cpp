@@ -1,5 +1,7 @@
 #include "level.h"
 
+#include <map>
+
 #include <prism/blitz.h>
 
 #include "enemyhandler.h"
@@ -13,6 +15,12 @@
 #include "dialoghandler.h"
 #include "menuscreen.h"
 #include "storyscreen.h"
+#include "bghandler.h"
+#include "itemhandler.h"
+#include "assetprefetch.h"
+#include "gimmickstats.h"
+#include "lazyspritefile.h"
+#include "profiler.h"
 
 #define LEVEL_DONE_Z 85
 
@@ -23,7 +31,8 @@ struct Section {
 };
 
 static struct {
-	MugenSpriteFile mSprites;
+	LazySpriteFile* mSprites = nullptr;
+	map<int, int> mAcquiredAnimations;
 	MugenAnimations mAnimations;
 
 	vector<Section> mSections;
@@ -31,6 +40,7 @@ static struct {
 	int mCurrentSection;
 	int mCurrentDeltaTime;
 	int mCurrentLevel = 4;
+	int mIsScriptActive = 1;
 
 	int mIsLevelEnding;
 	int mLevelEndAnimationID;
@@ -140,17 +150,18 @@ static void loadCurrentSection() {
 	gLevelData.mCurrentDeltaTime = 0;
 }
 
-static void loadLevel(void* tData) {
-	MugenDefScript script;
+static string getLevelFilePath(int tLevel, const char* tExtension) {
 	stringstream ss;
-	ss << "level/LEVEL" << gLevelData.mCurrentLevel << ".txt";
-	loadMugenDefScript(&script, ss.str().data());
-	ss = stringstream();
-	ss << "level/LEVEL" << gLevelData.mCurrentLevel << ".sff";
-	gLevelData.mSprites = loadMugenSpriteFileWithoutPalette(ss.str());
-	ss = stringstream();
-	ss << "level/LEVEL" << gLevelData.mCurrentLevel << ".air";
-	gLevelData.mAnimations = loadMugenAnimationFile(ss.str());
+	ss << "level/LEVEL" << tLevel << "." << tExtension;
+	return ss.str();
+}
+
+static void loadLevelData() {
+	MugenDefScript script;
+	loadPrefetchedMugenDefScript(&script, getLevelFilePath(gLevelData.mCurrentLevel, "txt"));
+	gLevelData.mSprites = loadLazySpriteFile(getLevelFilePath(gLevelData.mCurrentLevel, "sff"), getLevelFilePath(gLevelData.mCurrentLevel, "air"));
+	gLevelData.mAcquiredAnimations.clear();
+	gLevelData.mAnimations = loadPrefetchedMugenAnimationFile(getLevelFilePath(gLevelData.mCurrentLevel, "air"));
 
 	gLevelData.mSections.clear();
 	MugenDefScriptGroup* current = script.mFirstGroup;
@@ -175,15 +186,23 @@ static void loadLevel(void* tData) {
 		}
 		current = current->mNext;
 	}
+	unloadMugenDefScript(script);
 
 	gLevelData.mIsLevelEnding = 0;
 	gLevelData.mCurrentSection = 0;
 	loadCurrentSection();
+}
 
+static void loadLevel(void* tData) {
+	(void)tData;
+	loadLevelData();
 }
 
 static void unloadLevel(void* tData) {
 	gLevelData.mSections.clear();
+	gLevelData.mAcquiredAnimations.clear();
+	unloadLazySpriteFile(gLevelData.mSprites);
+	gLevelData.mSprites = nullptr;
 }
 
 static void updateCurrentAction() {
@@ -223,14 +242,44 @@ static void updateCurrentSection() {
 	updateSectionOver();
 }
 
+static void prefetchNextLevel() {
+	const int nextLevel = gLevelData.mCurrentLevel + 1;
+	prefetchAssetFile(getLevelFilePath(nextLevel, "txt"));
+	prefetchAssetFile(getLevelFilePath(nextLevel, "sff"));
+	prefetchAssetFile(getLevelFilePath(nextLevel, "air"));
+	prefetchAssetFile(getDialogFilePath(nextLevel));
+}
+
+static void swapToCurrentLevel() {
+	reportGimmickStats();
+	startGimmickStatsRun();
+
+	removeMugenAnimation(gLevelData.mLevelEndAnimationID);
+	removeMugenText(gLevelData.mLevelEndText);
+	removeAllEnemies();
+	removeEnemyBullets();
+	removePlayerBullets();
+	removeAllItems();
+	resetPlayerForLevel();
+
+	unloadLazySpriteFile(gLevelData.mSprites);
+	unloadMugenAnimationFile(&gLevelData.mAnimations);
+	loadLevelData();
+	reloadDialogHandler();
+	reloadBGHandler();
+
+	addFadeIn(20, NULL, NULL);
+}
+
 static void gotoNextLevel(void* tCaller) {
 	(void)tCaller;
 	gLevelData.mCurrentLevel++;
-	setNewScreen(getGameScreen());
+	swapToCurrentLevel();
 }
 
 static void gotoMenuScreen(void* tCaller) {
 	(void)tCaller;
+	discardPrefetchedAssetFiles();
 	setNewScreen(getMenuScreen());
 }
 
@@ -258,8 +307,8 @@ static void updateLevelEndingNormal()
 		int scoreBonus = (gLevelData.mCurrentLevel + 1) * 1000000;
 		stringstream ss;
 		ss << "LEVEL COMPLETE BONUS: " << scoreBonus;
-		int id = addMugenTextMugenStyle(ss.str().data(), getScreenPositionFromGamePosition(0.5, 0.3, LEVEL_DONE_Z), makeVector3DI(4, 0, 0));
-		setMugenTextScale(id, 0.6);
+		gLevelData.mLevelEndText = addMugenTextMugenStyle(ss.str().data(), getScreenPositionFromGamePosition(0.5, 0.3, LEVEL_DONE_Z), makeVector3DI(4, 0, 0));
+		setMugenTextScale(gLevelData.mLevelEndText, 0.6);
 		addPlayerScore(scoreBonus);
 	}
 
@@ -322,7 +371,8 @@ static void updateLevelEnding() {
 
 static void updateLevel(void* tData) {
 	(void)tData;
-	updateCurrentSection();
+	ProfileScope profileScope(PROFILE_ZONE_LEVEL);
+	if (gLevelData.mIsScriptActive) updateCurrentSection();
 	updateLevelEnding();
 }
 
@@ -333,7 +383,36 @@ ActorBlueprint getLevelHandler()
 
 MugenSpriteFile* getLevelSprites()
 {
-	return &gLevelData.mSprites;
+	return getLazySpriteFileSprites(gLevelData.mSprites);
+}
+
+// Level sprites are decoded when the first entity using them is created. Every getter call has to be paired with a release once the entity is removed, after which the sprites may be evicted again.
+MugenSpriteFile* getLevelSpritesForAnimation(int tAnimation)
+{
+	acquireLevelAnimationSprites(tAnimation);
+	return getLevelSprites();
+}
+
+void acquireLevelAnimationSprites(int tAnimation)
+{
+	if (gLevelData.mAcquiredAnimations[tAnimation]++) return;
+	acquireLazyAnimationSprites(gLevelData.mSprites, tAnimation);
+}
+
+void releaseLevelAnimationSprites(int tAnimation)
+{
+	auto it = gLevelData.mAcquiredAnimations.find(tAnimation);
+	if (it == gLevelData.mAcquiredAnimations.end()) return;
+	if (--it->second) return;
+	gLevelData.mAcquiredAnimations.erase(it);
+	releaseLazyAnimationSprites(gLevelData.mSprites, tAnimation);
+}
+
+// Bakes the brightness into the sprites of the animation, which only works while the animation is not acquired.
+int setLevelAnimationBrightness(int tAnimation, double tBrightness)
+{
+	if (gLevelData.mAcquiredAnimations.count(tAnimation)) return 0;
+	return setLazyAnimationSpritesBrightness(gLevelData.mSprites, tAnimation, tBrightness);
 }
 
 MugenAnimations* getLevelAnimations()
@@ -377,6 +456,10 @@ void endLevel()
 	setMugenAnimationTransparency(gLevelData.mLevelEndAnimationID, 0);
 	gLevelData.mLevelEndNow = 0;
 	gLevelData.mIsLevelEnding = 1;
+
+	if (gLevelData.mCurrentLevel < 4) {
+		prefetchNextLevel();
+	}
 }
 
 int isLevelEnding()
@@ -391,18 +474,45 @@ int isInExtra()
 
 void startExtra()
 {
-	gLevelData.mCurrentLevel = 5;
-	resetPlayer();
+	resetGameAtLevel(5);
 	setNewScreen(getGameScreen());
 }
 
 void startGame()
 {
-	gLevelData.mCurrentLevel = 0;
-	resetPlayer();
+	resetGameAtLevel(0);
 	setNewScreen(getGameScreen());
 }
 
+void resetGameAtLevel(int tLevel)
+{
+	gLevelData.mCurrentLevel = tLevel;
+	resetPlayer();
+}
+
+int skipLevelToBoss(const std::string& tName)
+{
+	for (size_t i = 0; i < gLevelData.mSections.size(); i++) {
+		auto& section = gLevelData.mSections[i];
+		for (size_t j = 0; j < section.mActions.size(); j++) {
+			if (!section.mActions[j]->isBoss(tName)) continue;
+
+			gLevelData.mCurrentSection = int(i);
+			loadCurrentSection();
+			removeEnemyBullets();
+			section.mCurrentAction = int(j) + 1;
+			section.mTimeDelta = 0;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void setLevelScriptActive(int tIsActive)
+{
+	gLevelData.mIsScriptActive = tIsActive;
+}
+
 LevelEnemy::LevelEnemy(MugenDefScriptGroup* tGroup) {
 	mTime = getMugenDefIntegerOrDefaultAsGroup(tGroup, "time", 0);
 	mName = getSTLMugenDefStringOrDefaultAsGroup(tGroup, "name", "enemy1");
@@ -450,6 +560,20 @@ LevelEnemy::LevelEnemy(MugenDefScriptGroup* tGroup) {
 	mControlPath = getFullControlPointsForEnemyPath(mPath);
 }
 
+LevelEnemy::LevelEnemy(const std::vector<EnemyPathPoint>& tPath, int tLife) {
+	mTime = 0;
+	mName = "enemy1";
+	mSpeedFactor = 1;
+	mRadius = 5;
+	mPower = 0;
+	mScore = 0;
+	mLife = tLife;
+	mStartsInvincible = 0;
+	mChangeAnimationTime = INF;
+	mPath = tPath;
+	mControlPath = getFullControlPointsForEnemyPath(mPath);
+}
+
 int LevelEnemy::isTime(int tDeltaTime) {
 	return tDeltaTime >= mTime;
 }
@@ -480,3 +604,8 @@ void LevelBoss::handle()
 {
 	addBoss(mName);
 }
+
+int LevelBoss::isBoss(const std::string& tName)
+{
+	return mName == tName;
+}
\ No newline at end of file
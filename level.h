@@ -13,6 +13,7 @@ struct LevelAction {
 
 	virtual int isTime(int tDeltaTime) = 0;
 	virtual void handle() = 0;
+	virtual int isBoss(const std::string& tName) { (void)tName; return 0; }
 };
 
 typedef std::unique_ptr<LevelAction> LevelActionPtr;
@@ -55,6 +56,7 @@ struct LevelEnemy : LevelAction {
 	std::string mDeathShot;
 
 	LevelEnemy(MugenDefScriptGroup* tGroup);
+	LevelEnemy(const std::vector<EnemyPathPoint>& tPath, int tLife);
 
 	virtual int isTime(int tDeltaTime) override;
 	virtual void handle() override;
@@ -69,11 +71,16 @@ struct LevelBoss : LevelAction {
 
 	virtual int isTime(int tDeltaTime) override;
 	virtual void handle() override;
+	virtual int isBoss(const std::string& tName) override;
 };
 
 ActorBlueprint getLevelHandler();
 
 MugenSpriteFile* getLevelSprites();
+MugenSpriteFile* getLevelSpritesForAnimation(int tAnimation);
+void acquireLevelAnimationSprites(int tAnimation);
+void releaseLevelAnimationSprites(int tAnimation);
+int setLevelAnimationBrightness(int tAnimation, double tBrightness);
 MugenAnimations* getLevelAnimations();
 int getCurrentLevel();
 Position getScreenPositionFromGamePosition(Position tPosition);
@@ -86,4 +93,7 @@ int isLevelEnding();
 
 int isInExtra();
 void startExtra();
-void startGame();
\ No newline at end of file
+void startGame();
+void resetGameAtLevel(int tLevel);
+int skipLevelToBoss(const std::string& tName);
+void setLevelScriptActive(int tIsActive);
\ No newline at end of file
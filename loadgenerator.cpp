@@ -0,0 +1,384 @@
+#include "loadgenerator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <prism/blitz.h>
+#include <prism/log.h>
+#include <prism/wrapper.h>
+
+#include "collision.h"
+#include "debug.h"
+#include "enemyhandler.h"
+#include "gameinput.h"
+#include "gamescreen.h"
+#include "gimmickstats.h"
+#include "headless.h"
+#include "itemhandler.h"
+#include "level.h"
+#include "player.h"
+#include "profiler.h"
+#include "replay.h"
+#include "shothandler.h"
+
+using namespace std;
+
+// Synthetic load for scaling curves: keeps N enemies alive on random baked paths, fires M bullets per second from them with
+// a mix of straight, aimed, homing and laser shots, and drops bursts of score items.
+// Started with --load-sweep all|NAME[,NAME...] or with --load ENEMIES,BULLETS,ITEMS[,FIRING] for a single step, plus
+// [--load-mix STRAIGHT,AIMED,HOMING,LASER] [--load-csv FILE] [--frames N] [--seed N] [--player NAME], usually with --headless.
+// A sweep doubles one parameter over LOAD_SWEEP_STEP_AMOUNT steps, see gLoadSweeps. Every step clears the field and waits
+// LOAD_WARMUP_FRAMES frames for the live object counts to settle before measuring, all in a single game screen with the
+// level script stopped and an invincible player. The CSV has one line per step with the average live objects and the
+// frame times, tools/loadplot draws it as one chart per sweep.
+// Each sweep grows one kind of object, so its curve is the cost of the system handling that object: shots, enemies, items,
+// and for "collision" enemies under fire from the player, which is mostly collision checks between the two shot lists.
+// The profiler is switched on for the run, and the CSV also has the mean milliseconds of the systems in gLoadZones, where
+// "prism update" holds Prism's collision pass.
+
+#define LOAD_WARMUP_FRAMES 180
+#define LOAD_DEFAULT_FRAMES 600
+#define LOAD_SWEEP_STEP_AMOUNT 7
+#define LOAD_PATH_AMOUNT 64
+#define LOAD_ENEMY_LIFE 10
+#define LOAD_ITEM_BURST_INTERVAL 30
+
+enum LoadShotKind {
+	LOAD_SHOT_STRAIGHT,
+	LOAD_SHOT_AIMED,
+	LOAD_SHOT_HOMING,
+	LOAD_SHOT_LASER,
+	LOAD_SHOT_KIND_AMOUNT,
+};
+
+static const char* gLoadShotNames[LOAD_SHOT_KIND_AMOUNT] = { "enemy_mid_straight", "enemy_mid_aimed", "enemy_mid_homing", "enemy_laser_aimed" };
+
+enum LoadParameter {
+	LOAD_PARAMETER_ENEMIES,
+	LOAD_PARAMETER_BULLETS,
+	LOAD_PARAMETER_ITEMS,
+};
+
+struct LoadStep {
+	int mEnemyAmount;
+	int mBulletsPerSecond;
+	int mItemBurst;
+	int mIsPlayerFiring;
+};
+
+struct LoadSweep {
+	const char* mName;
+	LoadStep mBase;
+	LoadParameter mParameter;
+	int mFirstValue;
+};
+
+static const LoadSweep gLoadSweeps[] = {
+	{ "enemies", { 0, 0, 0, 0 }, LOAD_PARAMETER_ENEMIES, 16 },
+	{ "shots", { 8, 0, 0, 0 }, LOAD_PARAMETER_BULLETS, 240 },
+	{ "items", { 0, 0, 0, 0 }, LOAD_PARAMETER_ITEMS, 8 },
+	{ "collision", { 0, 480, 0, 1 }, LOAD_PARAMETER_ENEMIES, 16 },
+};
+
+struct LoadRun {
+	string mSweep;
+	LoadStep mStep;
+};
+
+static const ProfileZone gLoadZones[] = { PROFILE_ZONE_SHOTS, PROFILE_ZONE_ENEMIES, PROFILE_ZONE_ITEMS, PROFILE_ZONE_PRISM_UPDATE };
+static const char* gLoadZoneColumns[] = { "shots_ms", "enemies_ms", "items_ms", "prism_update_ms" };
+
+#define LOAD_ZONE_AMOUNT int(sizeof(gLoadZones) / sizeof(gLoadZones[0]))
+
+static struct {
+	int mIsActive = 0;
+	vector<LoadRun> mRuns;
+	int mMix[LOAD_SHOT_KIND_AMOUNT] = { 4, 3, 2, 1 };
+	int mFrameAmount = LOAD_DEFAULT_FRAMES;
+	unsigned int mSeed = 0;
+	string mPlayerName = "AEROLITE";
+	string mCSVPath;
+
+	FILE* mCSV;
+	vector<unique_ptr<LevelEnemy>> mPaths;
+	vector<ActiveEnemy*> mEmitters;
+	size_t mCurrentRun;
+	int mFrame;
+	int mIsOver;
+	int mNextPath;
+	double mBulletCredit;
+	chrono::steady_clock::time_point mLastUpdateTime;
+	int mHasDrawn;
+	vector<double> mFrameTimes;
+	double mShotTotal;
+	double mEnemyTotal;
+	double mItemTotal;
+	double mZoneTotals[LOAD_ZONE_AMOUNT];
+} gLoadGenerator;
+
+static vector<int> parseLoadList(const string& tText) {
+	vector<int> ret;
+	stringstream ss(tText);
+	string value;
+	while (getline(ss, value, ',')) ret.push_back(atoi(value.data()));
+	return ret;
+}
+
+static void addLoadSweeps(const string& tNames) {
+	stringstream ss(tNames);
+	string name;
+	while (getline(ss, name, ',')) {
+		int isFound = 0;
+		for (const auto& sweep : gLoadSweeps) {
+			if (name != "all" && name != sweep.mName) continue;
+			for (int i = 0; i < LOAD_SWEEP_STEP_AMOUNT; i++) {
+				const int value = i ? sweep.mFirstValue << (i - 1) : 0;
+				LoadRun run{ sweep.mName, sweep.mBase };
+				if (sweep.mParameter == LOAD_PARAMETER_ENEMIES) run.mStep.mEnemyAmount = value;
+				else if (sweep.mParameter == LOAD_PARAMETER_BULLETS) run.mStep.mBulletsPerSecond = value;
+				else run.mStep.mItemBurst = value;
+				gLoadGenerator.mRuns.push_back(run);
+			}
+			isFound = 1;
+		}
+		if (!isFound) logWarningFormat("Unknown load sweep %s.", name.data());
+	}
+}
+
+static void addLoadStep(const string& tText) {
+	const auto values = parseLoadList(tText);
+	LoadRun run{ "single", { 0, 0, 0, 0 } };
+	if (values.size() > 0) run.mStep.mEnemyAmount = values[0];
+	if (values.size() > 1) run.mStep.mBulletsPerSecond = values[1];
+	if (values.size() > 2) run.mStep.mItemBurst = values[2];
+	if (values.size() > 3) run.mStep.mIsPlayerFiring = values[3];
+	gLoadGenerator.mRuns.push_back(run);
+}
+
+static void setLoadMix(const string& tText) {
+	const auto values = parseLoadList(tText);
+	for (int i = 0; i < LOAD_SHOT_KIND_AMOUNT; i++) {
+		gLoadGenerator.mMix[i] = i < int(values.size()) ? std::max(0, values[i]) : 0;
+	}
+}
+
+int parseLoadGeneratorArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) {
+		const int hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--load-sweep") && hasValue) {
+			gLoadGenerator.mIsActive = 1;
+			addLoadSweeps(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--load") && hasValue) {
+			gLoadGenerator.mIsActive = 1;
+			addLoadStep(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--load-mix") && hasValue) setLoadMix(argv[++i]);
+		else if (!strcmp(argv[i], "--load-csv") && hasValue) gLoadGenerator.mCSVPath = argv[++i];
+		else if (!strcmp(argv[i], "--frames") && hasValue) gLoadGenerator.mFrameAmount = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && hasValue) gLoadGenerator.mSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (!strcmp(argv[i], "--player") && hasValue) gLoadGenerator.mPlayerName = argv[++i];
+	}
+	return gLoadGenerator.mIsActive;
+}
+
+int isLoadGeneratorActive()
+{
+	return gLoadGenerator.mIsActive;
+}
+
+void startLoadGenerator()
+{
+	if (gLoadGenerator.mRuns.empty()) return;
+
+	gLoadGenerator.mCSV = gLoadGenerator.mCSVPath.empty() ? stdout : fopen(gLoadGenerator.mCSVPath.data(), "w");
+	if (!gLoadGenerator.mCSV) {
+		logWarningFormat("Unable to write load CSV %s.", gLoadGenerator.mCSVPath.data());
+		return;
+	}
+	fprintf(gLoadGenerator.mCSV, "sweep,enemies,bullets_per_second,item_burst,player_firing,live_shots,live_enemies,live_items,live_objects,frame_ms_mean,frame_ms_p99");
+	for (int i = 0; i < LOAD_ZONE_AMOUNT; i++) fprintf(gLoadGenerator.mCSV, ",%s", gLoadZoneColumns[i]);
+	fprintf(gLoadGenerator.mCSV, "\n");
+
+	setProfilerActive(1);
+
+	gGameVars.invinciblePlayer = 1;
+	setLevelScriptActive(0);
+	gLoadGenerator.mCurrentRun = 0;
+	setPlayerName(gLoadGenerator.mPlayerName);
+	setNextGameSeed(gLoadGenerator.mSeed);
+	resetGameAtLevel(0);
+	startScreenHandling(getGameScreen());
+
+	if (gLoadGenerator.mCSV != stdout) fclose(gLoadGenerator.mCSV);
+	gLoadGenerator.mCSV = nullptr;
+}
+
+static Position getRandomLoadPosition(double tMinY, double tMaxY) {
+	return getScreenPositionFromGamePosition(randfrom(0.1, 0.9), randfrom(tMinY, tMaxY), ENEMY_Z);
+}
+
+static void bakeLoadPaths() {
+	gLoadGenerator.mPaths.clear();
+	for (int i = 0; i < LOAD_PATH_AMOUNT; i++) {
+		vector<EnemyPathPoint> path;
+		path.push_back(EnemyPathPoint(getRandomLoadPosition(-0.1, -0.05)));
+		for (int j = 0; j < 3; j++) path.push_back(EnemyPathPoint(getRandomLoadPosition(0.05, 0.6)));
+		path.push_back(EnemyPathPoint(getRandomLoadPosition(1.05, 1.1)));
+		gLoadGenerator.mPaths.push_back(make_unique<LevelEnemy>(path, LOAD_ENEMY_LIFE));
+	}
+}
+
+static const LoadStep& getCurrentLoadStep() {
+	return gLoadGenerator.mRuns[gLoadGenerator.mCurrentRun].mStep;
+}
+
+static void startLoadStep() {
+	removeAllEnemies();
+	removeEnemyBullets();
+	removeAllItems();
+	setGameInputConstant(getCurrentLoadStep().mIsPlayerFiring ? GAME_BUTTON_A : 0);
+
+	gLoadGenerator.mBulletCredit = 0;
+	gLoadGenerator.mFrameTimes.clear();
+	gLoadGenerator.mShotTotal = gLoadGenerator.mEnemyTotal = gLoadGenerator.mItemTotal = 0;
+	for (auto& total : gLoadGenerator.mZoneTotals) total = 0;
+}
+
+static void finishLoadStep() {
+	const auto& run = gLoadGenerator.mRuns[gLoadGenerator.mCurrentRun];
+	const auto& times = gLoadGenerator.mFrameTimes;
+	double total = 0;
+	for (auto time : times) total += time;
+	const double frameAmount = std::max(1, gLoadGenerator.mFrameAmount);
+	const double sampleAmount = std::max(1.0, double(times.size()));
+	const double shots = gLoadGenerator.mShotTotal / frameAmount;
+	const double enemies = gLoadGenerator.mEnemyTotal / frameAmount;
+	const double items = gLoadGenerator.mItemTotal / frameAmount;
+
+	fprintf(gLoadGenerator.mCSV, "%s,%d,%d,%d,%d,%.1f,%.1f,%.1f,%.1f,%.4f,%.4f", run.mSweep.data(), run.mStep.mEnemyAmount, run.mStep.mBulletsPerSecond, run.mStep.mItemBurst, run.mStep.mIsPlayerFiring,
+		shots, enemies, items, shots + enemies + items, total / sampleAmount, getFrameTimePercentile(times, 0.99));
+	for (int i = 0; i < LOAD_ZONE_AMOUNT; i++) fprintf(gLoadGenerator.mCSV, ",%.4f", gLoadGenerator.mZoneTotals[i] / frameAmount);
+	fprintf(gLoadGenerator.mCSV, "\n");
+	fflush(gLoadGenerator.mCSV);
+
+	gLoadGenerator.mCurrentRun++;
+	gLoadGenerator.mFrame = 0;
+	if (gLoadGenerator.mCurrentRun >= gLoadGenerator.mRuns.size()) {
+		gLoadGenerator.mIsOver = 1;
+		abortScreenHandling();
+	}
+}
+
+static void updateLoadEnemies(const LoadStep& tStep) {
+	while (getActiveEnemyAmount() < tStep.mEnemyAmount) {
+		addActiveEnemy(gLoadGenerator.mPaths[gLoadGenerator.mNextPath].get());
+		gLoadGenerator.mNextPath = (gLoadGenerator.mNextPath + 1) % LOAD_PATH_AMOUNT;
+	}
+}
+
+static LoadShotKind getRandomLoadShotKind() {
+	int total = 0;
+	for (int i = 0; i < LOAD_SHOT_KIND_AMOUNT; i++) total += gLoadGenerator.mMix[i];
+	if (!total) return LOAD_SHOT_STRAIGHT;
+
+	int value = randfromInteger(0, total - 1);
+	for (int i = 0; i < LOAD_SHOT_KIND_AMOUNT; i++) {
+		if (value < gLoadGenerator.mMix[i]) return LoadShotKind(i);
+		value -= gLoadGenerator.mMix[i];
+	}
+	return LOAD_SHOT_STRAIGHT;
+}
+
+static void updateLoadBullets(const LoadStep& tStep) {
+	gLoadGenerator.mBulletCredit += tStep.mBulletsPerSecond / 60.0;
+	if (gLoadGenerator.mBulletCredit < 1) return;
+
+	auto& emitters = gLoadGenerator.mEmitters;
+	getActiveEnemies(emitters);
+	while (gLoadGenerator.mBulletCredit >= 1) {
+		gLoadGenerator.mBulletCredit--;
+		LoadShotKind kind = getRandomLoadShotKind();
+
+		ActiveEnemy* emitter = emitters.empty() ? nullptr : emitters[randfromInteger(0, int(emitters.size()) - 1)];
+		Position position;
+		if (emitter) position = getBlitzEntityPosition(emitter->mEntityID);
+		if (!emitter || !isInGameScreen(position)) {
+			emitter = nullptr;
+			position = getRandomLoadPosition(0.05, 0.1);
+			if (kind == LOAD_SHOT_LASER) kind = LOAD_SHOT_STRAIGHT;
+		}
+		addShot(emitter, position, gLoadShotNames[kind], getEnemyShotCollisionList());
+	}
+}
+
+static void updateLoadItems(const LoadStep& tStep) {
+	if (!tStep.mItemBurst || gLoadGenerator.mFrame % LOAD_ITEM_BURST_INTERVAL) return;
+	addScoreItems(getRandomLoadPosition(0.1, 0.4), tStep.mItemBurst);
+}
+
+static void loadLoadGeneratorRunner(void* tData) {
+	(void)tData;
+	bakeLoadPaths();
+	gLoadGenerator.mFrame = 0;
+	gLoadGenerator.mIsOver = 0;
+	gLoadGenerator.mNextPath = 0;
+	gLoadGenerator.mFrameTimes.reserve(gLoadGenerator.mFrameAmount);
+	setGimmickStatsRunName("load generator");
+}
+
+static void unloadLoadGeneratorRunner(void* tData) {
+	(void)tData;
+	gLoadGenerator.mEmitters.clear();
+	if (!gLoadGenerator.mIsOver) {
+		logWarning("Load generator left the game screen early.");
+		gLoadGenerator.mIsOver = 1;
+		abortScreenHandling();
+	}
+}
+
+static void updateLoadGeneratorRunner(void* tData) {
+	(void)tData;
+	if (gLoadGenerator.mIsOver) return;
+
+	const auto now = chrono::steady_clock::now();
+	if (!gLoadGenerator.mFrame) {
+		startLoadStep();
+	}
+	else if (gLoadGenerator.mFrame > LOAD_WARMUP_FRAMES) {
+		if (!gLoadGenerator.mHasDrawn) gLoadGenerator.mFrameTimes.push_back(chrono::duration<double, milli>(now - gLoadGenerator.mLastUpdateTime).count());
+		gLoadGenerator.mShotTotal += getActiveShotAmount();
+		gLoadGenerator.mEnemyTotal += getActiveEnemyAmount();
+		gLoadGenerator.mItemTotal += getActiveItemAmount();
+		for (int i = 0; i < LOAD_ZONE_AMOUNT; i++) gLoadGenerator.mZoneTotals[i] += getProfileZoneMilliseconds(gLoadZones[i]);
+	}
+	gLoadGenerator.mLastUpdateTime = now;
+	gLoadGenerator.mHasDrawn = 0;
+
+	const auto& step = getCurrentLoadStep();
+	updateLoadEnemies(step);
+	updateLoadBullets(step);
+	updateLoadItems(step);
+
+	gLoadGenerator.mFrame++;
+	if (gLoadGenerator.mFrame > LOAD_WARMUP_FRAMES + gLoadGenerator.mFrameAmount) finishLoadStep();
+}
+
+// Marks the draw and vsync the wrapper does between two batches of headless updates, so that gap is not sampled as a frame.
+static void drawLoadGeneratorRunner(void* tData) {
+	(void)tData;
+	if (isHeadless()) gLoadGenerator.mHasDrawn = 1;
+}
+
+ActorBlueprint getLoadGeneratorRunner()
+{
+	return makeActorBlueprint(loadLoadGeneratorRunner, unloadLoadGeneratorRunner, updateLoadGeneratorRunner, drawLoadGeneratorRunner);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <prism/actorhandler.h>
+
+int parseLoadGeneratorArguments(int argc, char** argv);
+int isLoadGeneratorActive();
+void startLoadGenerator();
+
+ActorBlueprint getLoadGeneratorRunner();
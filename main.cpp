@@ -1,3 +1,5 @@
+#include <stdlib.h>
+
 #include <prism/framerateselectscreen.h>
 #include <prism/pvr.h>
 #include <prism/physics.h>
@@ -15,6 +17,16 @@
 #include "menuscreen.h"
 #include "player.h"
 #include "storyscreen.h"
+#include "allocationtracker.h"
+#include "assetpack.h"
+#include "bootloader.h"
+#include "headless.h"
+#include "benchmark.h"
+#include "gimmickstats.h"
+#include "loadgenerator.h"
+#include "profiler.h"
+#include "replay.h"
+#include "statehash.h"
 
 #ifdef DREAMCAST
 KOS_INIT_FLAGS(INIT_DEFAULT);
@@ -47,6 +59,7 @@ void setMainFileSystem() {
 #else
 	setFileSystem("/cd");
 #endif
+	mountAssetPack("ASSETS.PAK");
 }
 
 int isInDevelopMode() {
@@ -58,13 +71,17 @@ int isInDevelopMode() {
 }
 
 int main(int argc, char** argv) {
-	(void)argc;
-	(void)argv;
+	const int isSimulationRun = parseHeadlessArguments(argc, argv) | parseReplayArguments(argc, argv) | parseBenchmarkArguments(argc, argv) | parseLoadGeneratorArguments(argc, argv);
+	parseStateHashArguments(argc, argv);
+	parseProfilerArguments(argc, argv);
+	parseGimmickStatsArguments(argc, argv);
+	parseAllocationProfileArguments(argc, argv);
 
 	setGameName("Yotsubahou Reiiden ~ Crisis of Western Oriental Land");
 	setScreenSize(320, 240);
 	
 	setMainFileSystem();
+	startBootLoading();
 	initPrismWrapperWithConfigFile("data/config.cfg");
 	setFont("$/rd/fonts/segoe.hdr", "$/rd/fonts/segoe.pkg");
 
@@ -72,6 +89,15 @@ int main(int argc, char** argv) {
 	addMugenFont(2, "font/segoe.def");
 	addMugenFont(3, "font/f6x9.fnt");
 	addMugenFont(4, "font/jg.fnt");
+	if (isSimulationRun) {
+		startHeadlessSimulation();
+		const int exitCode = hasBenchmarkRegressions();
+		writeProfilerTrace();
+		// exitGame ends the process without a status, so the regression result would be lost
+		shutdownPrismWrapper();
+		exit(exitCode);
+	}
+
 	logg("Check framerate");
 	FramerateSelectReturnType framerateReturnType = selectFramerate();
 	if (framerateReturnType == FRAMERATE_SCREEN_RETURN_ABORT) {
@@ -94,6 +120,7 @@ int main(int argc, char** argv) {
 	setScreenAfterWrapperLogoScreen(getLogoScreenFromWrapper());
 	startScreenHandling(getWarningScreen());
 
+	writeProfilerTrace();
 	exitGame();
 	
 	return 0;
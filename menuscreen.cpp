@@ -1,9 +1,14 @@
 #include "menuscreen.h"
 
+#include <algorithm>
 #include <prism/blitz.h>
 #include "debug.h"
 #include "enemyhandler.h"
 #include "player.h"
+#include "resourcecache.h"
+#include "assetprefetch.h"
+#include "dialoghandler.h"
+#include "bootloader.h"
 
 class MenuScreen {
 
@@ -34,10 +39,17 @@ public:
 	int mUnfocusedText;
 	int mBombTitleText;
 	int mBombText;
+
+	vector<string> mWarmupQueue;
+	vector<string> mWarmedUpFiles;
+
 	MenuScreen()
 	{
-		mSprites = loadMugenSpriteFileWithoutPalette("title/TITLE.sff");
-		mAnimations = loadMugenAnimationFile("title/TITLE.air");
+		purgeUnreferencedCachedResources();
+		prefetchCommonGameplayAssets();
+
+		mSprites = loadPrefetchedMugenSpriteFileWithoutPalette("title/TITLE.sff");
+		mAnimations = loadPrefetchedMugenAnimationFile("title/TITLE.air");
 		mTimelineAnimations = loadBlitzTimelineAnimations("title/TITLE.taf");
 
 		mBGEntity = addBlitzEntity(makePosition(0, 0, 1));
@@ -85,7 +97,88 @@ public:
 	}
 
 	~MenuScreen() {
+		for (auto& path : mWarmedUpFiles) {
+			releaseCachedFile(path);
+		}
+	}
+
+	static int isSpriteFilePath(const string& tPath) {
+		return tPath.size() >= 4 && tPath.compare(tPath.size() - 4, 4, ".sff") == 0;
+	}
 
+	static int isSpriteAtlasPath(const string& tPath) {
+		return tPath.size() >= 4 && tPath.compare(tPath.size() - 4, 4, ".atl") == 0;
+	}
+
+	static void acquireCachedFile(const string& tPath) {
+		if (isSpriteFilePath(tPath)) acquireCachedMugenSpriteFile(tPath);
+		else if (isSpriteAtlasPath(tPath)) acquireCachedSpriteAtlas(tPath);
+		else acquireCachedMugenAnimationFile(tPath);
+	}
+
+	static void releaseCachedFile(const string& tPath) {
+		if (isSpriteFilePath(tPath)) releaseCachedMugenSpriteFile(tPath);
+		else if (isSpriteAtlasPath(tPath)) releaseCachedSpriteAtlas(tPath);
+		else releaseCachedMugenAnimationFile(tPath);
+	}
+
+	static int isFileCached(const string& tPath) {
+		if (isSpriteFilePath(tPath)) return isMugenSpriteFileCached(tPath);
+		if (isSpriteAtlasPath(tPath)) return isSpriteAtlasCached(tPath);
+		return isMugenAnimationFileCached(tPath);
+	}
+
+	void prefetchCachedFile(const string& tPath) {
+		if (find(mWarmedUpFiles.begin(), mWarmedUpFiles.end(), tPath) != mWarmedUpFiles.end()) return;
+		if (find(mWarmupQueue.begin(), mWarmupQueue.end(), tPath) != mWarmupQueue.end()) return;
+
+		if (isFileCached(tPath)) {
+			acquireCachedFile(tPath);
+			mWarmedUpFiles.push_back(tPath);
+			return;
+		}
+
+		prefetchAssetFile(tPath);
+		mWarmupQueue.push_back(tPath);
+	}
+
+	void prefetchCommonGameplayAssets() {
+		prefetchCachedFile("data/SHOTS.sff");
+		prefetchCachedFile("data/SHOTS.air");
+		prefetchCachedFile("data/UI.sff");
+		prefetchCachedFile("data/UI.air");
+		prefetchCachedFile("level/ENEMY.sff");
+		prefetchCachedFile("level/ENEMY.air");
+		prefetchCachedFile("data/SPRITES.atl");
+		prefetchLevelAssets(0);
+	}
+
+	void prefetchLevelAssets(int tLevel) {
+		stringstream ss;
+		ss << "level/LEVEL" << tLevel;
+		prefetchAssetFile(ss.str() + ".txt");
+		prefetchAssetFile(ss.str() + ".sff");
+		prefetchAssetFile(ss.str() + ".air");
+	}
+
+	void prefetchSelectedCharacterAssets() {
+		const string& name = mNames[mSelectedCharacter];
+		prefetchCachedFile("player/" + name + ".sff");
+		prefetchCachedFile("player/" + name + ".air");
+		prefetchAssetFile(getDialogFilePath(name, mSelected == 0 ? 0 : 5));
+	}
+
+	// Decodes at most one finished file per frame into the resource cache, so the menu keeps animating.
+	void updateAssetWarmup() {
+		for (size_t i = 0; i < mWarmupQueue.size(); i++) {
+			const string path = mWarmupQueue[i];
+			if (!isAssetFilePrefetched(path)) continue;
+
+			acquireCachedFile(path);
+			mWarmedUpFiles.push_back(path);
+			mWarmupQueue.erase(mWarmupQueue.begin() + i);
+			return;
+		}
 	}
 
 	void addOption(int& tEntityID, int animation, Position tPos)
@@ -139,6 +232,8 @@ public:
 		playBlitzTimelineAnimation(mSelectors[1], 600);
 
 		setTextActive();
+		if (mSelected == 1) prefetchLevelAssets(5);
+		prefetchSelectedCharacterAssets();
 
 		mIsSelectingCharacter = 1;
 	}
@@ -225,6 +320,7 @@ public:
 		playBlitzTimelineAnimation(mOtherCharacterID, 702);
 		playBlitzTimelineAnimation(mCharacterID, 701);
 		setTextActive();
+		prefetchSelectedCharacterAssets();
 	}
 
 	void updateCharacterDown()
@@ -238,9 +334,13 @@ public:
 		playBlitzTimelineAnimation(mOtherCharacterID, 700);
 		playBlitzTimelineAnimation(mCharacterID, 703);
 		setTextActive();
+		prefetchSelectedCharacterAssets();
 	}
 
 	void update() {
+		reportBootTitleInteractive();
+		updateAssetWarmup();
+
 		if (!mIsSelectingCharacter) {
 			if (hasPressedUpFlank())
 			{
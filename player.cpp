@@ -11,6 +11,10 @@
 #include "dialoghandler.h"
 #include "uihandler.h"
 #include "inmenu.h"
+#include "resourcecache.h"
+#include "gameinput.h"
+#include "statehash.h"
+#include "profiler.h"
 
 #define PLAYER_Z 8
 #define BOMB_Z 7
@@ -21,8 +25,8 @@ struct PlayerHandler {
 	static PlayerFuncs::PlayerEnum mEnum;
 	static PlayerHandler* mSelf;
 
-	MugenSpriteFile mSprites;
-	MugenAnimations mAnimations;
+	MugenSpriteFile* mSprites;
+	MugenAnimations* mAnimations;
 
 	int mEntityID;
 	int mHitboxIndicator;
@@ -52,12 +56,12 @@ struct PlayerHandler {
 
 	PlayerHandler() {
 		mSelf = this;
-		mSprites = loadMugenSpriteFileWithoutPalette("player/" + mName + ".sff");
-		mAnimations = loadMugenAnimationFile("player/" + mName + ".air");
+		mSprites = acquireCachedMugenSpriteFile("player/" + mName + ".sff");
+		mAnimations = acquireCachedMugenAnimationFile("player/" + mName + ".air");
 
 		Position startPos = gGameVars.gameScreenOffset + (gGameVars.gameScreen / 2.0);
 		mEntityID = addBlitzEntity(makePosition(startPos.x, 220, PLAYER_Z));
-		addBlitzMugenAnimationComponent(mEntityID, &mSprites, &mAnimations, 1);
+		addBlitzMugenAnimationComponent(mEntityID, mSprites, mAnimations, 1);
 		setBlitzMugenAnimationBaseDrawScale(mEntityID, 0.5);
 		addBlitzPhysicsComponent(mEntityID);
 		addBlitzCollisionComponent(mEntityID);
@@ -65,7 +69,7 @@ struct PlayerHandler {
 		addBlitzCollisionCB(mEntityID, collisionID, playerHitCB, NULL);
 		collisionID = addBlitzCollisionCirc(mEntityID, getPlayerCollectionList(), makeCollisionCirc(makePosition(0, 0, 0), 5));
 
-		mHitboxIndicator = addMugenAnimation(getMugenAnimation(&mAnimations, 1000), &mSprites, getBlitzEntityPosition(mEntityID));
+		mHitboxIndicator = addMugenAnimation(getMugenAnimation(mAnimations, 1000), mSprites, getBlitzEntityPosition(mEntityID));
 		setMugenAnimationVisibility(mHitboxIndicator, 0);
 
 		mShotFrequencyNow = 0;
@@ -76,6 +80,11 @@ struct PlayerHandler {
 		recalculateNextScore();
 	}
 
+	~PlayerHandler() {
+		releaseCachedMugenSpriteFile("player/" + mName + ".sff");
+		releaseCachedMugenAnimationFile("player/" + mName + ".air");
+	}
+
 	void addPlayerShotInternal() {
 		stringstream ss;
 		if (mEnum == PlayerFuncs::PLAYER_YOURNAMEHERE) {
@@ -146,7 +155,7 @@ struct PlayerHandler {
 
 	static void playerHitCB(void* tCaller, void* tCollisionData) {
 		(void)tCaller;
-		if (mSelf->mIsInvincible) return;
+		if (mSelf->mIsInvincible || gGameVars.invinciblePlayer) return;
 
 		if (mSelf->mDeathBombNow < 0) {
 			mSelf->mDeathBombNow = 5;
@@ -157,7 +166,7 @@ struct PlayerHandler {
 		int shotFrequency = mIsFocused ? 5 : 5;
 
 		mShotFrequencyNow = std::max(0, mShotFrequencyNow - 1);
-		if (hasPressedA() && !mShotFrequencyNow) {
+		if (hasGamePressedA() && !mShotFrequencyNow) {
 			addPlayerShotInternal();
 			mShotFrequencyNow = shotFrequency;
 		}
@@ -165,16 +174,16 @@ struct PlayerHandler {
 
 	void updatePlayerMovement() {
 		double speed = mIsFocused ? 1 : 2;
-		if (hasPressedLeft()) {
+		if (hasGamePressedLeft()) {
 			addBlitzEntityPositionX(mEntityID, -speed);
 		}
-		else if (hasPressedRight()) {
+		else if (hasGamePressedRight()) {
 			addBlitzEntityPositionX(mEntityID, speed);
 		}
-		if (hasPressedUp()) {
+		if (hasGamePressedUp()) {
 			addBlitzEntityPositionY(mEntityID, -speed);
 		}
-		else if (hasPressedDown()) {
+		else if (hasGamePressedDown()) {
 			addBlitzEntityPositionY(mEntityID, speed);
 		}
 
@@ -183,7 +192,7 @@ struct PlayerHandler {
 	}
 
 	void updateFocus() {
-		mIsFocused = hasPressedR();
+		mIsFocused = hasGamePressedR();
 	}
 
 	void updateHitboxIndicator() {
@@ -223,7 +232,7 @@ struct PlayerHandler {
 
 		for (int i = 0; i < 3; i++)
 		{
-			addBlitzMugenAnimationComponent(mBroomEntityID[i], &mSprites, &mAnimations, 10);
+			addBlitzMugenAnimationComponent(mBroomEntityID[i], mSprites, mAnimations, 10);
 			addBlitzPhysicsComponent(mBroomEntityID[i]);
 			addBlitzPhysicsVelocityY(mBroomEntityID[i], -1);
 			addBlitzEntityRotationZ(mBroomEntityID[i], M_PI);
@@ -266,7 +275,7 @@ struct PlayerHandler {
 	void setKinomodBombActive()
 	{
 		mLockEntity = addBlitzEntity(getScreenPositionFromGamePosition(0.5, 0.4, BOMB_Z));
-		addBlitzMugenAnimationComponent(mLockEntity, &mSprites, &mAnimations, 10);
+		addBlitzMugenAnimationComponent(mLockEntity, mSprites, mAnimations, 10);
 
 		mBombDuration = 200;
 	}
@@ -276,7 +285,7 @@ struct PlayerHandler {
 		if (mBombNow == 24)
 		{
 			mLockedEntity = addBlitzEntity(getScreenPositionFromGamePosition(0.5, 0.4, BOMB_Z));
-			addBlitzMugenAnimationComponent(mLockedEntity, &mSprites, &mAnimations, 11);
+			addBlitzMugenAnimationComponent(mLockedEntity, mSprites, mAnimations, 11);
 
 			addBombDamage(600);
 		}
@@ -293,7 +302,7 @@ struct PlayerHandler {
 	void setAeroliteBombActive()
 	{
 		mGorillaEntity = addBlitzEntity(getScreenPositionFromGamePosition(0.5, 1.0, BOMB_Z) + makePosition(0, 146, 0));
-		addBlitzMugenAnimationComponent(mGorillaEntity, &mSprites, &mAnimations, 10);
+		addBlitzMugenAnimationComponent(mGorillaEntity, mSprites, mAnimations, 10);
 		addBlitzPhysicsComponent(mGorillaEntity);
 		addBlitzPhysicsVelocityY(mGorillaEntity, -1);
 
@@ -303,7 +312,7 @@ struct PlayerHandler {
 	void addAeroliteLaser(int& entityID, Position tPos)
 	{
 		entityID = addBlitzEntity(tPos);
-		addBlitzMugenAnimationComponent(entityID, &mSprites, &mAnimations, 11);
+		addBlitzMugenAnimationComponent(entityID, mSprites, mAnimations, 11);
 		
 	}
 
@@ -405,7 +414,7 @@ struct PlayerHandler {
 	void updatePlayerBombSetActive() {
 		if (mIsBombActive) return;
 
-		if (mBombAmount && hasPressedBFlank()) {
+		if (mBombAmount && hasGamePressedBFlank()) {
 			setPlayerBombActive();
 
 			mDeathBombNow = -1;
@@ -434,6 +443,19 @@ struct PlayerHandler {
 		mBombNow++;
 	}
 
+	// Puts the player back into the state of a fresh level without reloading the resources the constructor loaded.
+	void resetForLevel() {
+		Position startPos = gGameVars.gameScreenOffset + (gGameVars.gameScreen / 2.0);
+		setBlitzEntityPosition(mEntityID, makePosition(startPos.x, 220, PLAYER_Z));
+
+		mShotFrequencyNow = 0;
+
+		if (mIsBombActive) removePlayerBomb();
+		mIsBombActive = 0;
+		mIsInvincible = 0;
+		mDeathBombNow = -1;
+	}
+
 	void updatePlayerAutocollect() {
 		Position collectPosition = getScreenPositionFromGamePosition(0, 0.2, 0);
 		Position p = getBlitzEntityPosition(mEntityID);
@@ -458,6 +480,7 @@ struct PlayerHandler {
 	}
 
 	void update() {
+		ProfileScope profileScope(PROFILE_ZONE_PLAYER);
 		updateFocus();
 		updatePlayerMovement();
 		if (!isDialogActive()) updatePlayerShot();
@@ -508,12 +531,12 @@ PlayerFuncs::PlayerEnum getPlayerEnumValue()
 
 MugenSpriteFile* getPlayerSprites()
 {
-	return &gPlayerHandler->mSprites;
+	return gPlayerHandler->mSprites;
 }
 
 MugenAnimations * getPlayerAnimations()
 {
-	return &gPlayerHandler->mAnimations;
+	return gPlayerHandler->mAnimations;
 }
 
 int getPlayerPower()
@@ -568,6 +591,24 @@ void addPlayerBomb()
 	gPlayerHandler->mBombAmount++;
 }
 
+void addPlayerStateHash(StateHash& oHash)
+{
+	auto player = gPlayerHandler;
+	addStateHashPosition(oHash, getBlitzEntityPosition(player->mEntityID));
+	addStateHashInt(oHash, player->mPower);
+	addStateHashInt(oHash, int64_t(player->mScore));
+	addStateHashInt(oHash, player->mLife);
+	addStateHashInt(oHash, player->mBombAmount);
+	addStateHashInt(oHash, player->mItemAmount);
+	addStateHashInt(oHash, player->mIsFocused);
+	addStateHashInt(oHash, player->mShotFrequencyNow);
+	addStateHashInt(oHash, player->mIsInvincible);
+	addStateHashInt(oHash, player->mInvincibleNow);
+	addStateHashInt(oHash, player->mIsBombActive);
+	addStateHashInt(oHash, player->mBombNow);
+	addStateHashInt(oHash, player->mDeathBombNow);
+}
+
 int getPlayerEntity()
 {
 	return gPlayerHandler->mEntityID;
@@ -603,6 +644,11 @@ void resetPlayer()
 	}
 }
 
+void resetPlayerForLevel()
+{
+	gPlayerHandler->resetForLevel();
+}
+
 void usePlayerContinue()
 {
 	gPlayerHandler->mContinues--;
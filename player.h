@@ -33,7 +33,11 @@ int getPlayerEntity();
 int isPlayerBombActive();
 int getContinueAmount();
 void resetPlayer();
+void resetPlayerForLevel();
 void usePlayerContinue();
 
 int getCollectedItemAmount();
-int getNextItemLifeUpAmount();
\ No newline at end of file
+int getNextItemLifeUpAmount();
+
+struct StateHash;
+void addPlayerStateHash(StateHash& oHash);
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include "profiler.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <prism/log.h>
+#include <prism/mugentexthandler.h>
+
+#include "allocationtracker.h"
+
+using namespace std;
+
+// Hierarchical frame profiler. Started with --profile FILE, which writes a Chrome trace (chrome://tracing, Perfetto) to FILE
+// at exit, and/or --profile-overlay, which shows the milliseconds per system next to the game screen.
+// Every gameplay actor opens a zone with ProfileScope in its update and draw, zones nest on a small stack and a closed zone
+// is written as one complete event into a fixed ring buffer. The ring buffer only uses an atomic write index and a sequence
+// per slot, so it never locks and the trace keeps the last PROFILER_EVENT_AMOUNT events.
+// Collision, physics and the drawing of animations and texts happen inside Prism and cannot be wrapped from here. The frame
+// begin actor is the first and the frame end actor the last actor of the game screen, so the time between the end of the
+// gameplay updates and the first gameplay draw is "prism draw", and the time from the last gameplay draw (or update when
+// nothing is drawn, like in headless runs) to the next frame is "prism update", which holds the collision pass. With
+// drawing on it also holds the buffer swap and the wait for vsync.
+// When the profiler is off a zone costs one branch.
+// The innermost zone is handed to the allocation tracker, which attributes allocations to it with --alloc-profile.
+
+#define PROFILER_EVENT_AMOUNT (1 << 16)
+#define PROFILER_STACK_SIZE 16
+#define PROFILER_OVERLAY_FRAMES 30
+#define PROFILER_OVERLAY_X 212
+#define PROFILER_OVERLAY_Y 150
+#define PROFILER_OVERLAY_LINE_HEIGHT 7
+#define PROFILER_OVERLAY_Z 90
+
+struct ProfileEvent {
+	atomic<uint64_t> mSequence;
+	int mZone;
+	int mDepth;
+	int64_t mStart;
+	int64_t mDuration;
+};
+
+struct ProfileStackEntry {
+	ProfileZone mZone;
+	int64_t mStart;
+};
+
+static const char* gProfileZoneNames[] = {
+	"frame",
+	"update",
+	"input",
+	"ui",
+	"dialog",
+	"boss",
+	"items",
+	"enemies",
+	"level",
+	"player",
+	"bullet animation",
+	"shots",
+	"state hash",
+	"draw",
+	"draw ui",
+	"draw enemies",
+	"draw bullets",
+	"prism draw",
+	"prism update",
+	"other",
+};
+
+static const ProfileZone gOverlayZones[] = {
+	PROFILE_ZONE_FRAME,
+	PROFILE_ZONE_UPDATE,
+	PROFILE_ZONE_SHOTS,
+	PROFILE_ZONE_ENEMIES,
+	PROFILE_ZONE_BOSS,
+	PROFILE_ZONE_ITEMS,
+	PROFILE_ZONE_PLAYER,
+	PROFILE_ZONE_PRISM_UPDATE,
+	PROFILE_ZONE_DRAW,
+	PROFILE_ZONE_PRISM_DRAW,
+};
+
+#define PROFILER_OVERLAY_LINE_AMOUNT int(sizeof(gOverlayZones) / sizeof(gOverlayZones[0]))
+
+static struct {
+	int mIsActive = 0;
+	int mHasOverlay = 0;
+	string mTracePath;
+	chrono::steady_clock::time_point mStartTime = chrono::steady_clock::now();
+
+	ProfileEvent* mEvents = nullptr;
+	atomic<uint64_t> mWriteIndex;
+
+	ProfileStackEntry mStack[PROFILER_STACK_SIZE];
+	int mStackSize;
+
+	int mHasFrame;
+	int mHasDraw;
+	int64_t mFrameStart;
+	int64_t mUpdateEnd;
+	int64_t mDrawBegin;
+	int64_t mDrawEnd;
+	int64_t mFrameTimes[PROFILE_ZONE_AMOUNT];
+	int64_t mLastFrameTimes[PROFILE_ZONE_AMOUNT];
+
+	int mOverlayTextIDs[PROFILER_OVERLAY_LINE_AMOUNT];
+	int64_t mOverlayTimes[PROFILE_ZONE_AMOUNT];
+	int mOverlayFrames;
+} gProfiler;
+
+static int64_t getProfilerTime() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - gProfiler.mStartTime).count();
+}
+
+static void addProfileEvent(ProfileZone tZone, int tDepth, int64_t tStart, int64_t tDuration) {
+	gProfiler.mFrameTimes[tZone] += tDuration;
+	if (!gProfiler.mEvents) return;
+
+	const uint64_t index = gProfiler.mWriteIndex.fetch_add(1, memory_order_relaxed);
+	ProfileEvent& event = gProfiler.mEvents[index % PROFILER_EVENT_AMOUNT];
+	event.mSequence.store(0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	event.mZone = tZone;
+	event.mDepth = tDepth;
+	event.mStart = tStart;
+	event.mDuration = tDuration;
+	event.mSequence.store(index + 1, memory_order_release);
+}
+
+static int readProfileEvent(uint64_t tIndex, ProfileEvent& oEvent) {
+	const ProfileEvent& event = gProfiler.mEvents[tIndex % PROFILER_EVENT_AMOUNT];
+	if (event.mSequence.load(memory_order_acquire) != tIndex + 1) return 0;
+	oEvent.mZone = event.mZone;
+	oEvent.mDepth = event.mDepth;
+	oEvent.mStart = event.mStart;
+	oEvent.mDuration = event.mDuration;
+	atomic_thread_fence(memory_order_acquire);
+	return event.mSequence.load(memory_order_relaxed) == tIndex + 1;
+}
+
+int parseProfilerArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--profile") && i + 1 < argc) gProfiler.mTracePath = argv[++i];
+		else if (!strcmp(argv[i], "--profile-overlay")) gProfiler.mHasOverlay = 1;
+	}
+	if (!gProfiler.mTracePath.empty()) {
+		gProfiler.mEvents = new ProfileEvent[PROFILER_EVENT_AMOUNT];
+		for (int i = 0; i < PROFILER_EVENT_AMOUNT; i++) gProfiler.mEvents[i].mSequence.store(0, memory_order_relaxed);
+		gProfiler.mWriteIndex.store(0, memory_order_relaxed);
+	}
+	gProfiler.mIsActive = gProfiler.mEvents || gProfiler.mHasOverlay;
+	return gProfiler.mIsActive;
+}
+
+int isProfilerActive()
+{
+	return gProfiler.mIsActive;
+}
+
+void setProfilerActive(int tIsActive)
+{
+	gProfiler.mIsActive = tIsActive;
+}
+
+void writeProfilerTrace()
+{
+	if (!gProfiler.mEvents) return;
+
+	FILE* file = fopen(gProfiler.mTracePath.data(), "w");
+	if (!file) {
+		logWarningFormat("Unable to write profiler trace %s.", gProfiler.mTracePath.data());
+		return;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"game\"}}");
+	const uint64_t end = gProfiler.mWriteIndex.load(memory_order_acquire);
+	const uint64_t start = end > PROFILER_EVENT_AMOUNT ? end - PROFILER_EVENT_AMOUNT : 0;
+	ProfileEvent event;
+	for (uint64_t i = start; i < end; i++) {
+		if (!readProfileEvent(i, event)) continue;
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"depth%d\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}", gProfileZoneNames[event.mZone], event.mDepth, event.mStart / 1000.0, event.mDuration / 1000.0);
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+}
+
+ProfileScope::ProfileScope(ProfileZone tZone)
+{
+	beginProfileZone(tZone);
+}
+
+ProfileScope::~ProfileScope()
+{
+	endProfileZone();
+}
+
+void beginProfileZone(ProfileZone tZone)
+{
+	if (!gProfiler.mIsActive) return;
+	if (gProfiler.mStackSize >= PROFILER_STACK_SIZE) {
+		gProfiler.mStackSize++;
+		return;
+	}
+
+	gProfiler.mStack[gProfiler.mStackSize].mZone = tZone;
+	gProfiler.mStack[gProfiler.mStackSize].mStart = getProfilerTime();
+	gProfiler.mStackSize++;
+	setAllocationZone(tZone);
+}
+
+void endProfileZone()
+{
+	if (!gProfiler.mIsActive || !gProfiler.mStackSize) return;
+	gProfiler.mStackSize--;
+	if (gProfiler.mStackSize >= PROFILER_STACK_SIZE) return;
+
+	const auto& entry = gProfiler.mStack[gProfiler.mStackSize];
+	addProfileEvent(entry.mZone, gProfiler.mStackSize + 1, entry.mStart, getProfilerTime() - entry.mStart);
+	setAllocationZone(getActiveProfileZone());
+}
+
+int getActiveProfileZone()
+{
+	if (!gProfiler.mStackSize) return PROFILE_ZONE_AMOUNT;
+	return gProfiler.mStack[std::min(gProfiler.mStackSize, PROFILER_STACK_SIZE) - 1].mZone;
+}
+
+const char* getProfileZoneName(int tZone)
+{
+	return gProfileZoneNames[tZone];
+}
+
+double getProfileZoneMilliseconds(ProfileZone tZone)
+{
+	return gProfiler.mLastFrameTimes[tZone] / 1000000.0;
+}
+
+static void loadProfilerFrameBegin(void* tData) {
+	(void)tData;
+	gProfiler.mHasFrame = 0;
+	gProfiler.mStackSize = 0;
+	setAllocationZone(PROFILE_ZONE_AMOUNT);
+	memset(gProfiler.mLastFrameTimes, 0, sizeof(gProfiler.mLastFrameTimes));
+}
+
+static void finishProfilerFrame(int64_t tNow) {
+	if (gProfiler.mHasDraw) {
+		addProfileEvent(PROFILE_ZONE_PRISM_DRAW, 1, gProfiler.mUpdateEnd, gProfiler.mDrawBegin - gProfiler.mUpdateEnd);
+		addProfileEvent(PROFILE_ZONE_PRISM_UPDATE, 1, gProfiler.mDrawEnd, tNow - gProfiler.mDrawEnd);
+	}
+	else {
+		addProfileEvent(PROFILE_ZONE_PRISM_UPDATE, 1, gProfiler.mUpdateEnd, tNow - gProfiler.mUpdateEnd);
+	}
+	addProfileEvent(PROFILE_ZONE_FRAME, 0, gProfiler.mFrameStart, tNow - gProfiler.mFrameStart);
+
+	for (int i = 0; i < PROFILE_ZONE_AMOUNT; i++) {
+		gProfiler.mLastFrameTimes[i] = gProfiler.mFrameTimes[i];
+		gProfiler.mOverlayTimes[i] += gProfiler.mFrameTimes[i];
+	}
+	gProfiler.mOverlayFrames++;
+	addAllocationProfileFrame();
+}
+
+static void updateProfilerFrameBegin(void* tData) {
+	(void)tData;
+	if (!gProfiler.mIsActive) return;
+
+	const int64_t now = getProfilerTime();
+	if (gProfiler.mHasFrame) finishProfilerFrame(now);
+	else startAllocationProfileRun();
+	memset(gProfiler.mFrameTimes, 0, sizeof(gProfiler.mFrameTimes));
+	gProfiler.mHasFrame = 1;
+	gProfiler.mHasDraw = 0;
+	gProfiler.mFrameStart = now;
+	gProfiler.mStackSize = 0;
+	beginProfileZone(PROFILE_ZONE_UPDATE);
+}
+
+static void drawProfilerFrameBegin(void* tData) {
+	(void)tData;
+	if (!gProfiler.mIsActive || !gProfiler.mHasFrame) return;
+
+	gProfiler.mHasDraw = 1;
+	gProfiler.mStackSize = 0;
+	beginProfileZone(PROFILE_ZONE_DRAW);
+	gProfiler.mDrawBegin = gProfiler.mStack[0].mStart;
+}
+
+ActorBlueprint getProfilerFrameBegin()
+{
+	return makeActorBlueprint(loadProfilerFrameBegin, NULL, updateProfilerFrameBegin, drawProfilerFrameBegin);
+}
+
+static void loadProfilerFrameEnd(void* tData) {
+	(void)tData;
+	memset(gProfiler.mOverlayTimes, 0, sizeof(gProfiler.mOverlayTimes));
+	gProfiler.mOverlayFrames = 0;
+	if (!gProfiler.mHasOverlay) return;
+
+	for (int i = 0; i < PROFILER_OVERLAY_LINE_AMOUNT; i++) {
+		gProfiler.mOverlayTextIDs[i] = addMugenTextMugenStyle("", makePosition(PROFILER_OVERLAY_X, PROFILER_OVERLAY_Y + i * PROFILER_OVERLAY_LINE_HEIGHT, PROFILER_OVERLAY_Z), makeVector3DI(-1, 0, 1));
+	}
+}
+
+static void updateProfilerOverlay() {
+	if (!gProfiler.mHasOverlay || gProfiler.mOverlayFrames < PROFILER_OVERLAY_FRAMES) return;
+
+	char text[64];
+	for (int i = 0; i < PROFILER_OVERLAY_LINE_AMOUNT; i++) {
+		const ProfileZone zone = gOverlayZones[i];
+		snprintf(text, sizeof(text), "%s %.2f", gProfileZoneNames[zone], gProfiler.mOverlayTimes[zone] / (1000000.0 * gProfiler.mOverlayFrames));
+		changeMugenText(gProfiler.mOverlayTextIDs[i], text);
+	}
+	memset(gProfiler.mOverlayTimes, 0, sizeof(gProfiler.mOverlayTimes));
+	gProfiler.mOverlayFrames = 0;
+}
+
+static void updateProfilerFrameEnd(void* tData) {
+	(void)tData;
+	if (!gProfiler.mIsActive || !gProfiler.mHasFrame) return;
+
+	endProfileZone();
+	gProfiler.mUpdateEnd = getProfilerTime();
+	updateProfilerOverlay();
+}
+
+static void drawProfilerFrameEnd(void* tData) {
+	(void)tData;
+	if (!gProfiler.mIsActive || !gProfiler.mHasDraw) return;
+
+	endProfileZone();
+	gProfiler.mDrawEnd = getProfilerTime();
+}
+
+static void unloadProfilerFrameEnd(void* tData) {
+	(void)tData;
+	reportAllocationProfile();
+}
+
+ActorBlueprint getProfilerFrameEnd()
+{
+	return makeActorBlueprint(loadProfilerFrameEnd, unloadProfilerFrameEnd, updateProfilerFrameEnd, drawProfilerFrameEnd);
+}
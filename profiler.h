@@ -0,0 +1,45 @@
+#pragma once
+
+#include <prism/actorhandler.h>
+
+enum ProfileZone {
+	PROFILE_ZONE_FRAME,
+	PROFILE_ZONE_UPDATE,
+	PROFILE_ZONE_INPUT,
+	PROFILE_ZONE_UI,
+	PROFILE_ZONE_DIALOG,
+	PROFILE_ZONE_BOSS,
+	PROFILE_ZONE_ITEMS,
+	PROFILE_ZONE_ENEMIES,
+	PROFILE_ZONE_LEVEL,
+	PROFILE_ZONE_PLAYER,
+	PROFILE_ZONE_BULLET_ANIMATION,
+	PROFILE_ZONE_SHOTS,
+	PROFILE_ZONE_STATE_HASH,
+	PROFILE_ZONE_DRAW,
+	PROFILE_ZONE_DRAW_UI,
+	PROFILE_ZONE_DRAW_ENEMIES,
+	PROFILE_ZONE_DRAW_BULLETS,
+	PROFILE_ZONE_PRISM_DRAW,
+	PROFILE_ZONE_PRISM_UPDATE,
+	PROFILE_ZONE_AMOUNT,
+};
+
+struct ProfileScope {
+	ProfileScope(ProfileZone tZone);
+	~ProfileScope();
+};
+
+int parseProfilerArguments(int argc, char** argv);
+int isProfilerActive();
+void setProfilerActive(int tIsActive);
+void writeProfilerTrace();
+
+void beginProfileZone(ProfileZone tZone);
+void endProfileZone();
+int getActiveProfileZone();
+const char* getProfileZoneName(int tZone);
+double getProfileZoneMilliseconds(ProfileZone tZone);
+
+ActorBlueprint getProfilerFrameBegin();
+ActorBlueprint getProfilerFrameEnd();
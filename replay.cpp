@@ -0,0 +1,163 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <fstream>
+#include <iterator>
+
+#include <prism/log.h>
+
+#include "asyncfilewriter.h"
+#include "player.h"
+#include "replayformat.h"
+
+using namespace std;
+
+// Records the character, level, seed and per-frame buttons of a game into the format from replayformat.h, and loads them for playback.
+// The game screen seeds rand() here before its actors load, with the replay's seed during playback and the time otherwise,
+// so the same buttons give the same game. Recording is started with --record FILE and playback with --replay FILE.
+// The frames are run length encoded as they come in, and the finished runs are handed to the file writer thread
+// every REPLAY_FLUSH_FRAMES frames.
+
+#define REPLAY_FLUSH_FRAMES 60
+
+static struct {
+	string mRecordPath;
+	AsyncFileWriter* mWriter = NULL;
+	uint8_t mRunButtons;
+	uint32_t mRunLength;
+	int mFramesSinceFlush;
+	vector<uint8_t> mRuns;
+
+	int mHasNextSeed = 0;
+	unsigned int mNextSeed;
+
+	int mIsPlayback = 0;
+	ReplayHeader mHeader;
+	string mPlayerName;
+	vector<uint8_t> mFrames;
+} gReplay;
+
+static int loadReplay(const string& tPath) {
+	ifstream file(tPath, ios::binary);
+	vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	if (data.size() < sizeof(ReplayHeader)) {
+		logWarningFormat("Unable to read replay %s.", tPath.data());
+		return 0;
+	}
+
+	memcpy(&gReplay.mHeader, data.data(), sizeof(ReplayHeader));
+	gReplay.mFrames.clear();
+	if (!isReplayHeaderValid(gReplay.mHeader) || !readReplayRuns(data.data() + sizeof(ReplayHeader), uint32_t(data.size() - sizeof(ReplayHeader)), gReplay.mFrames)) {
+		logWarningFormat("Invalid replay %s.", tPath.data());
+		return 0;
+	}
+	gReplay.mPlayerName = gReplay.mHeader.mPlayerName;
+	logFormat("Loaded replay %s with %d frames.", tPath.data(), int(gReplay.mFrames.size()));
+	return 1;
+}
+
+int parseReplayArguments(int argc, char** argv)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (!strcmp(argv[i], "--record")) gReplay.mRecordPath = argv[++i];
+		else if (!strcmp(argv[i], "--replay")) gReplay.mIsPlayback = loadReplay(argv[++i]);
+	}
+	return gReplay.mIsPlayback;
+}
+
+void setNextGameSeed(unsigned int tSeed)
+{
+	gReplay.mHasNextSeed = 1;
+	gReplay.mNextSeed = tSeed;
+}
+
+static void startReplayRecording(int tLevel, unsigned int tSeed) {
+	gReplay.mWriter = openAsyncFileWriter(gReplay.mRecordPath);
+	if (!gReplay.mWriter) {
+		logWarningFormat("Unable to record replay %s.", gReplay.mRecordPath.data());
+		return;
+	}
+
+	ReplayHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mMagic, REPLAY_MAGIC, 4);
+	header.mVersion = REPLAY_VERSION;
+	header.mLevel = tLevel;
+	header.mSeed = tSeed;
+	strncpy(header.mPlayerName, getPlayerName().data(), REPLAY_PLAYER_NAME_SIZE - 1);
+	appendAsyncFileWriter(gReplay.mWriter, &header, sizeof(header));
+
+	gReplay.mRunLength = 0;
+	gReplay.mFramesSinceFlush = 0;
+}
+
+void beginGameReplay(int tLevel)
+{
+	finishReplayRecording();
+
+	unsigned int seed;
+	if (gReplay.mIsPlayback) seed = gReplay.mHeader.mSeed;
+	else if (gReplay.mHasNextSeed) seed = gReplay.mNextSeed;
+	else seed = (unsigned int)time(NULL);
+	srand(seed);
+
+	if (!gReplay.mIsPlayback && !gReplay.mRecordPath.empty()) startReplayRecording(tLevel, seed);
+}
+
+static void flushReplayRuns() {
+	appendAsyncFileWriter(gReplay.mWriter, gReplay.mRuns.data(), gReplay.mRuns.size());
+	gReplay.mRuns.clear();
+	flushAsyncFileWriter(gReplay.mWriter);
+}
+
+void recordReplayFrame(uint32_t tButtons)
+{
+	if (!gReplay.mWriter) return;
+
+	const uint8_t buttons = uint8_t(tButtons);
+	if (gReplay.mRunLength && buttons != gReplay.mRunButtons) {
+		writeReplayRun(gReplay.mRuns, gReplay.mRunLength, gReplay.mRunButtons);
+		gReplay.mRunLength = 0;
+	}
+	gReplay.mRunButtons = buttons;
+	gReplay.mRunLength++;
+
+	if (++gReplay.mFramesSinceFlush >= REPLAY_FLUSH_FRAMES) {
+		flushReplayRuns();
+		gReplay.mFramesSinceFlush = 0;
+	}
+}
+
+void finishReplayRecording()
+{
+	if (!gReplay.mWriter) return;
+
+	if (gReplay.mRunLength) writeReplayRun(gReplay.mRuns, gReplay.mRunLength, gReplay.mRunButtons);
+	flushReplayRuns();
+	closeAsyncFileWriter(gReplay.mWriter);
+	gReplay.mWriter = NULL;
+}
+
+int isReplayPlayback()
+{
+	return gReplay.mIsPlayback;
+}
+
+const std::string& getReplayPlayerName()
+{
+	return gReplay.mPlayerName;
+}
+
+int getReplayLevel()
+{
+	return gReplay.mHeader.mLevel;
+}
+
+const std::vector<uint8_t>& getReplayFrames()
+{
+	return gReplay.mFrames;
+}
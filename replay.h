@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+int parseReplayArguments(int argc, char** argv);
+
+void setNextGameSeed(unsigned int tSeed);
+void beginGameReplay(int tLevel);
+void recordReplayFrame(uint32_t tButtons);
+void finishReplayRecording();
+
+int isReplayPlayback();
+const std::string& getReplayPlayerName();
+int getReplayLevel();
+const std::vector<uint8_t>& getReplayFrames();
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+// Layout of the replay files written by replay.cpp.
+// All integers are little endian, which matches every platform the game ships on.
+//
+// ReplayHeader
+// runs until the end of the file, each a LEB128 frame count followed by one byte of GameButton bits
+//
+// The file has no frame count, so it can be appended to while playing and stays valid if the game stops early.
+
+#define REPLAY_MAGIC "YRRP"
+#define REPLAY_VERSION 1
+#define REPLAY_PLAYER_NAME_SIZE 32
+
+struct ReplayHeader {
+	char mMagic[4];
+	uint32_t mVersion;
+	int32_t mLevel;
+	uint32_t mSeed;
+	char mPlayerName[REPLAY_PLAYER_NAME_SIZE];
+};
+
+static inline void writeReplayRun(std::vector<uint8_t>& oOut, uint32_t tFrameAmount, uint8_t tButtons) {
+	while (tFrameAmount >= 0x80) {
+		oOut.push_back(uint8_t(tFrameAmount | 0x80));
+		tFrameAmount >>= 7;
+	}
+	oOut.push_back(uint8_t(tFrameAmount));
+	oOut.push_back(tButtons);
+}
+
+// Expands the runs after the header into one button byte per frame. A run cut off by the end of the file is dropped.
+static inline int readReplayRuns(const uint8_t* tData, uint32_t tSize, std::vector<uint8_t>& oFrames) {
+	const uint8_t* src = tData;
+	const uint8_t* srcEnd = tData + tSize;
+	while (src < srcEnd) {
+		uint32_t frameAmount = 0;
+		int shift = 0;
+		while (src < srcEnd && (*src & 0x80)) {
+			if (shift > 21) return 0;
+			frameAmount |= uint32_t(*src++ & 0x7F) << shift;
+			shift += 7;
+		}
+		if (src >= srcEnd) break;
+		frameAmount |= uint32_t(*src++) << shift;
+		if (src >= srcEnd) break;
+		oFrames.insert(oFrames.end(), frameAmount, *src++);
+	}
+	return 1;
+}
+
+static inline int isReplayHeaderValid(const ReplayHeader& tHeader) {
+	return !memcmp(tHeader.mMagic, REPLAY_MAGIC, 4) && tHeader.mVersion == REPLAY_VERSION && tHeader.mPlayerName[REPLAY_PLAYER_NAME_SIZE - 1] == '\0';
+}
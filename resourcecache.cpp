@@ -0,0 +1,133 @@
+#include "resourcecache.h"
+
+#include <algorithm>
+#include <map>
+#include <prism/memoryhandler.h>
+#include <prism/log.h>
+
+#include "assetprefetch.h"
+
+using namespace std;
+
+// Sprite files, animation files and sprite atlases that stay loaded across screen changes.
+// Entries are loaded with the per-screen memory stacks suspended, so setNewScreen does not free them.
+// An entry without references stays resident until purgeUnreferencedCachedResources is called.
+
+template<typename T>
+struct CachedResource {
+	T mResource;
+	int mReferences;
+};
+
+static struct {
+	map<string, CachedResource<MugenSpriteFile>> mSpriteFiles;
+	map<string, CachedResource<MugenAnimations>> mAnimationFiles;
+	map<string, CachedResource<SpriteAtlas>> mSpriteAtlases;
+} gResourceCache;
+
+template<typename T, typename LoadFunction>
+static T* acquireCachedResource(map<string, CachedResource<T>>& tCache, const string& tPath, LoadFunction tLoad) {
+	auto it = tCache.find(tPath);
+	if (it == tCache.end()) {
+		suspendMemoryStacks();
+		CachedResource<T> entry;
+		entry.mResource = tLoad(tPath);
+		entry.mReferences = 0;
+		resumeMemoryStacks();
+		it = tCache.insert(make_pair(tPath, entry)).first;
+	}
+
+	it->second.mReferences++;
+	return &it->second.mResource;
+}
+
+template<typename T>
+static void releaseCachedResource(map<string, CachedResource<T>>& tCache, const string& tPath) {
+	auto it = tCache.find(tPath);
+	if (it == tCache.end()) {
+		logWarningFormat("Releasing uncached resource %s", tPath.data());
+		return;
+	}
+
+	it->second.mReferences = std::max(it->second.mReferences - 1, 0);
+}
+
+template<typename T, typename UnloadFunction>
+static void purgeUnreferencedResources(map<string, CachedResource<T>>& tCache, UnloadFunction tUnload) {
+	auto it = tCache.begin();
+	while (it != tCache.end()) {
+		if (it->second.mReferences) {
+			++it;
+			continue;
+		}
+
+		suspendMemoryStacks();
+		tUnload(&it->second.mResource);
+		resumeMemoryStacks();
+		it = tCache.erase(it);
+	}
+}
+
+static MugenSpriteFile loadSpriteFile(const string& tPath) {
+	return loadPrefetchedMugenSpriteFileWithoutPalette(tPath);
+}
+
+static MugenAnimations loadAnimationFile(const string& tPath) {
+	return loadPrefetchedMugenAnimationFile(tPath);
+}
+
+static SpriteAtlas loadAtlasFile(const string& tPath) {
+	return loadSpriteAtlas(tPath);
+}
+
+MugenSpriteFile* acquireCachedMugenSpriteFile(const std::string& tPath)
+{
+	return acquireCachedResource(gResourceCache.mSpriteFiles, tPath, loadSpriteFile);
+}
+
+MugenAnimations* acquireCachedMugenAnimationFile(const std::string& tPath)
+{
+	return acquireCachedResource(gResourceCache.mAnimationFiles, tPath, loadAnimationFile);
+}
+
+SpriteAtlas* acquireCachedSpriteAtlas(const std::string& tPath)
+{
+	return acquireCachedResource(gResourceCache.mSpriteAtlases, tPath, loadAtlasFile);
+}
+
+void releaseCachedMugenSpriteFile(const std::string& tPath)
+{
+	releaseCachedResource(gResourceCache.mSpriteFiles, tPath);
+}
+
+void releaseCachedMugenAnimationFile(const std::string& tPath)
+{
+	releaseCachedResource(gResourceCache.mAnimationFiles, tPath);
+}
+
+void releaseCachedSpriteAtlas(const std::string& tPath)
+{
+	releaseCachedResource(gResourceCache.mSpriteAtlases, tPath);
+}
+
+int isMugenSpriteFileCached(const std::string& tPath)
+{
+	return gResourceCache.mSpriteFiles.count(tPath) != 0;
+}
+
+int isMugenAnimationFileCached(const std::string& tPath)
+{
+	return gResourceCache.mAnimationFiles.count(tPath) != 0;
+}
+
+int isSpriteAtlasCached(const std::string& tPath)
+{
+	return gResourceCache.mSpriteAtlases.count(tPath) != 0;
+}
+
+void purgeUnreferencedCachedResources()
+{
+	purgeUnreferencedResources(gResourceCache.mSpriteFiles, unloadMugenSpriteFile);
+	purgeUnreferencedResources(gResourceCache.mAnimationFiles, unloadMugenAnimationFile);
+	purgeUnreferencedResources(gResourceCache.mSpriteAtlases, unloadSpriteAtlas);
+}
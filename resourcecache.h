@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <prism/mugenspritefilereader.h>
+#include <prism/mugenanimationreader.h>
+
+#include "spriteatlas.h"
+
+MugenSpriteFile* acquireCachedMugenSpriteFile(const std::string& tPath);
+MugenAnimations* acquireCachedMugenAnimationFile(const std::string& tPath);
+SpriteAtlas* acquireCachedSpriteAtlas(const std::string& tPath);
+void releaseCachedMugenSpriteFile(const std::string& tPath);
+void releaseCachedMugenAnimationFile(const std::string& tPath);
+void releaseCachedSpriteAtlas(const std::string& tPath);
+int isMugenSpriteFileCached(const std::string& tPath);
+int isMugenAnimationFileCached(const std::string& tPath);
+int isSpriteAtlasCached(const std::string& tPath);
+
+void purgeUnreferencedCachedResources();
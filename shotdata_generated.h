@@ -0,0 +1,309 @@
+// Generated by tools/shotdefgen from data/SHOTS.def. Do not edit.
+#pragma once
+
+#include "shottemplates.h"
+
+static constexpr const char* gShotGimmickNames[] = {
+	"yournamehereStraight",
+	"yournamehereStrong",
+	"yournamehereHoming",
+	"kinomodUnfocused1",
+	"kinomodUnfocused2",
+	"kinomodUnfocused3",
+	"kinomodUnfocused4",
+	"kinomodFocused1",
+	"kinomodFocused2",
+	"kinomodFocused3",
+	"kinomodFocused4",
+	"aeroliteUnfocused1",
+	"aeroliteUnfocused2",
+	"aeroliteUnfocused3",
+	"aeroliteUnfocused4",
+	"enemyStraight",
+	"enemyAimed",
+	"enemyHoming",
+	"enemyAimedPlus10",
+	"enemyAimedPlus20",
+	"enemyAimedPlus340",
+	"enemyAimedPlus350",
+	"enemyLaserAimed",
+	"enemyLaserAimedSlow",
+	"enemyLaserStraight",
+	"enemyLaserCircle",
+	"enemyFiveAimedDifferent",
+	"enemyFiveAimedSlow",
+	"enemyCircleMid",
+	"enemyCircleSlim",
+	"enemyPCB",
+	"enemyPCB2",
+	"enemyLowerHalf",
+	"enemyRandom",
+	"enemyAimedWide",
+	"enemyWideningAngle",
+	"enemySlightDownLeft",
+	"enemySlightDownRight",
+	"enemyLowerHalfSlow",
+	"enemyLilyWhite",
+	"barney1",
+	"ack1",
+	"accMid",
+	"accNS1",
+	"accS1",
+	"accNS2",
+	"accS2",
+	"accS3",
+	"woaznNS",
+	"woaznS",
+	"ausNS1",
+	"ausS1",
+	"ausNS2",
+	"ausS2",
+	"ausNS3",
+	"ausS31",
+	"ausS32",
+	"ausS33",
+	"ausS34",
+	"ausS4",
+	"shiiNS1",
+	"shiiS1",
+	"shiiNS2",
+	"shiiS2",
+	"shiiNS3",
+	"shiiS3",
+	"shiiNS4",
+	"shiiS4",
+	"shiiS5",
+	"enemyFinal1",
+	"enemyFinal2",
+	"enemyFinal3",
+	"shiiMidNS1",
+	"shiiMidS1",
+	"hiroNS1",
+	"hiroS1",
+	"hiroNS2",
+	"hiroS2",
+	"hiroNS3",
+	"hiroS3",
+	"hiroNS4",
+	"hiroS4",
+	"hiroNS5",
+	"hiroS5",
+	"hiroS61",
+	"hiroS62",
+	"hiroS63",
+	"crisis",
+	"enemyFinal4",
+	"enemyFinal5",
+	"enemyFinal6",
+	"alternativeNS1",
+	"alternativeS11",
+	"alternativeS12",
+	"alternativeS2",
+	"mootNS1",
+	"mootS1",
+	"mootNS2",
+	"mootS2",
+	"mootNS3",
+	"mootS3",
+	"snacksS3",
+	"mootS4",
+	"mootS5",
+	"mootNS6",
+	"alternativeS6",
+	"yournamehereS6",
+	"kinomodS6",
+	"aeroliteS6",
+	"mootS6",
+	"mootNS7",
+	"mootS7",
+	"mootS8",
+	"mootS9",
+};
+
+static constexpr ShotSubShotTemplate gShotSubShotTemplates[] = {
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 2, 0, -10 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 2, -5, -10 },
+	{ 2, 5, -10 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 2, -9, -4 },
+	{ 2, 9, -4 },
+	{ 2, 0, -10 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 2, -4, -10 },
+	{ 2, 4, -10 },
+	{ 2, -12, -3 },
+	{ 2, 12, -3 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 3, 0, -10 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 3, -5, -10 },
+	{ 3, 5, -10 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 3, -9, -4 },
+	{ 3, 9, -4 },
+	{ 3, 0, -10 },
+	{ 1, -2, -5 },
+	{ 1, 2, -5 },
+	{ 3, -4, -10 },
+	{ 3, 4, -10 },
+	{ 3, -12, -3 },
+	{ 3, 12, -3 },
+	{ 32, 0, 0 },
+	{ 35, 0, 0 },
+	{ 36, 0, 0 },
+	{ 37, 0, 0 },
+	{ 38, 0, 0 },
+};
+
+static constexpr ShotTemplate gShotTemplates[] = {
+	{ "invisible", 1, -1, 1, 0, -1, 0, 0 },
+	{ "yournamehere_base", 1, 11, 2, 1, 0, 0, 0 },
+	{ "yournamehere_straight", 1, 12, 3, 5, 1, 0, 0 },
+	{ "yournamehere_homing", 1, 10, 2, 3, 2, 0, 0 },
+	{ "yournamehere_straight_1", 0, 1, 1, 1, -1, 0, 3 },
+	{ "yournamehere_straight_2", 0, 1, 1, 1, -1, 3, 4 },
+	{ "yournamehere_straight_3", 0, 1, 1, 1, -1, 7, 5 },
+	{ "yournamehere_straight_4", 0, 1, 1, 1, -1, 12, 6 },
+	{ "yournamehere_homing_1", 0, 1, 1, 1, -1, 18, 3 },
+	{ "yournamehere_homing_2", 0, 1, 1, 1, -1, 21, 4 },
+	{ "yournamehere_homing_3", 0, 1, 1, 1, -1, 25, 5 },
+	{ "yournamehere_homing_4", 0, 1, 1, 1, -1, 30, 6 },
+	{ "kinomod_base", 1, 15, 1, 1, 0, 36, 0 },
+	{ "kinomod_small", 1, 13, 2, 2, -1, 36, 0 },
+	{ "kinomod_large", 1, 14, 2, 4, -1, 36, 0 },
+	{ "kinomod_unfocused_1", 0, 1, 1, 1, 3, 36, 0 },
+	{ "kinomod_unfocused_2", 0, 1, 1, 1, 4, 36, 0 },
+	{ "kinomod_unfocused_3", 0, 1, 1, 1, 5, 36, 0 },
+	{ "kinomod_unfocused_4", 0, 1, 1, 1, 6, 36, 0 },
+	{ "kinomod_focused_1", 0, 1, 1, 1, 7, 36, 0 },
+	{ "kinomod_focused_2", 0, 1, 1, 1, 8, 36, 0 },
+	{ "kinomod_focused_3", 0, 1, 1, 1, 9, 36, 0 },
+	{ "kinomod_focused_4", 0, 1, 1, 1, 10, 36, 0 },
+	{ "aerolite_laser1", 1, 16, 1, 2, -1, 36, 0 },
+	{ "aerolite_laser2", 1, 16, 2, 2, -1, 36, 0 },
+	{ "aerolite_laser3", 1, 16, 3, 2, -1, 36, 0 },
+	{ "aerolite_laser4", 1, 16, 3, 2, -1, 36, 0 },
+	{ "aerolite_unfocused_1", 0, 1, 1, 1, 11, 36, 0 },
+	{ "aerolite_unfocused_2", 0, 1, 1, 1, 12, 36, 0 },
+	{ "aerolite_unfocused_3", 0, 1, 1, 1, 13, 36, 0 },
+	{ "aerolite_unfocused_4", 0, 1, 1, 1, 14, 36, 0 },
+	{ "enemy_1", 1, 1000, 1, 1, 15, 36, 0 },
+	{ "enemy_mid_aimed", 1, 1001, 1, 3, 16, 36, 0 },
+	{ "enemy_mid_straight", 1, 1001, 1, 3, 15, 36, 0 },
+	{ "enemy_mid_homing", 1, 1001, 1, 3, 17, 36, 0 },
+	{ "enemy_mid_aimed_plus_10", 1, 1001, 1, 3, 18, 36, 0 },
+	{ "enemy_mid_aimed_plus_20", 1, 1001, 1, 3, 19, 36, 0 },
+	{ "enemy_mid_aimed_plus_340", 1, 1001, 1, 3, 20, 36, 0 },
+	{ "enemy_mid_aimed_plus_350", 1, 1001, 1, 3, 21, 36, 0 },
+	{ "enemy_laser", 1, 1003, 1, 3, -1, 36, 0 },
+	{ "enemy_laser_aimed", 0, 1, 1, 1, 22, 36, 0 },
+	{ "enemy_laser_aimed_slow", 0, 1, 1, 1, 23, 36, 0 },
+	{ "enemy_laser_straight", 0, 1, 1, 1, 24, 36, 0 },
+	{ "enemy_laser_circle", 0, 1, 1, 1, 25, 36, 0 },
+	{ "enemy_five_aimed", 0, 1, 1, 1, -1, 36, 5 },
+	{ "enemy_five_aimed_different", 0, 1, 1, 1, 26, 41, 0 },
+	{ "enemy_five_aimed_slow", 0, 1, 1, 1, 27, 41, 0 },
+	{ "enemy_circle_mid", 0, 1, 1, 1, 28, 41, 0 },
+	{ "enemy_circle_slim", 0, 1, 1, 1, 29, 41, 0 },
+	{ "enemy_pcb", 0, 1, 1, 1, 30, 41, 0 },
+	{ "enemy_pcb_2", 0, 1, 1, 1, 31, 41, 0 },
+	{ "enemy_mid_lower_half", 1, 1001, 1, 3, 32, 41, 0 },
+	{ "enemy_slim_lower_half", 1, 1002, 1, 2, 32, 41, 0 },
+	{ "enemy_slim_random", 1, 1002, 1, 2, 33, 41, 0 },
+	{ "enemy_slim_angle_aimed_wide", 1, 1002, 1, 2, 34, 41, 0 },
+	{ "enemy_slim_widening_angle", 1, 1002, 1, 2, 35, 41, 0 },
+	{ "enemy_mid_random", 1, 1001, 1, 3, 33, 41, 0 },
+	{ "enemy_slim_slight_down_left", 1, 1002, 1, 2, 36, 41, 0 },
+	{ "enemy_slim_slight_down_right", 1, 1002, 1, 2, 37, 41, 0 },
+	{ "enemy_slim_lower_half_slow", 1, 1002, 1, 2, 38, 41, 0 },
+	{ "enemy_pink", 1, 1000, 1, 1, -1, 41, 0 },
+	{ "enemy_pink_lower_half_slow", 1, 1000, 1, 1, 38, 41, 0 },
+	{ "enemy_slim", 1, 1002, 1, 2, -1, 41, 0 },
+	{ "enemy_mid", 1, 1001, 1, 3, -1, 41, 0 },
+	{ "enemy_large", 1, 1005, 1, 6, -1, 41, 0 },
+	{ "shii_world", 1, 1004, 1, 10, -1, 41, 0 },
+	{ "lily_white", 0, 1, 1, 1, 39, 41, 0 },
+	{ "barney1", 0, 1, 1, 1, 40, 41, 0 },
+	{ "ack1", 0, 1, 1, 1, 41, 41, 0 },
+	{ "acc_mid", 0, 1, 1, 1, 42, 41, 0 },
+	{ "acc_ns1", 0, 1, 1, 1, 43, 41, 0 },
+	{ "acc_s1", 0, 1, 1, 1, 44, 41, 0 },
+	{ "acc_ns2", 0, 1, 1, 1, 45, 41, 0 },
+	{ "acc_s2", 0, 1, 1, 1, 46, 41, 0 },
+	{ "acc_s3", 0, 1, 1, 1, 47, 41, 0 },
+	{ "woazn_ns", 0, 1, 1, 1, 48, 41, 0 },
+	{ "woazn_s", 0, 1, 1, 1, 49, 41, 0 },
+	{ "aus_ns1", 0, 1, 1, 1, 50, 41, 0 },
+	{ "aus_s1", 0, 1, 1, 1, 51, 41, 0 },
+	{ "aus_ns2", 0, 1, 1, 1, 52, 41, 0 },
+	{ "aus_s2", 0, 1, 1, 1, 53, 41, 0 },
+	{ "aus_ns3", 0, 1, 1, 1, 54, 41, 0 },
+	{ "aus_s3_1", 0, 1, 1, 1, 55, 41, 0 },
+	{ "aus_s3_2", 0, 1, 1, 1, 56, 41, 0 },
+	{ "aus_s3_3", 0, 1, 1, 1, 57, 41, 0 },
+	{ "aus_s3_4", 0, 1, 1, 1, 58, 41, 0 },
+	{ "aus_s4", 0, 1, 1, 1, 59, 41, 0 },
+	{ "shii_ns1", 0, 1, 1, 1, 60, 41, 0 },
+	{ "shii_s1", 0, 1, 1, 1, 61, 41, 0 },
+	{ "shii_ns2", 0, 1, 1, 1, 62, 41, 0 },
+	{ "shii_s2", 0, 1, 1, 1, 63, 41, 0 },
+	{ "shii_ns3", 0, 1, 1, 1, 64, 41, 0 },
+	{ "shii_s3", 0, 1, 1, 1, 65, 41, 0 },
+	{ "shii_ns4", 0, 1, 1, 1, 66, 41, 0 },
+	{ "shii_s4", 0, 1, 1, 1, 67, 41, 0 },
+	{ "shii_s5", 0, 1, 1, 1, 68, 41, 0 },
+	{ "enemy_final_1", 0, 1, 1, 1, 69, 41, 0 },
+	{ "enemy_final_2", 0, 1, 1, 1, 70, 41, 0 },
+	{ "enemy_final_3", 0, 1, 1, 1, 71, 41, 0 },
+	{ "shii_mid_ns1", 0, 1, 1, 1, 72, 41, 0 },
+	{ "shii_mid_s1", 0, 1, 1, 1, 73, 41, 0 },
+	{ "hiro_ns1", 0, 1, 1, 1, 74, 41, 0 },
+	{ "hiro_s1", 0, 1, 1, 1, 75, 41, 0 },
+	{ "hiro_ns2", 0, 1, 1, 1, 76, 41, 0 },
+	{ "hiro_s2", 0, 1, 1, 1, 77, 41, 0 },
+	{ "hiro_ns3", 0, 1, 1, 1, 78, 41, 0 },
+	{ "hiro_s3", 0, 1, 1, 1, 79, 41, 0 },
+	{ "hiro_ns4", 0, 1, 1, 1, 80, 41, 0 },
+	{ "hiro_s4", 0, 1, 1, 1, 81, 41, 0 },
+	{ "hiro_ns5", 0, 1, 1, 1, 82, 41, 0 },
+	{ "hiro_s5", 0, 1, 1, 1, 83, 41, 0 },
+	{ "hiro_s6_1", 0, 1, 1, 1, 84, 41, 0 },
+	{ "hiro_s6_2", 0, 1, 1, 1, 85, 41, 0 },
+	{ "hiro_s6_3", 0, 1, 1, 1, 86, 41, 0 },
+	{ "crisis", 0, 1, 1, 1, 87, 41, 0 },
+	{ "enemy_final_4", 0, 1, 1, 1, 88, 41, 0 },
+	{ "enemy_final_5", 0, 1, 1, 1, 89, 41, 0 },
+	{ "enemy_final_6", 0, 1, 1, 1, 90, 41, 0 },
+	{ "alternative_ns1", 0, 1, 1, 1, 91, 41, 0 },
+	{ "alternative_s11", 0, 1, 1, 1, 92, 41, 0 },
+	{ "alternative_s12", 0, 1, 1, 1, 93, 41, 0 },
+	{ "alternative_s2", 0, 1, 1, 1, 94, 41, 0 },
+	{ "moot_ns1", 0, 1, 1, 1, 95, 41, 0 },
+	{ "moot_s1", 0, 1, 1, 1, 96, 41, 0 },
+	{ "moot_ns2", 0, 1, 1, 1, 97, 41, 0 },
+	{ "moot_s2", 0, 1, 1, 1, 98, 41, 0 },
+	{ "moot_ns3", 0, 1, 1, 1, 99, 41, 0 },
+	{ "moot_s3", 0, 1, 1, 1, 100, 41, 0 },
+	{ "snacks_s3", 0, 1, 1, 1, 101, 41, 0 },
+	{ "moot_s4", 0, 1, 1, 1, 102, 41, 0 },
+	{ "moot_s5", 0, 1, 1, 1, 103, 41, 0 },
+	{ "moot_ns6", 0, 1, 1, 1, 104, 41, 0 },
+	{ "alternative_s6", 1, -1, 1, 0, 105, 41, 0 },
+	{ "yournamehere_s6", 1, -1, 1, 0, 106, 41, 0 },
+	{ "kinomod_s6", 1, -1, 1, 0, 107, 41, 0 },
+	{ "aerolite_s6", 1, -1, 1, 0, 108, 41, 0 },
+	{ "moot_s6", 0, 1, 1, 1, 109, 41, 0 },
+	{ "moot_ns7", 0, 1, 1, 1, 110, 41, 0 },
+	{ "moot_s7", 0, 1, 1, 1, 111, 41, 0 },
+	{ "moot_s8", 0, 1, 1, 1, 112, 41, 0 },
+	{ "moot_s9", 0, 1, 1, 1, 113, 41, 0 },
+};
@@ -4,11 +4,19 @@
 #include <memory>
 #include <prism/blitz.h>
 
+#include "bulletrenderer.h"
 #include "collision.h"
 #include "debug.h"
 #include "player.h"
 #include "enemyhandler.h"
 #include "boss.h"
+#include "shotdata_generated.h"
+#include "resourcecache.h"
+#include "statehash.h"
+#include "profiler.h"
+#include "gimmickstats.h"
+
+// #define SHOTS_FROM_DEF_FILE
 
 #define PLAYER_SHOT_Z 25
 #define ENEMY_SHOT_Z 26
@@ -17,8 +25,8 @@ static void shotCB(void* tCaller, void* tCollisionData);
 
 struct ShotHandler {
 
-	MugenSpriteFile mSprites;
-	MugenAnimations mAnimations;
+	MugenSpriteFile* mSprites;
+	MugenAnimations* mAnimations;
 	static ShotHandler* mSelf;
 
 	struct ShotData;
@@ -32,6 +40,8 @@ struct ShotHandler {
 		double mCollisionRadius;
 		ShotGimmickFunction mGimmick;
 		vector<ShotData> mSubShots;
+		int mGimmickStats;
+		int mDirectStats;
 
 		ShotData() {
 			assert(0);
@@ -47,13 +57,15 @@ struct ShotHandler {
 				mCollisionRadius = getMugenDefFloatOrDefaultAsGroup(tGroup, "radius", 1);
 			}
 
+			string gimmickName;
 			if (isMugenDefStringVariableAsGroup(tGroup, "gimmick")) {
-				string gimmickName = getSTLMugenDefStringVariableAsGroup(tGroup, "gimmick");
+				gimmickName = getSTLMugenDefStringVariableAsGroup(tGroup, "gimmick");
 				mGimmick = mSelf->getShotGimmick(gimmickName);
 			}
 			else {
 				mGimmick = NULL;
 			}
+			initGimmickStats(getShotGroupName(tGroup), gimmickName);
 
 			for (int i = 0; i < 100; i++) {
 				char baseName[20];
@@ -69,12 +81,40 @@ struct ShotHandler {
 
 			}
 		}
+
+		ShotData(const ShotTemplate& tTemplate) {
+			mOffset = makePosition(0, 0, 0);
+
+			mHasAnimation = tTemplate.mHasAnimation;
+			mAnimation = tTemplate.mAnimation;
+			mDamage = tTemplate.mDamage;
+			mCollisionRadius = tTemplate.mCollisionRadius;
+			mGimmick = tTemplate.mGimmick >= 0 ? mSelf->getShotGimmick(gShotGimmickNames[tTemplate.mGimmick]) : NULL;
+			initGimmickStats(tTemplate.mName, tTemplate.mGimmick >= 0 ? gShotGimmickNames[tTemplate.mGimmick] : "");
+
+			for (int i = 0; i < tTemplate.mSubShotAmount; i++) {
+				const ShotSubShotTemplate& subShot = gShotSubShotTemplates[tTemplate.mSubShotStart + i];
+				ShotData shotData = mSelf->getShotDataByName(gShotTemplates[subShot.mTemplate].mName);
+				shotData.mOffset = makePosition(subShot.mOffsetX, subShot.mOffsetY, 0);
+				mSubShots.push_back(shotData);
+			}
+		}
+
+		void initGimmickStats(const string& tTemplate, const string& tGimmick) {
+			mGimmickStats = getGimmickStatsID(tGimmick.empty() ? "-" : tGimmick, tTemplate);
+			mDirectStats = getGimmickStatsID("", tTemplate);
+		}
 	};
 
 
 	struct Shot {
 		int mHasEntity;
 		int mEntityID;
+		int mIsBatched;
+		int mAnimation;
+		double mAngle;
+		Vector3D mColor;
+		double mTransparency;
 		int mCurrentFrame;
 		void* mOwner;
 		function<int(void*, Shot*)> mGimmick;
@@ -83,12 +123,15 @@ struct ShotHandler {
 		int mCollisionList;
 		int mDamage;
 		int mIsDoneAfterBeginning;
+		int mGimmickStats;
+		int mSpawnerStats;
+		int mStatsRun;
 
 		Shot(void* tOwner, Position tPos, ShotData tData, int tCollisionList, int rootID)
-			: Shot(tOwner, tPos, tData, tCollisionList, rootID, tData.mGimmick) {
+			: Shot(tOwner, tPos, tData, tCollisionList, rootID, tData.mGimmick, 0) {
 		}
 
-		Shot(void* tOwner, Position tPos, ShotData tData, int tCollisionList, int rootID, function<int(void*, Shot*)> tGimmick) {
+		Shot(void* tOwner, Position tPos, ShotData tData, int tCollisionList, int rootID, function<int(void*, Shot*)> tGimmick, int tIsInlineGimmick = 1) {
 			mRootID = rootID;
 			mCurrentFrame = 0;
 			tPos += tData.mOffset;
@@ -97,10 +140,23 @@ struct ShotHandler {
 			mCollisionList = tCollisionList;
 			mDamage = tData.mDamage;
 			mHasEntity = tData.mHasAnimation;
+			mAnimation = tData.mAnimation;
+			mAngle = 0;
+			mColor = makePosition(1, 1, 1);
+			mTransparency = 1;
+			mIsBatched = mHasEntity && canBatchBulletAnimation(BULLET_BATCH_SHOTS, mAnimation);
+			mGimmickStats = mSpawnerStats = -1;
+			if (isGimmickStatsActive()) {
+				const int spawner = getActiveGimmickStats();
+				mSpawnerStats = spawner >= 0 ? spawner : tData.mDirectStats;
+				mGimmickStats = tIsInlineGimmick ? getInlineGimmickStatsID(spawner, tData.mGimmickStats) : tData.mGimmickStats;
+				addGimmickStatsSpawn(mSpawnerStats);
+				mStatsRun = getGimmickStatsRun();
+			}
 			if (mHasEntity) {
 				tPos.z = tCollisionList == getPlayerShotCollisionList() ? PLAYER_SHOT_Z : ENEMY_SHOT_Z;
 				mEntityID = addBlitzEntity(tPos);
-				addBlitzMugenAnimationComponent(mEntityID, &mSelf->mSprites, &mSelf->mAnimations, tData.mAnimation);
+				if (!mIsBatched) addBlitzMugenAnimationComponent(mEntityID, mSelf->mSprites, mSelf->mAnimations, tData.mAnimation);
 				addBlitzCollisionComponent(mEntityID);
 				int collisionID = addBlitzCollisionCirc(mEntityID, tCollisionList, makeCollisionCirc(makePosition(0, 0, 0), tData.mCollisionRadius));
 				addBlitzCollisionCB(mEntityID, collisionID, shotCB, this);
@@ -108,21 +164,34 @@ struct ShotHandler {
 				addBlitzPhysicsComponent(mEntityID);
 			}
 			if (mGimmick) {
-				mIsDoneAfterBeginning = mGimmick(mOwner, this);
+				mIsDoneAfterBeginning = runGimmick();
 			}
 			else {
 				mIsDoneAfterBeginning = 0;
 			}
 
+			const int isCountingSubShots = mSpawnerStats >= 0 && !tData.mSubShots.empty();
+			if (isCountingSubShots) beginGimmickStats(tData.mGimmickStats, 0);
 			for (auto& subShot : tData.mSubShots) {
 				mSelf->addShot(tOwner, tPos, subShot, tCollisionList);
 			}
+			if (isCountingSubShots) endGimmickStats();
 		}
 
 		~Shot() {
 			if (mHasEntity) {
 				removeBlitzEntity(mEntityID);
 			}
+			if (mSpawnerStats >= 0 && mStatsRun == getGimmickStatsRun()) addGimmickStatsLifetime(mSpawnerStats, mCurrentFrame);
+		}
+
+		int runGimmick() {
+			if (mGimmickStats < 0) return mGimmick(mOwner, this);
+
+			beginGimmickStats(mGimmickStats, 1);
+			const int ret = mGimmick(mOwner, this);
+			endGimmickStats();
+			return ret;
 		}
 	};
 
@@ -135,17 +204,35 @@ struct ShotHandler {
 		return (ShotGimmickFunction)mGimmicks[tName];
 	}
 
+	static void setShotAngle(ShotHandler::Shot* tShot, double tAngle) {
+		tShot->mAngle = tAngle;
+		if (!tShot->mIsBatched) setBlitzMugenAnimationAngle(tShot->mEntityID, tAngle);
+	}
+
+	static void setShotColor(ShotHandler::Shot* tShot, double tR, double tG, double tB) {
+		tShot->mColor = makePosition(tR, tG, tB);
+		if (!tShot->mIsBatched) setBlitzMugenAnimationColor(tShot->mEntityID, tR, tG, tB);
+	}
+
+	static void setShotTransparency(ShotHandler::Shot* tShot, double tTransparency) {
+		tShot->mTransparency = tTransparency;
+		if (!tShot->mIsBatched) setBlitzMugenAnimationTransparency(tShot->mEntityID, tTransparency);
+	}
+
 	int isShotGroup(std::string tName) {
 		turnStringLowercase(tName);
 		return stringBeginsWithSubstring(tName.data(), "shot ");
 	}
 
-	void loadShotGroup(MugenDefScriptGroup* tGroup) {
+	static string getShotGroupName(MugenDefScriptGroup* tGroup) {
 		char shotPre[100], shotName[100];
 		sscanf(tGroup->mName.data(), "%s %s", shotPre, shotName);
 		turnStringLowercase(shotName);
+		return shotName;
+	}
 
-		mLoadedShots.insert(make_pair(shotName, ShotData(tGroup)));
+	void loadShotGroup(MugenDefScriptGroup* tGroup) {
+		mLoadedShots.insert(make_pair(getShotGroupName(tGroup), ShotData(tGroup)));
 	}
 
 	void loadShotsFromScript(MugenDefScript& tScript) {
@@ -158,6 +245,12 @@ struct ShotHandler {
 		}
 	}
 
+	void loadShotsFromTemplates() {
+		for (const auto& shotTemplate : gShotTemplates) {
+			mLoadedShots.insert(make_pair(shotTemplate.mName, ShotData(shotTemplate)));
+		}
+	}
+
 	void addShot(void* tOwner, Position tPos, ShotHandler::ShotData tData, int tList) {
 		int id = stl_int_map_get_id();
 		mShots[id] = make_unique<ShotHandler::Shot>(tOwner, tPos, tData, tList, id);
@@ -249,7 +342,7 @@ struct ShotHandler {
 		double angle = (tAngleOffset / 360.0) * 2 * M_PI;
 		delta = vecRotateZ(delta, angle);
 		setBlitzPhysicsVelocity(tShot->mEntityID, tSpeed * delta);
-		setBlitzMugenAnimationAngle(tShot->mEntityID, 2 * M_PI - angle);
+		setShotAngle(tShot, 2 * M_PI - angle);
 	}
 
 	static void setShotNormalAngleBegin(ShotHandler::Shot* tShot, int tAngleOffset, double tSpeed) {
@@ -405,7 +498,7 @@ struct ShotHandler {
 			delta = vecRotateZ(delta, (tAngleOffset / 360.0) * 2 * M_PI);
 			delta = vecNormalize(delta);
 			setBlitzPhysicsVelocity(tShot->mEntityID, tSpeed * delta);
-			setBlitzMugenAnimationAngle(tShot->mEntityID, getAngleFromDirection(delta) + M_PI / 2);
+			setShotAngle(tShot, getAngleFromDirection(delta) + M_PI / 2);
 
 			return 180-int(((getAngleFromDirection(delta) + M_PI / 2) / (2* M_PI)) * 360);
 	}
@@ -434,7 +527,7 @@ struct ShotHandler {
 			double angle = (angleInteger / 360.0) * 2 * M_PI;
 			delta = vecRotateZ(delta, angle);
 			setBlitzPhysicsVelocity(tShot->mEntityID, tSpeed * delta);
-			setBlitzMugenAnimationAngle(tShot->mEntityID, 2 * M_PI - angle);
+			setShotAngle(tShot, 2 * M_PI - angle);
 		}
 	}
 
@@ -446,6 +539,12 @@ struct ShotHandler {
 		setShotAimedAngleBegin(tCaller, tShot, randfromInteger(-45, 45), 0.7);
 		return 0;
 	}
+	static int enemyHoming(void* tCaller, ShotHandler::Shot* tShot) {
+		if (tShot->mCurrentFrame <= 90 && !(tShot->mCurrentFrame % 10)) {
+			setShotAimedAngle(tCaller, tShot, 0, 1.5);
+		}
+		return 0;
+	}
 	static int enemyWideningAngle(void* tCaller, ShotHandler::Shot* tShot) {
 		ActiveEnemy* shooter = (ActiveEnemy*)tCaller;
 		int angle = std::min(90, shooter->m_DeltaTime / 4);
@@ -1443,8 +1542,8 @@ struct ShotHandler {
 						}
 						if (tShot->mCurrentFrame >= first && tShot->mCurrentFrame <= last) {
 							double t = (tShot->mCurrentFrame - first) / double(last - first);
-							setBlitzMugenAnimationColor(tShot->mEntityID, 1 - t, 1 - t, 1 - t);
-							setBlitzMugenAnimationTransparency(tShot->mEntityID, 1 - t);
+							setShotColor(tShot, 1 - t, 1 - t, 1 - t);
+							setShotTransparency(tShot, 1 - t);
 						}
 					}
 
@@ -1651,7 +1750,7 @@ struct ShotHandler {
 			Position p = getBossPosition();
 			function<int(void*, ShotHandler::Shot*)> func = [](void* tCaller, ShotHandler::Shot* tShot) {
 				setShotAimedAngleBegin(nullptr, tShot, 0, 3);
-				setBlitzEntityRotationZ(tShot->mEntityID, tShot->mCurrentFrame * 0.1);
+				setShotAngle(tShot, tShot->mCurrentFrame * 0.1);
 				return 0;
 			};
 			addDynamicSubShot(tCaller, p, "shii_world", getEnemyShotCollisionList(), func);
@@ -1995,7 +2094,7 @@ struct ShotHandler {
 			Position p = getBossPosition();
 			function<int(void*, ShotHandler::Shot*)> func = [](void* tCaller, ShotHandler::Shot* tShot) {
 				setShotAimedAngle(nullptr, tShot, 0, 0.2);
-				setBlitzEntityRotationZ(tShot->mEntityID, tShot->mCurrentFrame * 0.2);
+				setShotAngle(tShot, tShot->mCurrentFrame * 0.2);
 				addRandomWorldShot(getBlitzEntityPosition(tShot->mEntityID));
 				return 0;
 			};
@@ -3625,6 +3724,7 @@ struct ShotHandler {
 		mGimmicks["enemyStraight"] = (void*)enemyStraight;
 		mGimmicks["enemyAimed"] = (void*)enemyAimed;
 		mGimmicks["enemyAimedWide"] = (void*)enemyAimedWide;
+		mGimmicks["enemyHoming"] = (void*)enemyHoming;
 		mGimmicks["enemyWideningAngle"] = (void*)enemyWideningAngle;
 		mGimmicks["enemyAimedPlus10"] = (void*)enemyAimed10;
 		mGimmicks["enemyAimedPlus20"] = (void*)enemyAimed20;
@@ -3753,25 +3853,35 @@ struct ShotHandler {
 
 	ShotHandler() {
 		mSelf = this;
-		mSprites = loadMugenSpriteFileWithoutPalette("data/SHOTS.sff");
-		mAnimations = loadMugenAnimationFile("data/SHOTS.air");
+		mSprites = acquireCachedMugenSpriteFile("data/SHOTS.sff");
+		mAnimations = acquireCachedMugenAnimationFile("data/SHOTS.air");
 
 		mLoadedShots.clear();
 		mShots.clear();
 		mGimmicks.clear();
 		loadShotGimmicks();
+		startGimmickStatsRun();
+		setBulletBatchFill(BULLET_BATCH_SHOTS, fillBulletBatch);
 
+#ifdef SHOTS_FROM_DEF_FILE
 		MugenDefScript script;
 		loadMugenDefScript(&script, "data/SHOTS.def");
 		loadShotsFromScript(script);
 
 		unloadMugenDefScript(script);
+#else
+		loadShotsFromTemplates();
+#endif
 	}
 
 	~ShotHandler() {
+		setBulletBatchFill(BULLET_BATCH_SHOTS, nullptr);
+		reportGimmickStats();
 		mLoadedShots.clear();
 		mShots.clear();
 		mGimmicks.clear();
+		releaseCachedMugenSpriteFile("data/SHOTS.sff");
+		releaseCachedMugenAnimationFile("data/SHOTS.air");
 	}
 
 	int isShotOutOfBounds(Shot& tShot) {
@@ -3787,7 +3897,7 @@ struct ShotHandler {
 
 		int ret = 0;
 		if (tShot.mGimmick) {
-			ret |= tShot.mGimmick(tShot.mOwner, &tShot);
+			ret |= tShot.runGimmick();
 		}
 
 		if (tShot.mHasEntity) {
@@ -3801,13 +3911,27 @@ struct ShotHandler {
 	}
 
 	void update() {
+		ProfileScope profileScope(PROFILE_ZONE_SHOTS);
+		addGimmickStatsFrame();
 		stl_int_map_remove_predicate(*this, mShots, &ShotHandler::updateSingleShot);
 	}
 
+	static void fillBulletBatch() {
+		for (auto& shotPair : mSelf->mShots) {
+			const Shot& shot = *shotPair.second;
+			if (!shot.mIsBatched) continue;
+			addBatchedBullet(BULLET_BATCH_SHOTS, getBlitzEntityPosition(shot.mEntityID), shot.mAngle, shot.mAnimation, 0, shot.mColor, shot.mTransparency);
+		}
+	}
+
 	int removeSingleEnemyBullet(Shot& shot) {
 		return shot.mCollisionList == getEnemyShotCollisionList();
 	}
 
+	int removeSinglePlayerBullet(Shot& shot) {
+		return shot.mCollisionList == getPlayerShotCollisionList();
+	}
+
 	int removeSingleEnemyBulletExceptComplex(Shot& shot) {
 		if (shot.mCollisionList != getEnemyShotCollisionList()) return 0;
 
@@ -3828,6 +3952,11 @@ void removeEnemyBullets()
 	stl_int_map_remove_predicate(*gShotHandler, gShotHandler->mShots, &ShotHandler::removeSingleEnemyBullet);
 }
 
+void removePlayerBullets()
+{
+	stl_int_map_remove_predicate(*gShotHandler, gShotHandler->mShots, &ShotHandler::removeSinglePlayerBullet);
+}
+
 void removeEnemyBulletsExceptComplex()
 {
 	stl_int_map_remove_predicate(*gShotHandler, gShotHandler->mShots, &ShotHandler::removeSingleEnemyBulletExceptComplex);
@@ -3839,6 +3968,26 @@ int getShotDamage(void * tCollisionData)
 	return shot->mDamage;
 }
 
+// The gimmick user data is left out, since gimmicks only fill the part they use.
+void addShotStateHash(StateHash& oHash)
+{
+	for (auto& shotPair : gShotHandler->mShots) {
+		const auto& shot = *shotPair.second;
+		addStateHashInt(oHash, shot.mCurrentFrame);
+		addStateHashInt(oHash, shot.mCollisionList);
+		addStateHashDouble(oHash, shot.mAngle);
+		if (shot.mHasEntity) {
+			addStateHashPosition(oHash, getBlitzEntityPosition(shot.mEntityID));
+			addStateHashPosition(oHash, getBlitzPhysicsVelocity(shot.mEntityID));
+		}
+	}
+}
+
+int getActiveShotAmount()
+{
+	return int(gShotHandler->mShots.size());
+}
+
 void addShot(void* tOwner, Position tPos, std::string tName, int tList)
 {
 	ShotHandler::ShotData data = gShotHandler->mLoadedShots[tName];
@@ -11,5 +11,10 @@ void addShot(void* tOwner, Position tPos, std::string tName, int tList);
 void addAngledShot(void* tCaller, Position tPosition, const std::string& tName, int tCollisionList, int tAngle = 0, double tSpeed = 2);
 void addAimedShot(void* tCaller, Position tPosition, const std::string& tName, int tCollisionList, int tAngleOffset = 0, double tSpeed = 2);
 void removeEnemyBullets();
+void removePlayerBullets();
 void removeEnemyBulletsExceptComplex();
-int getShotDamage(void* tCollisionData);
\ No newline at end of file
+int getShotDamage(void* tCollisionData);
+int getActiveShotAmount();
+
+struct StateHash;
+void addShotStateHash(StateHash& oHash);
\ No newline at end of file
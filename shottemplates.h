@@ -0,0 +1,18 @@
+#pragma once
+
+struct ShotSubShotTemplate {
+	int mTemplate;
+	double mOffsetX;
+	double mOffsetY;
+};
+
+struct ShotTemplate {
+	const char* mName;
+	int mHasAnimation;
+	int mAnimation;
+	int mDamage;
+	double mCollisionRadius;
+	int mGimmick;
+	int mSubShotStart;
+	int mSubShotAmount;
+};
@@ -0,0 +1,124 @@
+#include "spriteatlas.h"
+
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <prism/log.h>
+#include <prism/memoryhandler.h>
+
+#include "assetpack.h"
+#include "assetpackformat.h"
+#include "assetprefetch.h"
+#include "spriteatlasformat.h"
+
+using namespace std;
+
+// Texture atlas pages built by tools/atlasgen, with a region per sprite of the packed sheets.
+// Sprites are addressed by sheet path, group and item like in the sprite files, so draw code can look up
+// which page and rectangle to draw instead of binding every sprite's own texture.
+// A missing or outdated atlas file loads as an empty atlas, in which case every lookup fails.
+
+static int isValidSpriteAtlas(const uint8_t* tData, uint32_t tSize) {
+	if (tSize < sizeof(SpriteAtlasHeader)) return 0;
+	const SpriteAtlasHeader* header = (const SpriteAtlasHeader*)tData;
+	if (memcmp(header->mMagic, SPRITE_ATLAS_MAGIC, 4) || header->mVersion != SPRITE_ATLAS_VERSION) return 0;
+	const uint64_t tableSize = sizeof(SpriteAtlasHeader) + uint64_t(header->mPageAmount) * sizeof(SpriteAtlasPageEntry) + uint64_t(header->mSheetAmount) * sizeof(SpriteAtlasSheetEntry) + uint64_t(header->mRegionAmount) * sizeof(SpriteAtlasRegionEntry) + header->mPathTableSize;
+	return tableSize <= tSize;
+}
+
+static void loadSpriteAtlasPages(SpriteAtlas* tAtlas, const uint8_t* tData, uint32_t tSize, const SpriteAtlasPageEntry* tPages, uint32_t tPageAmount) {
+	for (uint32_t i = 0; i < tPageAmount; i++) {
+		const auto& entry = tPages[i];
+		const uint32_t pixelSize = entry.mWidth * entry.mHeight * 4;
+		char* pixels = (char*)allocMemory(int(pixelSize));
+		if (uint64_t(entry.mDataOffset) + entry.mStoredSize > tSize || !decompressAssetPackLZ(tData + entry.mDataOffset, entry.mStoredSize, (uint8_t*)pixels, pixelSize)) {
+			logWarningFormat("Unable to decompress sprite atlas page %d", int(i));
+			freeMemory(pixels);
+			unloadSpriteAtlas(tAtlas);
+			return;
+		}
+
+		Buffer buffer = makeBufferOwned(pixels, pixelSize);
+		tAtlas->mPages.push_back(loadTextureFromARGB32Buffer(buffer, int(entry.mWidth), int(entry.mHeight)));
+		freeBuffer(buffer);
+	}
+}
+
+SpriteAtlas loadSpriteAtlas(const std::string& tPath)
+{
+	SpriteAtlas ret;
+	if (!hasAssetPackFile(tPath) && !isFile(tPath.data())) {
+		logWarningFormat("Sprite atlas %s not found, drawing sprites from their sheets.", tPath.data());
+		return ret;
+	}
+
+	Buffer buffer = takePrefetchedAssetFile(tPath);
+	const uint8_t* data = (const uint8_t*)buffer.mData;
+	if (!isValidSpriteAtlas(data, buffer.mLength)) {
+		logWarningFormat("Sprite atlas %s is invalid or outdated, drawing sprites from their sheets.", tPath.data());
+		freePrefetchedAssetFile(buffer);
+		return ret;
+	}
+
+	const SpriteAtlasHeader* header = (const SpriteAtlasHeader*)data;
+	const SpriteAtlasPageEntry* pages = (const SpriteAtlasPageEntry*)(header + 1);
+	const SpriteAtlasSheetEntry* sheets = (const SpriteAtlasSheetEntry*)(pages + header->mPageAmount);
+	const SpriteAtlasRegionEntry* regions = (const SpriteAtlasRegionEntry*)(sheets + header->mSheetAmount);
+	const char* pathTable = (const char*)(regions + header->mRegionAmount);
+
+	for (uint32_t i = 0; i < header->mSheetAmount; i++) {
+		SpriteAtlasSheet sheet;
+		sheet.mPath = string(pathTable + sheets[i].mPathOffset, sheets[i].mPathLength);
+		for (uint32_t j = 0; j < sheets[i].mRegionAmount; j++) {
+			const auto& entry = regions[sheets[i].mRegionStart + j];
+			SpriteAtlasRegion region;
+			region.mGroup = entry.mGroup;
+			region.mItem = entry.mItem;
+			region.mPage = int(entry.mPage);
+			region.mX = int(entry.mX);
+			region.mY = int(entry.mY);
+			region.mWidth = int(entry.mWidth);
+			region.mHeight = int(entry.mHeight);
+			region.mAxisX = entry.mAxisX;
+			region.mAxisY = entry.mAxisY;
+			sheet.mRegions.push_back(region);
+		}
+		ret.mSheets.push_back(sheet);
+	}
+
+	loadSpriteAtlasPages(&ret, data, buffer.mLength, pages, header->mPageAmount);
+	freePrefetchedAssetFile(buffer);
+	return ret;
+}
+
+void unloadSpriteAtlas(SpriteAtlas* tAtlas)
+{
+	for (auto& page : tAtlas->mPages) {
+		unloadTexture(page);
+	}
+	tAtlas->mPages.clear();
+	tAtlas->mSheets.clear();
+}
+
+const SpriteAtlasSheet* getSpriteAtlasSheet(const SpriteAtlas* tAtlas, const std::string& tSheetPath)
+{
+	string path = tSheetPath;
+	for (auto& c : path) c = char(tolower((unsigned char)c));
+	auto it = lower_bound(tAtlas->mSheets.begin(), tAtlas->mSheets.end(), path, [](const SpriteAtlasSheet& tSheet, const string& tPath) { return tSheet.mPath < tPath; });
+	if (it == tAtlas->mSheets.end() || it->mPath != path) return NULL;
+	return &(*it);
+}
+
+const SpriteAtlasRegion* getSpriteAtlasRegion(const SpriteAtlasSheet* tSheet, int tGroup, int tItem)
+{
+	if (!tSheet) return NULL;
+	auto it = lower_bound(tSheet->mRegions.begin(), tSheet->mRegions.end(), make_pair(tGroup, tItem), [](const SpriteAtlasRegion& tRegion, const pair<int, int>& tKey) { return make_pair(tRegion.mGroup, tRegion.mItem) < tKey; });
+	if (it == tSheet->mRegions.end() || it->mGroup != tGroup || it->mItem != tItem) return NULL;
+	return &(*it);
+}
+
+TextureData* getSpriteAtlasPageTexture(SpriteAtlas* tAtlas, int tPage)
+{
+	return &tAtlas->mPages[tPage];
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <prism/texture.h>
+
+struct SpriteAtlasRegion {
+	int mGroup;
+	int mItem;
+	int mPage;
+	int mX;
+	int mY;
+	int mWidth;
+	int mHeight;
+	int mAxisX;
+	int mAxisY;
+};
+
+struct SpriteAtlasSheet {
+	std::string mPath;
+	std::vector<SpriteAtlasRegion> mRegions;
+};
+
+struct SpriteAtlas {
+	std::vector<TextureData> mPages;
+	std::vector<SpriteAtlasSheet> mSheets;
+};
+
+SpriteAtlas loadSpriteAtlas(const std::string& tPath);
+void unloadSpriteAtlas(SpriteAtlas* tAtlas);
+
+const SpriteAtlasSheet* getSpriteAtlasSheet(const SpriteAtlas* tAtlas, const std::string& tSheetPath);
+const SpriteAtlasRegion* getSpriteAtlasRegion(const SpriteAtlasSheet* tSheet, int tGroup, int tItem);
+TextureData* getSpriteAtlasPageTexture(SpriteAtlas* tAtlas, int tPage);
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+// Layout of the sprite atlas file written by tools/atlasgen.
+// All integers are little endian, like in assetpackformat.h.
+//
+// SpriteAtlasHeader
+// SpriteAtlasPageEntry[mPageAmount]
+// SpriteAtlasSheetEntry[mSheetAmount], sorted by lowercase path
+// SpriteAtlasRegionEntry[mRegionAmount], each sheet's regions sorted by group and item
+// path table, mPathTableSize bytes of non-terminated lowercase sheet paths
+// page data, 32-bit pixels in the same byte order as decoded sprites, compressed with the asset pack LZ block format
+
+#define SPRITE_ATLAS_MAGIC "YRAT"
+#define SPRITE_ATLAS_VERSION 1
+// The PVR cannot address textures larger than this.
+#define SPRITE_ATLAS_MAX_PAGE_SIZE 1024
+#define SPRITE_ATLAS_PADDING 1
+
+struct SpriteAtlasHeader {
+	char mMagic[4];
+	uint32_t mVersion;
+	uint32_t mPageAmount;
+	uint32_t mSheetAmount;
+	uint32_t mRegionAmount;
+	uint32_t mPathTableSize;
+};
+
+struct SpriteAtlasPageEntry {
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mDataOffset;
+	uint32_t mStoredSize;
+};
+
+struct SpriteAtlasSheetEntry {
+	uint32_t mPathOffset;
+	uint32_t mPathLength;
+	uint32_t mRegionStart;
+	uint32_t mRegionAmount;
+};
+
+struct SpriteAtlasRegionEntry {
+	int32_t mGroup;
+	int32_t mItem;
+	uint32_t mPage;
+	uint32_t mX;
+	uint32_t mY;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	int32_t mAxisX;
+	int32_t mAxisY;
+};
+
+// Shelf packing of sprite sizes that are sorted by descending height.
+// Returns how many of them, starting from the first, fit into a page of tWidth x tHeight and their positions.
+static inline size_t packSpriteAtlasShelves(const std::vector<std::pair<uint32_t, uint32_t>>& tSizes, uint32_t tWidth, uint32_t tHeight, std::vector<std::pair<uint32_t, uint32_t>>& oPositions) {
+	oPositions.clear();
+	uint32_t x = 0, y = 0, shelfHeight = 0;
+	for (auto& size : tSizes) {
+		const uint32_t w = size.first + SPRITE_ATLAS_PADDING;
+		const uint32_t h = size.second + SPRITE_ATLAS_PADDING;
+		if (w > tWidth) break;
+		if (x + w > tWidth) {
+			x = 0;
+			y += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (y + h > tHeight) break;
+		oPositions.push_back(std::make_pair(x, y));
+		x += w;
+		shelfHeight = h > shelfHeight ? h : shelfHeight;
+	}
+	return oPositions.size();
+}
+
+// Packs as many of the sizes as possible into one page, trying every power of two from small to large,
+// growing width and height in turn, and taking the first that holds everything.
+static inline size_t packSpriteAtlasPage(const std::vector<std::pair<uint32_t, uint32_t>>& tSizes, uint32_t* oWidth, uint32_t* oHeight, std::vector<std::pair<uint32_t, uint32_t>>& oPositions) {
+	uint32_t width = 32, height = 32;
+	while (packSpriteAtlasShelves(tSizes, width, height, oPositions) < tSizes.size()) {
+		if (width == SPRITE_ATLAS_MAX_PAGE_SIZE && height == SPRITE_ATLAS_MAX_PAGE_SIZE) break;
+		if (width <= height) width *= 2;
+		else height *= 2;
+	}
+	*oWidth = width;
+	*oHeight = height;
+	return oPositions.size();
+}
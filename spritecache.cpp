@@ -0,0 +1,325 @@
+#include "spritecache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <prism/log.h>
+
+#include "spritedecoder.h"
+
+using namespace std;
+
+// Keeps the decoded pixels of every sprite file in cache/sprites, so a load only has to upload them.
+// A cache file stores the hash of the SFF it was decoded from and is rebuilt as soon as that does not match.
+// Files queued for predecoding are decoded on another thread (see bootloader.cpp) and picked up by the next load.
+// Only PNG sprites are decoded here (see spritedecoder.cpp); files with any other sprite format go through the Prism loader uncached.
+//
+// DecodedSpriteCacheHeader
+// DecodedSpriteCacheEntry[mSpriteAmount]
+// pixel data, 32-bit BGRA rows without padding, each sprite starting at a multiple of DECODED_SPRITE_CACHE_ALIGNMENT
+
+#define DECODED_SPRITE_CACHE_DIRECTORY "cache/sprites"
+#define DECODED_SPRITE_CACHE_MAGIC "YRDS"
+#define DECODED_SPRITE_CACHE_VERSION 1
+#define DECODED_SPRITE_CACHE_ALIGNMENT 32
+
+struct DecodedSpriteCacheHeader {
+	char mMagic[4];
+	uint32_t mVersion;
+	uint64_t mSourceHash;
+	uint32_t mSourceSize;
+	uint32_t mSpriteAmount;
+};
+
+struct DecodedSpriteCacheEntry {
+	int32_t mGroup;
+	int32_t mItem;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	int32_t mAxisX;
+	int32_t mAxisY;
+	uint32_t mDataOffset;
+	uint32_t mDataSize;
+};
+
+struct PredecodedSpriteFile {
+	uint64_t mSourceHash = 0;
+	uint32_t mSourceSize = 0;
+	vector<DecodedSprite> mSprites;
+	vector<DecodedSpriteCacheEntry> mEntries;
+	int mIsDecoded = 0;
+	int mIsDone = 0;
+};
+
+static struct {
+	map<string, shared_ptr<PredecodedSpriteFile>> mPredecodedFiles;
+	mutex mMutex;
+	condition_variable mDoneCondition;
+} gSpriteCache;
+
+static uint64_t hashSource(const uint8_t* tData, uint32_t tSize) {
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t i = 0; i < tSize; i++) {
+		hash ^= tData[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static string getDecodedSpriteCachePath(const string& tPath) {
+	string name = tPath;
+	for (auto& c : name) {
+		if (c == '/' || c == '\\' || c == ':' || c == '$') c = '_';
+	}
+	return string(DECODED_SPRITE_CACHE_DIRECTORY) + "/" + name + ".dec";
+}
+
+static void createDecodedSpriteCacheDirectory() {
+#ifdef _WIN32
+	_mkdir("cache");
+	_mkdir(DECODED_SPRITE_CACHE_DIRECTORY);
+#else
+	mkdir("cache", 0755);
+	mkdir(DECODED_SPRITE_CACHE_DIRECTORY, 0755);
+#endif
+}
+
+static uint32_t alignDecodedSpriteOffset(uint32_t tValue) {
+	return (tValue + DECODED_SPRITE_CACHE_ALIGNMENT - 1) & ~uint32_t(DECODED_SPRITE_CACHE_ALIGNMENT - 1);
+}
+
+static void writeDecodedSpriteCache(const string& tCachePath, uint64_t tSourceHash, uint32_t tSourceSize, const vector<DecodedSprite>& tSprites, vector<DecodedSpriteCacheEntry>& oEntries) {
+	createDecodedSpriteCacheDirectory();
+
+	DecodedSpriteCacheHeader header;
+	memcpy(header.mMagic, DECODED_SPRITE_CACHE_MAGIC, 4);
+	header.mVersion = DECODED_SPRITE_CACHE_VERSION;
+	header.mSourceHash = tSourceHash;
+	header.mSourceSize = tSourceSize;
+	header.mSpriteAmount = uint32_t(tSprites.size());
+
+	uint32_t dataOffset = alignDecodedSpriteOffset(uint32_t(sizeof(DecodedSpriteCacheHeader) + tSprites.size() * sizeof(DecodedSpriteCacheEntry)));
+	oEntries.resize(tSprites.size());
+	for (size_t i = 0; i < tSprites.size(); i++) {
+		auto& entry = oEntries[i];
+		entry.mGroup = tSprites[i].mGroup;
+		entry.mItem = tSprites[i].mItem;
+		entry.mWidth = tSprites[i].mWidth;
+		entry.mHeight = tSprites[i].mHeight;
+		entry.mAxisX = tSprites[i].mAxisX;
+		entry.mAxisY = tSprites[i].mAxisY;
+		entry.mDataOffset = dataOffset;
+		entry.mDataSize = uint32_t(tSprites[i].mPixels.size());
+		dataOffset = alignDecodedSpriteOffset(dataOffset + entry.mDataSize);
+	}
+
+	const string temporaryPath = tCachePath + ".tmp";
+	FILE* file = fopen(temporaryPath.data(), "wb");
+	if (!file) return;
+
+	int isWritten = fwrite(&header, sizeof(header), 1, file) == 1;
+	isWritten = isWritten && fwrite(oEntries.data(), sizeof(DecodedSpriteCacheEntry), oEntries.size(), file) == oEntries.size();
+	for (size_t i = 0; i < tSprites.size(); i++) {
+		isWritten = isWritten && !fseek(file, oEntries[i].mDataOffset, SEEK_SET);
+		isWritten = isWritten && fwrite(tSprites[i].mPixels.data(), 1, tSprites[i].mPixels.size(), file) == tSprites[i].mPixels.size();
+	}
+	fclose(file);
+
+	remove(tCachePath.data());
+	if (!isWritten || rename(temporaryPath.data(), tCachePath.data())) {
+		logWarningFormat("Unable to write decoded sprite cache %s", tCachePath.data());
+		remove(temporaryPath.data());
+	}
+}
+
+static void addDecodedSprite(MugenSpriteFile* oFile, const DecodedSpriteCacheEntry& tEntry, const uint8_t* tPixels) {
+	Buffer pixels = makeBuffer((void*)tPixels, tEntry.mDataSize);
+	auto sprite = makeMugenSpriteFileSpriteFromARGB32Buffer(pixels, tEntry.mWidth, tEntry.mHeight, Vector2D(tEntry.mAxisX, tEntry.mAxisY));
+	addMugenSpriteFileSprite(oFile, tEntry.mGroup, tEntry.mItem, sprite);
+}
+
+static int isDecodedSpriteCacheValid(const uint8_t* tData, size_t tSize, uint64_t tSourceHash, uint32_t tSourceSize) {
+	if (tSize < sizeof(DecodedSpriteCacheHeader)) return 0;
+	DecodedSpriteCacheHeader header;
+	memcpy(&header, tData, sizeof(header));
+	if (memcmp(header.mMagic, DECODED_SPRITE_CACHE_MAGIC, 4) || header.mVersion != DECODED_SPRITE_CACHE_VERSION) return 0;
+	if (header.mSourceHash != tSourceHash || header.mSourceSize != tSourceSize) return 0;
+	if (sizeof(DecodedSpriteCacheHeader) + uint64_t(header.mSpriteAmount) * sizeof(DecodedSpriteCacheEntry) > tSize) return 0;
+
+	const DecodedSpriteCacheEntry* entries = (const DecodedSpriteCacheEntry*)(tData + sizeof(DecodedSpriteCacheHeader));
+	for (uint32_t i = 0; i < header.mSpriteAmount; i++) {
+		if (uint64_t(entries[i].mDataOffset) + entries[i].mDataSize > tSize) return 0;
+		if (uint64_t(entries[i].mWidth) * entries[i].mHeight * 4 != entries[i].mDataSize) return 0;
+	}
+	return 1;
+}
+
+static int loadFromDecodedSpriteCacheData(MugenSpriteFile* oFile, const uint8_t* tData, size_t tSize, uint64_t tSourceHash, uint32_t tSourceSize) {
+	if (!isDecodedSpriteCacheValid(tData, tSize, tSourceHash, tSourceSize)) return 0;
+
+	DecodedSpriteCacheHeader header;
+	memcpy(&header, tData, sizeof(header));
+	const DecodedSpriteCacheEntry* entries = (const DecodedSpriteCacheEntry*)(tData + sizeof(DecodedSpriteCacheHeader));
+
+	*oFile = makeEmptyMugenSpriteFile();
+	for (uint32_t i = 0; i < header.mSpriteAmount; i++) {
+		addDecodedSprite(oFile, entries[i], tData + entries[i].mDataOffset);
+	}
+	return 1;
+}
+
+// Calls tFunction with the whole cache file, mapped on Linux and read into memory elsewhere.
+template<typename Function>
+static int withDecodedSpriteCacheData(const string& tCachePath, Function tFunction) {
+#ifdef __linux__
+	int file = open(tCachePath.data(), O_RDONLY);
+	if (file < 0) return 0;
+
+	struct stat info;
+	if (fstat(file, &info) || !info.st_size) {
+		close(file);
+		return 0;
+	}
+	void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED) return 0;
+
+	int ret = tFunction((const uint8_t*)mapping, size_t(info.st_size));
+	munmap(mapping, info.st_size);
+	return ret;
+#else
+	FILE* file = fopen(tCachePath.data(), "rb");
+	if (!file) return 0;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	vector<uint8_t> data(size > 0 ? size : 0);
+	int isRead = size > 0 && fread(data.data(), 1, size, file) == size_t(size);
+	fclose(file);
+
+	return isRead && tFunction((const uint8_t*)data.data(), data.size());
+#endif
+}
+
+static int loadFromDecodedSpriteCache(MugenSpriteFile* oFile, const string& tCachePath, uint64_t tSourceHash, uint32_t tSourceSize) {
+	return withDecodedSpriteCacheData(tCachePath, [&](const uint8_t* tData, size_t tSize) {
+		return loadFromDecodedSpriteCacheData(oFile, tData, tSize, tSourceHash, tSourceSize);
+	});
+}
+
+static int hasValidDecodedSpriteCache(const string& tCachePath, uint64_t tSourceHash, uint32_t tSourceSize) {
+	return withDecodedSpriteCacheData(tCachePath, [&](const uint8_t* tData, size_t tSize) {
+		return isDecodedSpriteCacheValid(tData, tSize, tSourceHash, tSourceSize);
+	});
+}
+
+static shared_ptr<PredecodedSpriteFile> takePredecodedSpriteFile(const string& tPath) {
+	unique_lock<mutex> lock(gSpriteCache.mMutex);
+	auto it = gSpriteCache.mPredecodedFiles.find(tPath);
+	if (it == gSpriteCache.mPredecodedFiles.end()) return nullptr;
+
+	auto file = it->second;
+	gSpriteCache.mDoneCondition.wait(lock, [&file] { return file->mIsDone != 0; });
+	gSpriteCache.mPredecodedFiles.erase(it);
+	return file;
+}
+
+static MugenSpriteFile makeMugenSpriteFileFromDecodedSprites(const vector<DecodedSprite>& tSprites, const vector<DecodedSpriteCacheEntry>& tEntries) {
+	MugenSpriteFile ret = makeEmptyMugenSpriteFile();
+	for (size_t i = 0; i < tSprites.size(); i++) {
+		addDecodedSprite(&ret, tEntries[i], tSprites[i].mPixels.data());
+	}
+	return ret;
+}
+
+int isDecodedSpriteCacheEnabled()
+{
+#if defined(DREAMCAST) || defined(__EMSCRIPTEN__)
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+MugenSpriteFile loadMugenSpriteFileWithDecodedSpriteCache(const std::string& tPath, Buffer& tSource)
+{
+	if (!isDecodedSpriteCacheEnabled()) return loadMugenSpriteFileWithoutPaletteFromBuffer(tSource);
+
+	const uint8_t* source = (const uint8_t*)tSource.mData;
+	const uint64_t sourceHash = hashSource(source, tSource.mLength);
+	const string cachePath = getDecodedSpriteCachePath(tPath);
+
+	auto predecoded = takePredecodedSpriteFile(tPath);
+	if (predecoded && predecoded->mIsDecoded && predecoded->mSourceHash == sourceHash && predecoded->mSourceSize == tSource.mLength) {
+		return makeMugenSpriteFileFromDecodedSprites(predecoded->mSprites, predecoded->mEntries);
+	}
+
+	MugenSpriteFile ret;
+	if (loadFromDecodedSpriteCache(&ret, cachePath, sourceHash, tSource.mLength)) return ret;
+
+	vector<DecodedSprite> sprites;
+	if (!decodeSpriteFilePixels(source, tSource.mLength, sprites, getSpriteDecoderThreadAmount())) return loadMugenSpriteFileWithoutPaletteFromBuffer(tSource);
+
+	vector<DecodedSpriteCacheEntry> entries;
+	writeDecodedSpriteCache(cachePath, sourceHash, tSource.mLength, sprites, entries);
+	return makeMugenSpriteFileFromDecodedSprites(sprites, entries);
+}
+
+void queueMugenSpriteFilePredecode(const std::string& tPath)
+{
+	if (!isDecodedSpriteCacheEnabled()) return;
+
+	lock_guard<mutex> lock(gSpriteCache.mMutex);
+	if (gSpriteCache.mPredecodedFiles.count(tPath)) return;
+	gSpriteCache.mPredecodedFiles[tPath] = make_shared<PredecodedSpriteFile>();
+}
+
+void predecodeMugenSpriteFile(const std::string& tPath, const std::vector<uint8_t>& tSource)
+{
+	shared_ptr<PredecodedSpriteFile> file;
+	{
+		lock_guard<mutex> lock(gSpriteCache.mMutex);
+		auto it = gSpriteCache.mPredecodedFiles.find(tPath);
+		if (it == gSpriteCache.mPredecodedFiles.end() || it->second->mIsDone) return;
+		file = it->second;
+	}
+
+	// A valid cache file is left to the main thread, which can upload straight from the mapping.
+	const uint32_t sourceSize = uint32_t(tSource.size());
+	const uint64_t sourceHash = hashSource(tSource.data(), sourceSize);
+	const string cachePath = getDecodedSpriteCachePath(tPath);
+	vector<DecodedSprite> sprites;
+	vector<DecodedSpriteCacheEntry> entries;
+	int isDecoded = 0;
+	if (!tSource.empty() && !hasValidDecodedSpriteCache(cachePath, sourceHash, sourceSize) && decodeSpriteFilePixels(tSource.data(), sourceSize, sprites, 1)) {
+		writeDecodedSpriteCache(cachePath, sourceHash, sourceSize, sprites, entries);
+		isDecoded = 1;
+	}
+
+	lock_guard<mutex> lock(gSpriteCache.mMutex);
+	file->mSourceHash = sourceHash;
+	file->mSourceSize = sourceSize;
+	file->mSprites = move(sprites);
+	file->mEntries = move(entries);
+	file->mIsDecoded = isDecoded;
+	file->mIsDone = 1;
+	gSpriteCache.mDoneCondition.notify_all();
+}
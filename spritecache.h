@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <prism/file.h>
+#include <prism/mugenspritefilereader.h>
+
+int isDecodedSpriteCacheEnabled();
+MugenSpriteFile loadMugenSpriteFileWithDecodedSpriteCache(const std::string& tPath, Buffer& tSource);
+
+void queueMugenSpriteFilePredecode(const std::string& tPath);
+void predecodeMugenSpriteFile(const std::string& tPath, const std::vector<uint8_t>& tSource);
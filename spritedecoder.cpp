@@ -0,0 +1,358 @@
+#include "spritedecoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <png.h>
+#include <zlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Decodes the PNG sprites of SFF v2 files into 32-bit BGRA pixels.
+// The common case (8-bit RGBA, not interlaced) is inflated with zlib and unfiltered with SSE2 where available,
+// independent sprites of one file are decoded on separate threads.
+// Any other PNG is decoded through libpng, which is also what the benchmark in tools/spritebench compares against.
+
+struct SpriteNode {
+	DecodedSprite* mSprite;
+	const uint8_t* mData;
+	uint32_t mSize;
+};
+
+static uint32_t readUInt32(const uint8_t* tData) { return tData[0] | (tData[1] << 8) | (tData[2] << 16) | (uint32_t(tData[3]) << 24); }
+static uint16_t readUInt16(const uint8_t* tData) { return uint16_t(tData[0] | (tData[1] << 8)); }
+static uint32_t readBigEndianUInt32(const uint8_t* tData) { return (uint32_t(tData[0]) << 24) | (tData[1] << 16) | (tData[2] << 8) | tData[3]; }
+
+int readSpriteFileIndex(const uint8_t* tData, uint32_t tSize, std::vector<DecodedSprite>& oSprites, std::vector<SpriteFileNode>& oNodes)
+{
+	if (tSize < 68 || memcmp(tData, "ElecbyteSpr", 12) || tData[15] != 2) return 0;
+
+	const uint32_t spriteOffset = readUInt32(tData + 36);
+	const uint32_t spriteAmount = readUInt32(tData + 40);
+	const uint32_t literalOffset = readUInt32(tData + 52);
+	const uint32_t translatedOffset = readUInt32(tData + 60);
+	if (uint64_t(spriteOffset) + uint64_t(spriteAmount) * 28 > tSize) return 0;
+
+	oSprites.clear();
+	oSprites.resize(spriteAmount);
+	oNodes.resize(spriteAmount);
+	for (uint32_t i = 0; i < spriteAmount; i++) {
+		const uint8_t* node = tData + spriteOffset + i * 28;
+		const uint8_t format = node[14];
+		const uint32_t dataOffset = readUInt32(node + 16) + ((readUInt16(node + 26) & 1) ? translatedOffset : literalOffset);
+		const uint32_t dataSize = readUInt32(node + 20);
+		if (format != 11 && format != 12) return 0;
+		if (dataSize < 4 || uint64_t(dataOffset) + dataSize > tSize) return 0;
+
+		auto& sprite = oSprites[i];
+		sprite.mGroup = readUInt16(node);
+		sprite.mItem = readUInt16(node + 2);
+		sprite.mWidth = readUInt16(node + 4);
+		sprite.mHeight = readUInt16(node + 6);
+		sprite.mAxisX = int16_t(readUInt16(node + 8));
+		sprite.mAxisY = int16_t(readUInt16(node + 10));
+
+		oNodes[i].mDataOffset = dataOffset + 4;
+		oNodes[i].mDataSize = dataSize - 4;
+	}
+	return 1;
+}
+
+static int readSpriteNodes(const uint8_t* tData, uint32_t tSize, vector<DecodedSprite>& oSprites, vector<SpriteNode>& oNodes) {
+	vector<SpriteFileNode> fileNodes;
+	if (!readSpriteFileIndex(tData, tSize, oSprites, fileNodes)) return 0;
+
+	oNodes.resize(fileNodes.size());
+	for (size_t i = 0; i < fileNodes.size(); i++) {
+		oNodes[i].mSprite = &oSprites[i];
+		oNodes[i].mData = tData + fileNodes[i].mDataOffset;
+		oNodes[i].mSize = fileNodes[i].mDataSize;
+	}
+	return 1;
+}
+
+static int decodePNGWithLibPNG(const SpriteNode& tNode) {
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_memory(&image, tNode.mData, tNode.mSize)) return 0;
+
+	image.format = PNG_FORMAT_BGRA;
+	if (image.width != tNode.mSprite->mWidth || image.height != tNode.mSprite->mHeight) {
+		png_image_free(&image);
+		return 0;
+	}
+
+	tNode.mSprite->mPixels.resize(PNG_IMAGE_SIZE(image));
+	return png_image_finish_read(&image, NULL, tNode.mSprite->mPixels.data(), 0, NULL);
+}
+
+// Collects the IDAT data of PNGs the fast path handles, returns 0 for everything else.
+static int readPNGImageData(const SpriteNode& tNode, vector<uint8_t>& oImageData) {
+	static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	const uint8_t* data = tNode.mData;
+	if (tNode.mSize < 8 || memcmp(data, signature, 8)) return 0;
+
+	int hasHeader = 0;
+	uint32_t position = 8;
+	while (position + 12 <= tNode.mSize) {
+		const uint32_t length = readBigEndianUInt32(data + position);
+		const uint8_t* type = data + position + 4;
+		const uint8_t* body = data + position + 8;
+		if (uint64_t(position) + 12 + length > tNode.mSize) return 0;
+
+		if (!memcmp(type, "IHDR", 4)) {
+			if (length < 13) return 0;
+			if (readBigEndianUInt32(body) != tNode.mSprite->mWidth || readBigEndianUInt32(body + 4) != tNode.mSprite->mHeight) return 0;
+			if (body[8] != 8 || body[9] != 6 || body[10] || body[11] || body[12]) return 0;
+			hasHeader = 1;
+		}
+		else if (!memcmp(type, "IDAT", 4)) {
+			oImageData.insert(oImageData.end(), body, body + length);
+		}
+		else if (!memcmp(type, "IEND", 4)) {
+			break;
+		}
+		else if (!memcmp(type, "gAMA", 4) || !memcmp(type, "cHRM", 4) || !memcmp(type, "iCCP", 4) || !memcmp(type, "tRNS", 4)) {
+			return 0;
+		}
+		position += 12 + length;
+	}
+	return hasHeader && !oImageData.empty();
+}
+
+static inline uint8_t getPaethPredictor(int a, int b, int c) {
+	const int pa = abs(b - c);
+	const int pb = abs(a - c);
+	const int pc = abs(a + b - 2 * c);
+	if (pa <= pb && pa <= pc) return uint8_t(a);
+	if (pb <= pc) return uint8_t(b);
+	return uint8_t(c);
+}
+
+static void convertRowToBGRAScalar(const uint8_t* tRow, uint8_t* oPixels, uint32_t tWidth) {
+	for (uint32_t i = 0; i < tWidth; i++) {
+		oPixels[i * 4 + 0] = tRow[i * 4 + 2];
+		oPixels[i * 4 + 1] = tRow[i * 4 + 1];
+		oPixels[i * 4 + 2] = tRow[i * 4 + 0];
+		oPixels[i * 4 + 3] = tRow[i * 4 + 3];
+	}
+}
+
+#ifdef __SSE2__
+
+static inline __m128i loadPixel(const uint8_t* tData) {
+	int32_t value;
+	memcpy(&value, tData, 4);
+	return _mm_cvtsi32_si128(value);
+}
+
+static inline void storePixel(uint8_t* tData, __m128i tValue) {
+	const int32_t value = _mm_cvtsi128_si32(tValue);
+	memcpy(tData, &value, 4);
+}
+
+static void unfilterRow(uint8_t tFilter, uint8_t* tRow, const uint8_t* tPrevious, uint32_t tRowSize) {
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t i = 0;
+	switch (tFilter) {
+	case 1: {
+		// Prefix sum over the four pixels of a block, carrying the last pixel into the next one.
+		__m128i carry = zero;
+		for (; i + 16 <= tRowSize; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(tRow + i));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, carry);
+			_mm_storeu_si128((__m128i*)(tRow + i), x);
+			carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+		for (; i < tRowSize; i += 4) {
+			carry = _mm_add_epi8(loadPixel(tRow + i), carry);
+			storePixel(tRow + i, carry);
+		}
+		break;
+	}
+	case 2:
+		for (; i + 16 <= tRowSize; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(tRow + i));
+			x = _mm_add_epi8(x, _mm_loadu_si128((const __m128i*)(tPrevious + i)));
+			_mm_storeu_si128((__m128i*)(tRow + i), x);
+		}
+		for (; i < tRowSize; i++) tRow[i] = uint8_t(tRow[i] + tPrevious[i]);
+		break;
+	case 3: {
+		__m128i a = zero;
+		const __m128i one = _mm_set1_epi8(1);
+		for (; i < tRowSize; i += 4) {
+			const __m128i b = loadPixel(tPrevious + i);
+			__m128i average = _mm_avg_epu8(a, b);
+			average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(a, b), one));
+			a = _mm_add_epi8(loadPixel(tRow + i), average);
+			storePixel(tRow + i, a);
+		}
+		break;
+	}
+	case 4: {
+		// Paeth on 16-bit lanes, one pixel at a time since every pixel depends on its left neighbour.
+		__m128i a = zero;
+		__m128i c = zero;
+		for (; i < tRowSize; i += 4) {
+			const __m128i b = _mm_unpacklo_epi8(loadPixel(tPrevious + i), zero);
+			const __m128i signedA = _mm_sub_epi16(b, c);
+			const __m128i signedB = _mm_sub_epi16(a, c);
+			const __m128i signedC = _mm_add_epi16(signedA, signedB);
+			const __m128i pa = _mm_max_epi16(signedA, _mm_sub_epi16(zero, signedA));
+			const __m128i pb = _mm_max_epi16(signedB, _mm_sub_epi16(zero, signedB));
+			const __m128i pc = _mm_max_epi16(signedC, _mm_sub_epi16(zero, signedC));
+			const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+			const __m128i isA = _mm_cmpeq_epi16(smallest, pa);
+			const __m128i isB = _mm_cmpeq_epi16(smallest, pb);
+			__m128i predictor = _mm_or_si128(_mm_and_si128(isB, b), _mm_andnot_si128(isB, c));
+			predictor = _mm_or_si128(_mm_and_si128(isA, a), _mm_andnot_si128(isA, predictor));
+
+			const __m128i x = _mm_add_epi8(loadPixel(tRow + i), _mm_packus_epi16(predictor, predictor));
+			storePixel(tRow + i, x);
+			a = _mm_unpacklo_epi8(x, zero);
+			c = b;
+		}
+		break;
+	}
+	}
+}
+
+static void convertRowToBGRA(const uint8_t* tRow, uint8_t* oPixels, uint32_t tWidth) {
+	const __m128i greenAlpha = _mm_set1_epi32(int(0xFF00FF00));
+	const __m128i blue = _mm_set1_epi32(0x00FF0000);
+	const __m128i red = _mm_set1_epi32(0x000000FF);
+	uint32_t i = 0;
+	for (; i + 4 <= tWidth; i += 4) {
+		const __m128i x = _mm_loadu_si128((const __m128i*)(tRow + i * 4));
+		__m128i y = _mm_and_si128(x, greenAlpha);
+		y = _mm_or_si128(y, _mm_and_si128(_mm_slli_epi32(x, 16), blue));
+		y = _mm_or_si128(y, _mm_and_si128(_mm_srli_epi32(x, 16), red));
+		_mm_storeu_si128((__m128i*)(oPixels + i * 4), y);
+	}
+	convertRowToBGRAScalar(tRow + i * 4, oPixels + i * 4, tWidth - i);
+}
+
+#else
+
+static void unfilterRow(uint8_t tFilter, uint8_t* tRow, const uint8_t* tPrevious, uint32_t tRowSize) {
+	const uint32_t bpp = 4;
+	switch (tFilter) {
+	case 1:
+		for (uint32_t i = bpp; i < tRowSize; i++) tRow[i] = uint8_t(tRow[i] + tRow[i - bpp]);
+		break;
+	case 2:
+		for (uint32_t i = 0; i < tRowSize; i++) tRow[i] = uint8_t(tRow[i] + tPrevious[i]);
+		break;
+	case 3:
+		for (uint32_t i = 0; i < tRowSize; i++) {
+			const int a = i >= bpp ? tRow[i - bpp] : 0;
+			tRow[i] = uint8_t(tRow[i] + ((a + tPrevious[i]) >> 1));
+		}
+		break;
+	case 4:
+		for (uint32_t i = 0; i < tRowSize; i++) {
+			const int a = i >= bpp ? tRow[i - bpp] : 0;
+			const int c = i >= bpp ? tPrevious[i - bpp] : 0;
+			tRow[i] = uint8_t(tRow[i] + getPaethPredictor(a, tPrevious[i], c));
+		}
+		break;
+	}
+}
+
+static void convertRowToBGRA(const uint8_t* tRow, uint8_t* oPixels, uint32_t tWidth) {
+	convertRowToBGRAScalar(tRow, oPixels, tWidth);
+}
+
+#endif
+
+static int decodePNG(const SpriteNode& tNode) {
+	vector<uint8_t> imageData;
+	if (!readPNGImageData(tNode, imageData)) return decodePNGWithLibPNG(tNode);
+
+	const uint32_t width = tNode.mSprite->mWidth;
+	const uint32_t height = tNode.mSprite->mHeight;
+	const uint32_t rowSize = width * 4;
+	vector<uint8_t> filtered(size_t(rowSize + 1) * height);
+	uLongf filteredSize = uLongf(filtered.size());
+	if (uncompress(filtered.data(), &filteredSize, imageData.data(), uLong(imageData.size())) != Z_OK || filteredSize != filtered.size()) return decodePNGWithLibPNG(tNode);
+
+	const vector<uint8_t> emptyRow(rowSize, 0);
+	const uint8_t* previous = emptyRow.data();
+	auto& pixels = tNode.mSprite->mPixels;
+	pixels.resize(size_t(rowSize) * height);
+	for (uint32_t y = 0; y < height; y++) {
+		uint8_t* row = filtered.data() + size_t(y) * (rowSize + 1);
+		if (row[0] > 4) return 0;
+		unfilterRow(row[0], row + 1, previous, rowSize);
+		convertRowToBGRA(row + 1, pixels.data() + size_t(y) * rowSize, width);
+		previous = row + 1;
+	}
+	return 1;
+}
+
+int getSpriteDecoderThreadAmount()
+{
+#if defined(DREAMCAST) || defined(__EMSCRIPTEN__)
+	return 1;
+#else
+	return std::max(1, std::min(int(thread::hardware_concurrency()), 8));
+#endif
+}
+
+int decodeSpriteFilePixels(const uint8_t* tData, uint32_t tSize, std::vector<DecodedSprite>& oSprites, int tThreadAmount)
+{
+	vector<SpriteNode> nodes;
+	if (!readSpriteNodes(tData, tSize, oSprites, nodes)) return 0;
+
+	// Small files are not worth starting threads for.
+	uint64_t pixelAmount = 0;
+	for (auto& sprite : oSprites) pixelAmount += uint64_t(sprite.mWidth) * sprite.mHeight;
+	const int threadAmount = pixelAmount < 64 * 1024 ? 1 : std::min(tThreadAmount, int(nodes.size()));
+
+	atomic<uint32_t> nextNode(0);
+	atomic<int> isValid(1);
+	auto decodeNodes = [&]() {
+		for (uint32_t i = nextNode++; i < nodes.size(); i = nextNode++) {
+			if (!decodePNG(nodes[i])) isValid = 0;
+		}
+	};
+
+	vector<thread> threads;
+	for (int i = 1; i < threadAmount; i++) threads.push_back(thread(decodeNodes));
+	decodeNodes();
+	for (auto& decodeThread : threads) decodeThread.join();
+	return isValid;
+}
+
+int decodeSpriteFileSprite(const uint8_t* tData, const SpriteFileNode& tNode, DecodedSprite& oSprite)
+{
+	SpriteNode node;
+	node.mSprite = &oSprite;
+	node.mData = tData + tNode.mDataOffset;
+	node.mSize = tNode.mDataSize;
+	return decodePNG(node);
+}
+
+int decodeSpriteFilePixelsWithLibPNG(const uint8_t* tData, uint32_t tSize, std::vector<DecodedSprite>& oSprites)
+{
+	vector<SpriteNode> nodes;
+	if (!readSpriteNodes(tData, tSize, oSprites, nodes)) return 0;
+
+	for (auto& node : nodes) {
+		if (!decodePNGWithLibPNG(node)) return 0;
+	}
+	return 1;
+}
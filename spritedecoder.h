@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+struct DecodedSprite {
+	int mGroup;
+	int mItem;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	int mAxisX;
+	int mAxisY;
+	std::vector<uint8_t> mPixels;
+};
+
+struct SpriteFileNode {
+	uint32_t mDataOffset;
+	uint32_t mDataSize;
+};
+
+int readSpriteFileIndex(const uint8_t* tData, uint32_t tSize, std::vector<DecodedSprite>& oSprites, std::vector<SpriteFileNode>& oNodes);
+int decodeSpriteFileSprite(const uint8_t* tData, const SpriteFileNode& tNode, DecodedSprite& oSprite);
+int decodeSpriteFilePixels(const uint8_t* tData, uint32_t tSize, std::vector<DecodedSprite>& oSprites, int tThreadAmount);
+int decodeSpriteFilePixelsWithLibPNG(const uint8_t* tData, uint32_t tSize, std::vector<DecodedSprite>& oSprites);
+int getSpriteDecoderThreadAmount();
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "spritedecoder.h"
+
+void rotateDecodedSprite(const DecodedSprite& tSprite, double tAngle, DecodedSprite& oRotated);
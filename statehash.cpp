@@ -0,0 +1,167 @@
+#include "statehash.h"
+
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <prism/log.h>
+
+#include "asyncfilewriter.h"
+#include "boss.h"
+#include "enemyhandler.h"
+#include "itemhandler.h"
+#include "player.h"
+#include "profiler.h"
+#include "shothandler.h"
+
+using namespace std;
+
+// Hashes the gameplay state of every frame per subsystem, to prove that two runs of the same replay are identical.
+// The handler is the last gameplay actor of the game screen, so it sees the state after the whole frame has been updated.
+// With --record-hashes FILE the hashes are written to FILE, and a replay recorded with --record FILE also writes FILE.hash.
+// With --verify-hashes FILE every frame is compared against a recorded file, and the first frame and subsystem
+// that differ are logged and kept for the run report.
+// Shots, enemies and items are hashed in container order by their simulation state only. Their map keys come from the
+// process-wide stl_int_map_get_id() counter, which also counts menu and title entities, so they differ between processes.
+
+#define STATE_HASH_FLUSH_FRAMES 60
+
+static struct {
+	string mRecordPath;
+	AsyncFileWriter* mWriter = NULL;
+
+	int mIsVerifying = 0;
+	vector<StateHashFrame> mExpectedFrames;
+	int mDesyncFrame;
+	int mDesyncSubsystem;
+
+	int mFrame;
+} gStateHash;
+
+static int loadExpectedStateHashes(const string& tPath) {
+	ifstream file(tPath, ios::binary);
+	vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	StateHashHeader header;
+	if (data.size() < sizeof(header)) {
+		logWarningFormat("Unable to read state hashes %s.", tPath.data());
+		return 0;
+	}
+
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.mMagic, STATE_HASH_MAGIC, 4) || header.mVersion != STATE_HASH_VERSION || header.mSubsystemAmount != STATE_HASH_SUBSYSTEM_AMOUNT) {
+		logWarningFormat("Invalid state hashes %s.", tPath.data());
+		return 0;
+	}
+
+	gStateHash.mExpectedFrames.resize((data.size() - sizeof(header)) / sizeof(StateHashFrame));
+	if (!gStateHash.mExpectedFrames.empty()) memcpy(gStateHash.mExpectedFrames.data(), data.data() + sizeof(header), gStateHash.mExpectedFrames.size() * sizeof(StateHashFrame));
+	return 1;
+}
+
+int parseStateHashArguments(int argc, char** argv)
+{
+	string replayPath;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (!strcmp(argv[i], "--record")) replayPath = argv[++i];
+		else if (!strcmp(argv[i], "--record-hashes")) gStateHash.mRecordPath = argv[++i];
+		else if (!strcmp(argv[i], "--verify-hashes")) gStateHash.mIsVerifying = loadExpectedStateHashes(argv[++i]);
+	}
+	if (gStateHash.mRecordPath.empty() && !replayPath.empty()) gStateHash.mRecordPath = replayPath + ".hash";
+	return gStateHash.mIsVerifying;
+}
+
+int isVerifyingStateHashes()
+{
+	return gStateHash.mIsVerifying;
+}
+
+int getStateHashDesyncFrame()
+{
+	return gStateHash.mDesyncFrame;
+}
+
+const char* getStateHashDesyncSubsystem()
+{
+	return gStateHash.mDesyncSubsystem >= 0 ? gStateHashSubsystemNames[gStateHash.mDesyncSubsystem] : "";
+}
+
+void addStateHashPosition(StateHash& oHash, const Position& tPosition)
+{
+	addStateHashDouble(oHash, tPosition.x);
+	addStateHashDouble(oHash, tPosition.y);
+	addStateHashDouble(oHash, tPosition.z);
+}
+
+static StateHashFrame getCurrentStateHashFrame() {
+	StateHash hashes[STATE_HASH_SUBSYSTEM_AMOUNT];
+	addPlayerStateHash(hashes[STATE_HASH_PLAYER]);
+	addShotStateHash(hashes[STATE_HASH_SHOTS]);
+	addEnemyStateHash(hashes[STATE_HASH_ENEMIES]);
+	addBossStateHash(hashes[STATE_HASH_BOSS]);
+	addItemStateHash(hashes[STATE_HASH_ITEMS]);
+
+	StateHashFrame frame;
+	for (int i = 0; i < STATE_HASH_SUBSYSTEM_AMOUNT; i++) frame.mHashes[i] = hashes[i].mValue;
+	return frame;
+}
+
+static void verifyStateHashFrame(const StateHashFrame& tFrame) {
+	if (gStateHash.mDesyncFrame >= 0 || gStateHash.mFrame >= int(gStateHash.mExpectedFrames.size())) return;
+
+	const auto& expected = gStateHash.mExpectedFrames[gStateHash.mFrame];
+	for (int i = 0; i < STATE_HASH_SUBSYSTEM_AMOUNT; i++) {
+		if (tFrame.mHashes[i] == expected.mHashes[i]) continue;
+		gStateHash.mDesyncFrame = gStateHash.mFrame;
+		gStateHash.mDesyncSubsystem = i;
+		logWarningFormat("State diverges at frame %d in %s.", gStateHash.mFrame, gStateHashSubsystemNames[i]);
+		return;
+	}
+}
+
+static void loadStateHashHandler(void* tData) {
+	(void)tData;
+	gStateHash.mFrame = 0;
+	gStateHash.mDesyncFrame = -1;
+	gStateHash.mDesyncSubsystem = -1;
+	if (gStateHash.mRecordPath.empty()) return;
+
+	gStateHash.mWriter = openAsyncFileWriter(gStateHash.mRecordPath);
+	if (!gStateHash.mWriter) {
+		logWarningFormat("Unable to record state hashes %s.", gStateHash.mRecordPath.data());
+		return;
+	}
+	StateHashHeader header;
+	memcpy(header.mMagic, STATE_HASH_MAGIC, 4);
+	header.mVersion = STATE_HASH_VERSION;
+	header.mSubsystemAmount = STATE_HASH_SUBSYSTEM_AMOUNT;
+	appendAsyncFileWriter(gStateHash.mWriter, &header, sizeof(header));
+}
+
+static void unloadStateHashHandler(void* tData) {
+	(void)tData;
+	if (!gStateHash.mWriter) return;
+	closeAsyncFileWriter(gStateHash.mWriter);
+	gStateHash.mWriter = NULL;
+}
+
+static void updateStateHashHandler(void* tData) {
+	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_STATE_HASH);
+	if (!gStateHash.mWriter && !gStateHash.mIsVerifying) return;
+
+	const auto frame = getCurrentStateHashFrame();
+	if (gStateHash.mIsVerifying) verifyStateHashFrame(frame);
+	if (gStateHash.mWriter) {
+		appendAsyncFileWriter(gStateHash.mWriter, &frame, sizeof(frame));
+		if ((gStateHash.mFrame + 1) % STATE_HASH_FLUSH_FRAMES == 0) flushAsyncFileWriter(gStateHash.mWriter);
+	}
+	gStateHash.mFrame++;
+}
+
+ActorBlueprint getStateHashHandler()
+{
+	return makeActorBlueprint(loadStateHashHandler, unloadStateHashHandler, updateStateHashHandler);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <prism/actorhandler.h>
+#include <prism/geometry.h>
+
+#include "statehashformat.h"
+
+ActorBlueprint getStateHashHandler();
+
+int parseStateHashArguments(int argc, char** argv);
+int isVerifyingStateHashes();
+int getStateHashDesyncFrame();
+const char* getStateHashDesyncSubsystem();
+
+void addStateHashPosition(StateHash& oHash, const Position& tPosition);
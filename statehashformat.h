@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Layout of the state hash files written by statehash.cpp, one record of subsystem hashes per gameplay frame.
+// All integers are little endian, which matches every platform the game ships on.
+//
+// StateHashHeader
+// StateHashFrame[], until the end of the file
+
+#define STATE_HASH_MAGIC "YRSH"
+#define STATE_HASH_VERSION 1
+
+enum StateHashSubsystem {
+	STATE_HASH_PLAYER,
+	STATE_HASH_SHOTS,
+	STATE_HASH_ENEMIES,
+	STATE_HASH_BOSS,
+	STATE_HASH_ITEMS,
+	STATE_HASH_SUBSYSTEM_AMOUNT,
+};
+
+static const char* const gStateHashSubsystemNames[STATE_HASH_SUBSYSTEM_AMOUNT] = { "player", "shots", "enemies", "boss", "items" };
+
+struct StateHashHeader {
+	char mMagic[4];
+	uint32_t mVersion;
+	uint32_t mSubsystemAmount;
+};
+
+struct StateHashFrame {
+	uint64_t mHashes[STATE_HASH_SUBSYSTEM_AMOUNT];
+};
+
+// 64-bit FNV-1a over the raw bytes, so doubles are compared bit for bit.
+struct StateHash {
+	uint64_t mValue = 0xCBF29CE484222325ull;
+};
+
+static inline void addStateHashData(StateHash& oHash, const void* tData, size_t tSize) {
+	const uint8_t* data = (const uint8_t*)tData;
+	for (size_t i = 0; i < tSize; i++) {
+		oHash.mValue = (oHash.mValue ^ data[i]) * 0x100000001B3ull;
+	}
+}
+
+static inline void addStateHashInt(StateHash& oHash, int64_t tValue) {
+	addStateHashData(oHash, &tValue, sizeof(tValue));
+}
+
+static inline void addStateHashDouble(StateHash& oHash, double tValue) {
+	addStateHashData(oHash, &tValue, sizeof(tValue));
+}
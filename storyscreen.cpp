@@ -6,18 +6,22 @@
 #include <prism/stlutil.h>
 
 #include "menuscreen.h"
+#include "assetprefetch.h"
+#include "lazyspritefile.h"
 
 using namespace std;
 
 static struct {
 	MugenDefScript mScript;
 	MugenDefScriptGroup* mCurrentGroup;
-	MugenSpriteFile mSprites;
+	LazySpriteFile* mSprites;
 
 	MugenAnimation* mOldAnimation;
 	MugenAnimation* mAnimation;
 	int mAnimationID;
 	int mOldAnimationID;
+	Vector3DI mSprite;
+	Vector3DI mOldSprite;
 
 	Position mOldAnimationBasePosition;
 	Position mAnimationBasePosition;
@@ -49,6 +53,7 @@ static void loadImageGroup() {
 	if (gStoryScreenData.mOldAnimationID != -1) {
 		removeMugenAnimation(gStoryScreenData.mOldAnimationID);
 		destroyMugenAnimation(gStoryScreenData.mOldAnimation);
+		releaseLazySprite(gStoryScreenData.mSprites, gStoryScreenData.mOldSprite.x, gStoryScreenData.mOldSprite.y);
 	}
 
 	if (gStoryScreenData.mAnimationID != -1) {
@@ -57,6 +62,7 @@ static void loadImageGroup() {
 
 	gStoryScreenData.mOldAnimationID = gStoryScreenData.mAnimationID;
 	gStoryScreenData.mOldAnimation = gStoryScreenData.mAnimation;
+	gStoryScreenData.mOldSprite = gStoryScreenData.mSprite;
 
 
 	int group = getMugenDefNumberVariableAsGroup(gStoryScreenData.mCurrentGroup, "group");
@@ -64,8 +70,10 @@ static void loadImageGroup() {
 	gStoryScreenData.mTextPosition = getMugenDefVectorOrDefaultAsGroup(gStoryScreenData.mCurrentGroup, "text.pos", makePosition(0, 0, 1));
 	gStoryScreenData.mTextPosition.z = 2;
 	gStoryScreenData.mTextWidth = getMugenDefIntegerOrDefaultAsGroup(gStoryScreenData.mCurrentGroup, "text.width", INF);
+	gStoryScreenData.mSprite = makeVector3DI(group, item, 0);
+	acquireLazySprite(gStoryScreenData.mSprites, group, item);
 	gStoryScreenData.mAnimation = createOneFrameMugenAnimationForSprite(group, item);
-	gStoryScreenData.mAnimationID = addMugenAnimation(gStoryScreenData.mAnimation, &gStoryScreenData.mSprites, makePosition(0, 0, 0));
+	gStoryScreenData.mAnimationID = addMugenAnimation(gStoryScreenData.mAnimation, getLazySpriteFileSprites(gStoryScreenData.mSprites), makePosition(0, 0, 0));
 	setMugenAnimationBasePosition(gStoryScreenData.mAnimationID, &gStoryScreenData.mAnimationBasePosition);
 
 	increaseGroup();
@@ -111,6 +119,7 @@ static int isTitleGroup() {
 
 static void goToTitle(void* tCaller) {
 	(void)tCaller;
+	discardPrefetchedAssetFiles();
 	setNewScreen(getMenuScreen());
 }
 
@@ -170,15 +179,20 @@ static void loadStoryScreen() {
 
 	stringstream scriptPath;
 	scriptPath << "endings/" << gStoryScreenData.mDefinitionPath << ".def";
-	loadMugenDefScript(&gStoryScreenData.mScript, scriptPath.str().data());
+	loadPrefetchedMugenDefScript(&gStoryScreenData.mScript, scriptPath.str());
 
 	scriptPath = stringstream();
 	scriptPath << "endings/" << gStoryScreenData.mDefinitionPath << ".sff";
-	gStoryScreenData.mSprites = loadMugenSpriteFileWithoutPalette(scriptPath.str());
+	gStoryScreenData.mSprites = loadLazySpriteFile(scriptPath.str(), "");
 
 	findStartOfStoryBoard();
 }
 
+static void unloadStoryScreen() {
+	unloadLazySpriteFile(gStoryScreenData.mSprites);
+	gStoryScreenData.mSprites = nullptr;
+}
+
 
 static void updateText() {
 	if (gStoryScreenData.mIsStoryOver) return;
@@ -203,7 +217,7 @@ static void updateStoryScreen() {
 Screen gStoryScreen;
 
 Screen* getStoryScreen() {
-	gStoryScreen = makeScreen(loadStoryScreen, updateStoryScreen);
+	gStoryScreen = makeScreen(loadStoryScreen, updateStoryScreen, NULL, unloadStoryScreen);
 	return &gStoryScreen;
 }
 
@@ -0,0 +1,155 @@
+// Host tool that packs the asset directory into the single-file archive described in assetpackformat.h.
+// Usage: assetpack [-c] <asset directory> <output file>
+// With -c every entry is LZ compressed when that saves at least an eighth of its size.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../assetpackformat.h"
+
+using namespace std;
+
+struct PackFile {
+	string mPath;
+	string mFullPath;
+	vector<uint8_t> mData;
+	vector<uint8_t> mStored;
+	uint32_t mCompression;
+};
+
+static string toLower(string tString) {
+	for (auto& c : tString) c = char(tolower((unsigned char)c));
+	return tString;
+}
+
+static void collectFiles(const string& tRoot, const string& tRelative, const string& tExclude, vector<PackFile>& oFiles) {
+	string directoryPath = tRelative.empty() ? tRoot : tRoot + "/" + tRelative;
+	DIR* directory = opendir(directoryPath.data());
+	if (!directory) {
+		fprintf(stderr, "Unable to open directory %s\n", directoryPath.data());
+		exit(1);
+	}
+
+	while (dirent* entry = readdir(directory)) {
+		string name = entry->d_name;
+		if (name == "." || name == "..") continue;
+
+		string relative = tRelative.empty() ? name : tRelative + "/" + name;
+		string fullPath = tRoot + "/" + relative;
+		struct stat info;
+		if (stat(fullPath.data(), &info)) continue;
+
+		if (S_ISDIR(info.st_mode)) {
+			collectFiles(tRoot, relative, tExclude, oFiles);
+		}
+		else if (S_ISREG(info.st_mode) && fullPath != tExclude) {
+			PackFile file;
+			file.mPath = toLower(relative);
+			file.mFullPath = fullPath;
+			oFiles.push_back(file);
+		}
+	}
+	closedir(directory);
+}
+
+static vector<uint8_t> readFile(const string& tPath) {
+	ifstream file(tPath, ios::binary);
+	return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+static uint32_t alignUp(uint32_t tValue) {
+	return (tValue + ASSET_PACK_ALIGNMENT - 1) & ~uint32_t(ASSET_PACK_ALIGNMENT - 1);
+}
+
+int main(int argc, char** argv) {
+	int argument = 1;
+	int isCompressing = 0;
+	if (argc > 1 && !strcmp(argv[1], "-c")) {
+		isCompressing = 1;
+		argument++;
+	}
+	if (argc - argument != 2) {
+		fprintf(stderr, "Usage: %s [-c] <asset directory> <output file>\n", argv[0]);
+		return 1;
+	}
+	string root = argv[argument];
+	string outputPath = argv[argument + 1];
+
+	vector<PackFile> files;
+	collectFiles(root, "", outputPath, files);
+	sort(files.begin(), files.end(), [](const PackFile& a, const PackFile& b) { return a.mPath < b.mPath; });
+
+	uint32_t pathTableSize = 0;
+	for (auto& file : files) {
+		file.mData = readFile(file.mFullPath);
+		file.mCompression = ASSET_PACK_COMPRESSION_NONE;
+		file.mStored = file.mData;
+		if (isCompressing && !file.mData.empty()) {
+			auto compressed = compressAssetPackLZ(file.mData);
+			vector<uint8_t> check(file.mData.size());
+			if (!decompressAssetPackLZ(compressed.data(), uint32_t(compressed.size()), check.data(), uint32_t(check.size())) || check != file.mData) {
+				fprintf(stderr, "LZ round trip failed for %s\n", file.mPath.data());
+				return 1;
+			}
+			if (compressed.size() <= file.mData.size() - file.mData.size() / 8) {
+				file.mStored = compressed;
+				file.mCompression = ASSET_PACK_COMPRESSION_LZ;
+			}
+		}
+		pathTableSize += uint32_t(file.mPath.size());
+	}
+
+	AssetPackHeader header;
+	memcpy(header.mMagic, ASSET_PACK_MAGIC, 4);
+	header.mVersion = ASSET_PACK_VERSION;
+	header.mEntryAmount = uint32_t(files.size());
+	header.mPathTableSize = pathTableSize;
+
+	vector<AssetPackEntry> entries;
+	uint32_t pathOffset = 0;
+	uint32_t dataOffset = alignUp(uint32_t(sizeof(AssetPackHeader) + files.size() * sizeof(AssetPackEntry) + pathTableSize));
+	for (auto& file : files) {
+		AssetPackEntry entry;
+		entry.mPathOffset = pathOffset;
+		entry.mPathLength = uint32_t(file.mPath.size());
+		entry.mDataOffset = dataOffset;
+		entry.mStoredSize = uint32_t(file.mStored.size());
+		entry.mSize = uint32_t(file.mData.size());
+		entry.mCompression = file.mCompression;
+		entries.push_back(entry);
+
+		pathOffset += entry.mPathLength;
+		dataOffset = alignUp(dataOffset + entry.mStoredSize + (entry.mCompression == ASSET_PACK_COMPRESSION_NONE));
+	}
+
+	ofstream out(outputPath, ios::binary);
+	if (!out) {
+		fprintf(stderr, "Unable to write %s\n", outputPath.data());
+		return 1;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)entries.data(), entries.size() * sizeof(AssetPackEntry));
+	for (auto& file : files) out.write(file.mPath.data(), file.mPath.size());
+	for (size_t i = 0; i < files.size(); i++) {
+		out.seekp(entries[i].mDataOffset);
+		out.write((const char*)files[i].mStored.data(), files[i].mStored.size());
+		if (entries[i].mCompression == ASSET_PACK_COMPRESSION_NONE) out.put('\0');
+	}
+
+	uint32_t totalSize = 0, storedSize = 0;
+	for (auto& entry : entries) {
+		totalSize += entry.mSize;
+		storedSize += entry.mStoredSize;
+	}
+	printf("Packed %d files, %u bytes stored as %u bytes\n", int(files.size()), totalSize, storedSize);
+	return 0;
+}
@@ -0,0 +1,226 @@
+// Host tool that packs sprite sheets into power-of-two texture atlas pages, see spriteatlasformat.h.
+// Usage: atlasgen <asset directory> <output file> <sheet paths relative to the asset directory...>
+// Identical sprites share one region, and each page is shrunk to the smallest power of two its sprites fit in.
+// Sprites larger than ATLAS_MAX_SPRITE_SIZE, like the HUD frame and the portraits, are drawn once per frame at most
+// and gain nothing from sharing a texture, so they are left out and keep being drawn from their sheet.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../assetpackformat.h"
+#include "../spriteatlasformat.h"
+#include "../spritedecoder.h"
+
+using namespace std;
+
+#define ATLAS_MAX_SPRITE_SIZE 128
+
+struct AtlasSprite {
+	int mSheet;
+	DecodedSprite mSprite;
+	int mImage;
+};
+
+struct AtlasImage {
+	uint32_t mWidth;
+	uint32_t mHeight;
+	const vector<uint8_t>* mPixels;
+	uint32_t mPage;
+	uint32_t mX;
+	uint32_t mY;
+};
+
+struct AtlasPage {
+	uint32_t mWidth;
+	uint32_t mHeight;
+	vector<uint8_t> mStored;
+};
+
+static string toLower(string tString) {
+	for (auto& c : tString) c = char(tolower((unsigned char)c));
+	return tString;
+}
+
+static vector<uint8_t> readFile(const string& tPath) {
+	ifstream file(tPath, ios::binary);
+	return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+static void packImages(vector<AtlasImage>& tImages, vector<AtlasPage>& oPages) {
+	vector<int> remaining;
+	for (size_t i = 0; i < tImages.size(); i++) remaining.push_back(int(i));
+	sort(remaining.begin(), remaining.end(), [&](int a, int b) {
+		if (tImages[a].mHeight != tImages[b].mHeight) return tImages[a].mHeight > tImages[b].mHeight;
+		return tImages[a].mWidth > tImages[b].mWidth;
+	});
+
+	while (!remaining.empty()) {
+		vector<pair<uint32_t, uint32_t>> sizes;
+		for (auto index : remaining) sizes.push_back(make_pair(tImages[index].mWidth, tImages[index].mHeight));
+		uint32_t width, height;
+		vector<pair<uint32_t, uint32_t>> positions;
+		packSpriteAtlasPage(sizes, &width, &height, positions);
+		if (positions.empty()) {
+			fprintf(stderr, "Sprite of %ux%u does not fit into an atlas page\n", tImages[remaining.front()].mWidth, tImages[remaining.front()].mHeight);
+			exit(1);
+		}
+
+		AtlasPage page;
+		page.mWidth = width;
+		page.mHeight = height;
+		vector<uint8_t> pixels(size_t(width) * height * 4, 0);
+		for (size_t i = 0; i < positions.size(); i++) {
+			auto& image = tImages[remaining[i]];
+			image.mPage = uint32_t(oPages.size());
+			image.mX = positions[i].first;
+			image.mY = positions[i].second;
+			for (uint32_t y = 0; y < image.mHeight; y++) {
+				memcpy(&pixels[(size_t(image.mY + y) * width + image.mX) * 4], &(*image.mPixels)[size_t(y) * image.mWidth * 4], image.mWidth * 4);
+			}
+		}
+
+		page.mStored = compressAssetPackLZ(pixels);
+		vector<uint8_t> check(pixels.size());
+		if (!decompressAssetPackLZ(page.mStored.data(), uint32_t(page.mStored.size()), check.data(), uint32_t(check.size())) || check != pixels) {
+			fprintf(stderr, "LZ round trip failed for atlas page %d\n", int(oPages.size()));
+			exit(1);
+		}
+		oPages.push_back(move(page));
+		remaining.erase(remaining.begin(), remaining.begin() + positions.size());
+	}
+}
+
+template<typename T>
+static void writeArray(ofstream& tOut, const vector<T>& tArray) {
+	tOut.write((const char*)tArray.data(), tArray.size() * sizeof(T));
+}
+
+int main(int argc, char** argv) {
+	if (argc < 4) {
+		fprintf(stderr, "Usage: %s <asset directory> <output file> <sheet paths...>\n", argv[0]);
+		return 1;
+	}
+	string root = argv[1];
+	string outputPath = argv[2];
+
+	vector<string> sheetFilePaths(argv + 3, argv + argc);
+	sort(sheetFilePaths.begin(), sheetFilePaths.end(), [](const string& a, const string& b) { return toLower(a) < toLower(b); });
+	vector<string> sheetPaths;
+	for (auto& path : sheetFilePaths) sheetPaths.push_back(toLower(path));
+
+	vector<AtlasSprite> sprites;
+	int skippedAmount = 0;
+	for (size_t i = 0; i < sheetPaths.size(); i++) {
+		auto data = readFile(root + "/" + sheetFilePaths[i]);
+		vector<DecodedSprite> decoded;
+		if (!decodeSpriteFilePixels(data.data(), uint32_t(data.size()), decoded, getSpriteDecoderThreadAmount())) {
+			fprintf(stderr, "Unable to decode %s\n", sheetPaths[i].data());
+			return 1;
+		}
+		sort(decoded.begin(), decoded.end(), [](const DecodedSprite& a, const DecodedSprite& b) { return make_pair(a.mGroup, a.mItem) < make_pair(b.mGroup, b.mItem); });
+		for (auto& sprite : decoded) {
+			if (sprite.mWidth > ATLAS_MAX_SPRITE_SIZE || sprite.mHeight > ATLAS_MAX_SPRITE_SIZE) {
+				skippedAmount++;
+				continue;
+			}
+			AtlasSprite atlasSprite;
+			atlasSprite.mSheet = int(i);
+			atlasSprite.mImage = -1;
+			atlasSprite.mSprite = move(sprite);
+			sprites.push_back(move(atlasSprite));
+		}
+	}
+
+	vector<AtlasImage> images;
+	map<pair<pair<uint32_t, uint32_t>, vector<uint8_t>>, int> imageIndices;
+	for (auto& sprite : sprites) {
+		auto key = make_pair(make_pair(sprite.mSprite.mWidth, sprite.mSprite.mHeight), sprite.mSprite.mPixels);
+		auto it = imageIndices.find(key);
+		if (it == imageIndices.end()) {
+			AtlasImage image;
+			image.mWidth = sprite.mSprite.mWidth;
+			image.mHeight = sprite.mSprite.mHeight;
+			image.mPixels = &sprite.mSprite.mPixels;
+			it = imageIndices.insert(make_pair(key, int(images.size()))).first;
+			images.push_back(image);
+		}
+		sprite.mImage = it->second;
+	}
+
+	vector<AtlasPage> pages;
+	packImages(images, pages);
+
+	SpriteAtlasHeader header;
+	memcpy(header.mMagic, SPRITE_ATLAS_MAGIC, 4);
+	header.mVersion = SPRITE_ATLAS_VERSION;
+	header.mPageAmount = uint32_t(pages.size());
+	header.mSheetAmount = uint32_t(sheetPaths.size());
+	header.mRegionAmount = uint32_t(sprites.size());
+	header.mPathTableSize = 0;
+	for (auto& path : sheetPaths) header.mPathTableSize += uint32_t(path.size());
+
+	vector<SpriteAtlasSheetEntry> sheetEntries(sheetPaths.size());
+	uint32_t pathOffset = 0;
+	for (size_t i = 0; i < sheetPaths.size(); i++) {
+		auto& entry = sheetEntries[i];
+		entry.mPathOffset = pathOffset;
+		entry.mPathLength = uint32_t(sheetPaths[i].size());
+		entry.mRegionStart = uint32_t(find_if(sprites.begin(), sprites.end(), [&](const AtlasSprite& tSprite) { return tSprite.mSheet == int(i); }) - sprites.begin());
+		entry.mRegionAmount = uint32_t(count_if(sprites.begin(), sprites.end(), [&](const AtlasSprite& tSprite) { return tSprite.mSheet == int(i); }));
+		pathOffset += entry.mPathLength;
+	}
+
+	vector<SpriteAtlasRegionEntry> regionEntries;
+	for (auto& sprite : sprites) {
+		auto& image = images[sprite.mImage];
+		SpriteAtlasRegionEntry entry;
+		entry.mGroup = sprite.mSprite.mGroup;
+		entry.mItem = sprite.mSprite.mItem;
+		entry.mPage = image.mPage;
+		entry.mX = image.mX;
+		entry.mY = image.mY;
+		entry.mWidth = image.mWidth;
+		entry.mHeight = image.mHeight;
+		entry.mAxisX = sprite.mSprite.mAxisX;
+		entry.mAxisY = sprite.mSprite.mAxisY;
+		regionEntries.push_back(entry);
+	}
+
+	vector<SpriteAtlasPageEntry> pageEntries;
+	uint32_t dataOffset = uint32_t(sizeof(SpriteAtlasHeader) + pages.size() * sizeof(SpriteAtlasPageEntry) + sheetEntries.size() * sizeof(SpriteAtlasSheetEntry) + regionEntries.size() * sizeof(SpriteAtlasRegionEntry) + header.mPathTableSize);
+	for (auto& page : pages) {
+		SpriteAtlasPageEntry entry;
+		entry.mWidth = page.mWidth;
+		entry.mHeight = page.mHeight;
+		entry.mDataOffset = dataOffset;
+		entry.mStoredSize = uint32_t(page.mStored.size());
+		pageEntries.push_back(entry);
+		dataOffset += entry.mStoredSize;
+	}
+
+	ofstream out(outputPath, ios::binary);
+	if (!out) {
+		fprintf(stderr, "Unable to write %s\n", outputPath.data());
+		return 1;
+	}
+	out.write((const char*)&header, sizeof(header));
+	writeArray(out, pageEntries);
+	writeArray(out, sheetEntries);
+	writeArray(out, regionEntries);
+	for (auto& path : sheetPaths) out.write(path.data(), path.size());
+	for (auto& page : pages) writeArray(out, page.mStored);
+
+	printf("Packed %d sprites (%d unique, %d too large) from %d sheets into %d pages:", int(sprites.size()), int(images.size()), skippedAmount, int(sheetPaths.size()), int(pages.size()));
+	for (auto& page : pages) printf(" %ux%u", page.mWidth, page.mHeight);
+	printf("\n");
+	return 0;
+}
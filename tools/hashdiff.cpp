@@ -0,0 +1,58 @@
+// Host tool that compares two state hash files written with --record-hashes and reports where they diverge.
+// Usage: hashdiff <first hash file> <second hash file>
+// Exits with 0 when every common frame matches and 1 otherwise.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "../statehashformat.h"
+
+using namespace std;
+
+static int readHashFile(const char* tPath, vector<StateHashFrame>& oFrames) {
+	ifstream file(tPath, ios::binary);
+	vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	StateHashHeader header;
+	if (data.size() < sizeof(header)) {
+		fprintf(stderr, "Unable to read %s\n", tPath);
+		return 0;
+	}
+
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.mMagic, STATE_HASH_MAGIC, 4) || header.mVersion != STATE_HASH_VERSION || header.mSubsystemAmount != STATE_HASH_SUBSYSTEM_AMOUNT) {
+		fprintf(stderr, "%s is not a state hash file of this version\n", tPath);
+		return 0;
+	}
+
+	oFrames.resize((data.size() - sizeof(header)) / sizeof(StateHashFrame));
+	if (!oFrames.empty()) memcpy(oFrames.data(), data.data() + sizeof(header), oFrames.size() * sizeof(StateHashFrame));
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <first hash file> <second hash file>\n", argv[0]);
+		return 1;
+	}
+
+	vector<StateHashFrame> first, second;
+	if (!readHashFile(argv[1], first) || !readHashFile(argv[2], second)) return 1;
+
+	const size_t frameAmount = std::min(first.size(), second.size());
+	for (size_t frame = 0; frame < frameAmount; frame++) {
+		for (int i = 0; i < STATE_HASH_SUBSYSTEM_AMOUNT; i++) {
+			if (first[frame].mHashes[i] == second[frame].mHashes[i]) continue;
+			printf("Diverges at frame %d in %s (%016llx != %016llx)\n", int(frame), gStateHashSubsystemNames[i], (unsigned long long)first[frame].mHashes[i], (unsigned long long)second[frame].mHashes[i]);
+			return 1;
+		}
+	}
+
+	printf("%d frames match", int(frameAmount));
+	if (first.size() != second.size()) printf(", the runs are %d and %d frames long", int(first.size()), int(second.size()));
+	printf("\n");
+	return 0;
+}
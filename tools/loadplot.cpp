@@ -0,0 +1,173 @@
+// Host tool that draws the CSV of the synthetic load generator (loadgenerator.cpp) as one SVG chart per sweep.
+// Usage: loadplot <load csv> <output svg>
+// Every chart has the live objects on the x axis and the mean and p99 frame time on the y axis, with the 60 fps budget
+// as a dashed line. The cost per live object between neighbouring steps is printed as well, a jump in it is the knee.
+// The per system columns ending in _ms are drawn as thin lines below the frame time, so the system that bends is visible.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define CHART_WIDTH 480
+#define CHART_HEIGHT 260
+#define CHART_MARGIN 50
+#define FRAME_BUDGET_MS (1000.0 / 60.0)
+
+struct LoadPoint {
+	double mLiveObjects;
+	double mMean;
+	double mP99;
+	vector<double> mZones;
+	string mLabel;
+};
+
+static const char* gZoneColors[] = { "green", "orange", "purple", "brown", "teal", "olive" };
+
+static vector<string> splitLine(const string& tLine) {
+	vector<string> ret;
+	stringstream ss(tLine);
+	string value;
+	while (getline(ss, value, ',')) ret.push_back(value);
+	return ret;
+}
+
+static int findColumn(const vector<string>& tHeader, const string& tName) {
+	auto it = find(tHeader.begin(), tHeader.end(), tName);
+	return it == tHeader.end() ? -1 : int(it - tHeader.begin());
+}
+
+static double getChartX(double tValue, double tMaximum, int tLeft) {
+	return tLeft + CHART_MARGIN + (CHART_WIDTH - 2 * CHART_MARGIN) * (tMaximum > 0 ? tValue / tMaximum : 0);
+}
+
+static double getChartY(double tValue, double tMaximum, int tTop) {
+	return tTop + CHART_HEIGHT - CHART_MARGIN - (CHART_HEIGHT - 2 * CHART_MARGIN) * (tMaximum > 0 ? tValue / tMaximum : 0);
+}
+
+static void writePolyline(ofstream& tOut, const vector<LoadPoint>& tPoints, double LoadPoint::*tValue, double tMaxX, double tMaxY, int tTop, const char* tStyle) {
+	tOut << "<polyline fill=\"none\" " << tStyle << " points=\"";
+	for (auto& point : tPoints) tOut << getChartX(point.mLiveObjects, tMaxX, 0) << "," << getChartY(point.*tValue, tMaxY, tTop) << " ";
+	tOut << "\"/>\n";
+}
+
+static void writeZonePolylines(ofstream& tOut, const vector<LoadPoint>& tPoints, const vector<string>& tZoneNames, double tMaxX, double tMaxY, int tTop) {
+	for (size_t i = 0; i < tZoneNames.size(); i++) {
+		const char* color = gZoneColors[i % (sizeof(gZoneColors) / sizeof(gZoneColors[0]))];
+		tOut << "<polyline fill=\"none\" stroke=\"" << color << "\" stroke-width=\"0.75\" points=\"";
+		for (auto& point : tPoints) tOut << getChartX(point.mLiveObjects, tMaxX, 0) << "," << getChartY(point.mZones[i], tMaxY, tTop) << " ";
+		tOut << "\"/>\n";
+		tOut << "<text x=\"" << CHART_WIDTH - CHART_MARGIN << "\" y=\"" << tTop + 15 + 10 * i << "\" font-size=\"9\" text-anchor=\"end\" fill=\"" << color << "\">" << tZoneNames[i] << "</text>\n";
+	}
+}
+
+static void writeChart(ofstream& tOut, const string& tSweep, const vector<LoadPoint>& tPoints, const vector<string>& tZoneNames, int tTop) {
+	double maxX = 0, maxY = FRAME_BUDGET_MS;
+	for (auto& point : tPoints) {
+		maxX = max(maxX, point.mLiveObjects);
+		maxY = max(maxY, point.mP99);
+	}
+	maxY *= 1.1;
+
+	const int left = CHART_MARGIN, right = CHART_WIDTH - CHART_MARGIN, bottom = tTop + CHART_HEIGHT - CHART_MARGIN;
+	tOut << "<text x=\"" << left << "\" y=\"" << tTop + 25 << "\" font-size=\"14\">" << tSweep << "</text>\n";
+	tOut << "<line x1=\"" << left << "\" y1=\"" << bottom << "\" x2=\"" << right << "\" y2=\"" << bottom << "\" stroke=\"black\"/>\n";
+	tOut << "<line x1=\"" << left << "\" y1=\"" << tTop + CHART_MARGIN << "\" x2=\"" << left << "\" y2=\"" << bottom << "\" stroke=\"black\"/>\n";
+	tOut << "<text x=\"" << right << "\" y=\"" << bottom + 30 << "\" font-size=\"10\" text-anchor=\"end\">live objects (max " << int(maxX) << ")</text>\n";
+	tOut << "<text x=\"" << left - 5 << "\" y=\"" << tTop + CHART_MARGIN - 5 << "\" font-size=\"10\">" << maxY << " ms</text>\n";
+
+	const double budgetY = getChartY(FRAME_BUDGET_MS, maxY, tTop);
+	tOut << "<line x1=\"" << left << "\" y1=\"" << budgetY << "\" x2=\"" << right << "\" y2=\"" << budgetY << "\" stroke=\"gray\" stroke-dasharray=\"2,4\"/>\n";
+
+	writeZonePolylines(tOut, tPoints, tZoneNames, maxX, maxY, tTop);
+	writePolyline(tOut, tPoints, &LoadPoint::mP99, maxX, maxY, tTop, "stroke=\"red\" stroke-dasharray=\"6,3\"");
+	writePolyline(tOut, tPoints, &LoadPoint::mMean, maxX, maxY, tTop, "stroke=\"blue\"");
+	for (auto& point : tPoints) {
+		const double x = getChartX(point.mLiveObjects, maxX, 0), y = getChartY(point.mMean, maxY, tTop);
+		tOut << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"3\" fill=\"blue\"/>\n";
+		tOut << "<text x=\"" << x << "\" y=\"" << bottom + 15 << "\" font-size=\"9\" text-anchor=\"middle\">" << point.mLabel << "</text>\n";
+	}
+}
+
+static void printSlopes(const string& tSweep, const vector<LoadPoint>& tPoints, const vector<string>& tZoneNames) {
+	printf("%s\n", tSweep.data());
+	for (size_t i = 1; i < tPoints.size(); i++) {
+		const double objects = tPoints[i].mLiveObjects - tPoints[i - 1].mLiveObjects;
+		const double cost = objects > 0 ? 1000 * (tPoints[i].mMean - tPoints[i - 1].mMean) / objects : 0;
+		printf("\t%8.1f -> %8.1f objects: %8.4f ms mean, %8.4f us per object", tPoints[i - 1].mLiveObjects, tPoints[i].mLiveObjects, tPoints[i].mMean, cost);
+		for (size_t j = 0; j < tZoneNames.size(); j++) printf(", %s %.4f", tZoneNames[j].data(), tPoints[i].mZones[j]);
+		printf("\n");
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <load csv> <output svg>\n", argv[0]);
+		return 1;
+	}
+
+	ifstream file(argv[1]);
+	string line;
+	if (!file || !getline(file, line)) {
+		fprintf(stderr, "Unable to read %s\n", argv[1]);
+		return 1;
+	}
+	const auto header = splitLine(line);
+	const int sweepColumn = findColumn(header, "sweep");
+	const int objectColumn = findColumn(header, "live_objects");
+	const int meanColumn = findColumn(header, "frame_ms_mean");
+	const int p99Column = findColumn(header, "frame_ms_p99");
+	if (sweepColumn < 0 || objectColumn < 0 || meanColumn < 0 || p99Column < 0) {
+		fprintf(stderr, "%s is not a load generator CSV\n", argv[1]);
+		return 1;
+	}
+
+	vector<int> zoneColumns;
+	vector<string> zoneNames;
+	for (size_t i = 0; i < header.size(); i++) {
+		const string& name = header[i];
+		if (int(i) == meanColumn || int(i) == p99Column || name.size() < 3 || name.compare(name.size() - 3, 3, "_ms")) continue;
+		zoneColumns.push_back(int(i));
+		zoneNames.push_back(name);
+	}
+
+	vector<string> sweepOrder;
+	map<string, vector<LoadPoint>> sweeps;
+	while (getline(file, line)) {
+		const auto values = splitLine(line);
+		if (int(values.size()) < int(header.size())) continue;
+
+		const string& sweep = values[sweepColumn];
+		if (!sweeps.count(sweep)) sweepOrder.push_back(sweep);
+		LoadPoint point;
+		point.mLiveObjects = atof(values[objectColumn].data());
+		point.mMean = atof(values[meanColumn].data());
+		point.mP99 = atof(values[p99Column].data());
+		for (auto column : zoneColumns) point.mZones.push_back(atof(values[column].data()));
+		point.mLabel = to_string(int(point.mLiveObjects));
+		sweeps[sweep].push_back(point);
+	}
+
+	ofstream out(argv[2]);
+	if (!out) {
+		fprintf(stderr, "Unable to write %s\n", argv[2]);
+		return 1;
+	}
+	out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << CHART_WIDTH << "\" height=\"" << CHART_HEIGHT * sweepOrder.size() << "\" font-family=\"sans-serif\">\n";
+	out << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+	for (size_t i = 0; i < sweepOrder.size(); i++) {
+		auto& points = sweeps[sweepOrder[i]];
+		sort(points.begin(), points.end(), [](const LoadPoint& a, const LoadPoint& b) { return a.mLiveObjects < b.mLiveObjects; });
+		writeChart(out, sweepOrder[i], points, zoneNames, int(i * CHART_HEIGHT));
+		printSlopes(sweepOrder[i], points, zoneNames);
+	}
+	out << "</svg>\n";
+	return 0;
+}
@@ -0,0 +1,195 @@
+// Host tool that turns data/SHOTS.def into the constexpr shot tables in shotdata_generated.h.
+// Usage: shotdefgen <SHOTS.def> <output header>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct DefGroup {
+	string mName;
+	map<string, string> mValues;
+};
+
+struct SubShot {
+	int mTemplate;
+	double mX;
+	double mY;
+};
+
+struct ShotEntry {
+	string mName;
+	int mHasAnimation;
+	int mAnimation;
+	int mDamage;
+	double mCollisionRadius;
+	int mGimmick;
+	vector<SubShot> mSubShots;
+};
+
+static string trim(const string& tString) {
+	size_t start = tString.find_first_not_of(" \t\r\n");
+	if (start == string::npos) return "";
+	size_t end = tString.find_last_not_of(" \t\r\n");
+	return tString.substr(start, end - start + 1);
+}
+
+static string toLower(string tString) {
+	for (auto& c : tString) c = char(tolower((unsigned char)c));
+	return tString;
+}
+
+static string stripQuotes(const string& tString) {
+	if (tString.size() >= 2 && tString.front() == '"' && tString.back() == '"') return tString.substr(1, tString.size() - 2);
+	return tString;
+}
+
+static int isNumber(const string& tString) {
+	if (tString.empty()) return 0;
+	char* end;
+	strtod(tString.data(), &end);
+	return *end == '\0';
+}
+
+static vector<DefGroup> readDefFile(const char* tPath) {
+	ifstream file(tPath);
+	if (!file) {
+		fprintf(stderr, "Unable to open %s\n", tPath);
+		exit(1);
+	}
+
+	vector<DefGroup> groups;
+	string line;
+	while (getline(file, line)) {
+		auto comment = line.find(';');
+		if (comment != string::npos) line = line.substr(0, comment);
+		line = trim(line);
+		if (line.empty()) continue;
+
+		if (line.front() == '[') {
+			DefGroup group;
+			group.mName = trim(line.substr(1, line.find(']') - 1));
+			groups.push_back(group);
+			continue;
+		}
+
+		auto equals = line.find('=');
+		if (equals == string::npos || groups.empty()) continue;
+		string key = toLower(trim(line.substr(0, equals)));
+		string value = trim(line.substr(equals + 1));
+		groups.back().mValues[key] = value;
+	}
+
+	return groups;
+}
+
+static int getGimmickIndex(vector<string>& tGimmicks, const string& tName) {
+	for (size_t i = 0; i < tGimmicks.size(); i++) {
+		if (tGimmicks[i] == tName) return int(i);
+	}
+	tGimmicks.push_back(tName);
+	return int(tGimmicks.size()) - 1;
+}
+
+static void parseOffset(const string& tValue, double* oX, double* oY) {
+	*oX = *oY = 0;
+	sscanf(tValue.data(), "%lf , %lf", oX, oY);
+}
+
+static void writeHeader(const char* tPath, const char* tSourcePath, const vector<ShotEntry>& tShots, const vector<SubShot>& tSubShots, const vector<string>& tGimmicks) {
+	ofstream out(tPath);
+	if (!out) {
+		fprintf(stderr, "Unable to write %s\n", tPath);
+		exit(1);
+	}
+
+	out << "// Generated by tools/shotdefgen from " << tSourcePath << ". Do not edit.\n";
+	out << "#pragma once\n\n";
+	out << "#include \"shottemplates.h\"\n\n";
+
+	out << "static constexpr const char* gShotGimmickNames[] = {\n";
+	for (auto& gimmick : tGimmicks) {
+		out << "\t\"" << gimmick << "\",\n";
+	}
+	out << "};\n\n";
+
+	out << "static constexpr ShotSubShotTemplate gShotSubShotTemplates[] = {\n";
+	for (auto& subShot : tSubShots) {
+		out << "\t{ " << subShot.mTemplate << ", " << subShot.mX << ", " << subShot.mY << " },\n";
+	}
+	if (tSubShots.empty()) out << "\t{ 0, 0, 0 },\n";
+	out << "};\n\n";
+
+	out << "static constexpr ShotTemplate gShotTemplates[] = {\n";
+	int subShotStart = 0;
+	for (auto& shot : tShots) {
+		out << "\t{ \"" << shot.mName << "\", " << shot.mHasAnimation << ", " << shot.mAnimation << ", " << shot.mDamage << ", " << shot.mCollisionRadius << ", " << shot.mGimmick << ", " << subShotStart << ", " << shot.mSubShots.size() << " },\n";
+		subShotStart += int(shot.mSubShots.size());
+	}
+	out << "};\n";
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <SHOTS.def> <output header>\n", argv[0]);
+		return 1;
+	}
+
+	auto groups = readDefFile(argv[1]);
+
+	vector<ShotEntry> shots;
+	map<string, int> shotIndices;
+	vector<SubShot> subShots;
+	vector<string> gimmicks;
+
+	for (auto& group : groups) {
+		char shotPre[100], shotName[100];
+		if (sscanf(group.mName.data(), "%99s %99s", shotPre, shotName) != 2) continue;
+		if (toLower(shotPre) != "shot") continue;
+		string name = toLower(shotName);
+		if (shotIndices.count(name)) {
+			fprintf(stderr, "Warning: duplicate shot %s ignored\n", name.data());
+			continue;
+		}
+
+		auto& values = group.mValues;
+		ShotEntry shot;
+		shot.mName = name;
+		shot.mHasAnimation = values.count("animation") && isNumber(values["animation"]);
+		shot.mAnimation = shot.mHasAnimation ? atoi(values["animation"].data()) : 1;
+		shot.mDamage = values.count("damage") ? atoi(values["damage"].data()) : 1;
+		shot.mCollisionRadius = values.count("radius") ? atof(values["radius"].data()) : 1;
+		shot.mGimmick = values.count("gimmick") ? getGimmickIndex(gimmicks, stripQuotes(values["gimmick"])) : -1;
+
+		for (int i = 0; i < 100; i++) {
+			stringstream baseName;
+			baseName << "subshot" << i;
+			if (!values.count(baseName.str() + ".name")) continue;
+
+			string subShotName = toLower(stripQuotes(values[baseName.str() + ".name"]));
+			if (!shotIndices.count(subShotName)) {
+				fprintf(stderr, "Shot %s references %s before it is defined\n", name.data(), subShotName.data());
+				return 1;
+			}
+
+			SubShot subShot;
+			subShot.mTemplate = shotIndices[subShotName];
+			parseOffset(values.count(baseName.str() + ".offset") ? values[baseName.str() + ".offset"] : "0,0", &subShot.mX, &subShot.mY);
+			shot.mSubShots.push_back(subShot);
+			subShots.push_back(subShot);
+		}
+
+		shotIndices[name] = int(shots.size());
+		shots.push_back(shot);
+	}
+
+	writeHeader(argv[2], "data/SHOTS.def", shots, subShots, gimmicks);
+	return 0;
+}
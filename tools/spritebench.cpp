@@ -0,0 +1,87 @@
+// Host benchmark for the sprite decoder in spritedecoder.cpp.
+// Usage: spritebench [-n iterations] <sff files...>
+// Decodes every file with libpng, then with the fast path on one thread and on all threads,
+// checks that the pixels match and prints the best time of each.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../spritedecoder.h"
+
+using namespace std;
+
+static vector<uint8_t> readFile(const char* tPath) {
+	ifstream file(tPath, ios::binary);
+	return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+template<typename DecodeFunction>
+static double measure(int tIterations, vector<DecodedSprite>& oSprites, DecodeFunction tDecode) {
+	double best = 1e9;
+	for (int i = 0; i < tIterations; i++) {
+		auto start = chrono::steady_clock::now();
+		if (!tDecode(oSprites)) return -1;
+		best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+static int isSamePixels(const vector<DecodedSprite>& tA, const vector<DecodedSprite>& tB) {
+	if (tA.size() != tB.size()) return 0;
+	for (size_t i = 0; i < tA.size(); i++) {
+		if (tA[i].mPixels != tB[i].mPixels) return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	int argument = 1;
+	int iterations = 20;
+	if (argc > 2 && !strcmp(argv[1], "-n")) {
+		iterations = max(1, atoi(argv[2]));
+		argument += 2;
+	}
+	if (argument >= argc) {
+		fprintf(stderr, "Usage: %s [-n iterations] <sff files...>\n", argv[0]);
+		return 1;
+	}
+
+	const int threadAmount = getSpriteDecoderThreadAmount();
+	const string parallelName = "fast x" + to_string(threadAmount);
+	printf("%-40s %10s %10s %10s %8s\n", "file", "libpng", "fast", parallelName.data(), "speedup");
+
+	double totalReference = 0, totalSerial = 0, totalParallel = 0;
+	int hasMismatch = 0;
+	for (int i = argument; i < argc; i++) {
+		auto data = readFile(argv[i]);
+		const uint8_t* source = data.data();
+		const uint32_t size = uint32_t(data.size());
+
+		vector<DecodedSprite> reference, serial, parallel;
+		double referenceTime = measure(iterations, reference, [&](vector<DecodedSprite>& oSprites) { return decodeSpriteFilePixelsWithLibPNG(source, size, oSprites); });
+		double serialTime = measure(iterations, serial, [&](vector<DecodedSprite>& oSprites) { return decodeSpriteFilePixels(source, size, oSprites, 1); });
+		double parallelTime = measure(iterations, parallel, [&](vector<DecodedSprite>& oSprites) { return decodeSpriteFilePixels(source, size, oSprites, threadAmount); });
+		if (referenceTime < 0 || serialTime < 0 || parallelTime < 0) {
+			printf("%-40s unsupported\n", argv[i]);
+			continue;
+		}
+
+		const int isMatching = isSamePixels(reference, serial) && isSamePixels(reference, parallel);
+		hasMismatch |= !isMatching;
+		printf("%-40s %8.3fms %8.3fms %8.3fms %7.2fx%s\n", argv[i], referenceTime, serialTime, parallelTime, referenceTime / parallelTime, isMatching ? "" : "  PIXEL MISMATCH");
+		totalReference += referenceTime;
+		totalSerial += serialTime;
+		totalParallel += parallelTime;
+	}
+
+	printf("%-40s %8.3fms %8.3fms %8.3fms %7.2fx\n", "total", totalReference, totalSerial, totalParallel, totalReference / totalParallel);
+	return hasMismatch;
+}
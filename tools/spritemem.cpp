@@ -0,0 +1,67 @@
+// Host tool that reports how much memory each sprite sheet takes in the forms lazyspritefile.cpp can keep it in.
+// Usage: spritemem <sff files...>
+// Prints the source size, the fully expanded 32-bit size and the compact size from compactsprite.cpp per sheet,
+// and checks that every compact sprite expands back to the decoded pixels.
+
+#include <stdio.h>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "../compactsprite.h"
+#include "../spritedecoder.h"
+
+using namespace std;
+
+static vector<uint8_t> readFile(const char* tPath) {
+	ifstream file(tPath, ios::binary);
+	return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <sff files...>\n", argv[0]);
+		return 1;
+	}
+
+	uint64_t totalSource = 0, totalExpanded = 0, totalCompact = 0;
+	printf("%-48s %10s %10s %10s %8s  %s\n", "sheet", "source", "expanded", "compact", "sprites", "formats");
+	for (int i = 1; i < argc; i++) {
+		auto data = readFile(argv[i]);
+		vector<DecodedSprite> sprites;
+		if (!decodeSpriteFilePixels(data.data(), uint32_t(data.size()), sprites, getSpriteDecoderThreadAmount())) {
+			printf("%-48s unsupported\n", argv[i]);
+			continue;
+		}
+
+		CompactSpriteSheet sheet;
+		compactSpriteSheet(sprites, sheet);
+
+		uint32_t expandedSize = 0;
+		int formatAmounts[4] = { 0, 0, 0, 0 };
+		vector<uint8_t> pixels;
+		for (size_t j = 0; j < sprites.size(); j++) {
+			expandedSize += uint32_t(sprites[j].mPixels.size());
+			formatAmounts[sheet.mSprites[j].mFormat]++;
+			expandCompactSprite(sheet, sheet.mSprites[j], pixels);
+			if (pixels != sprites[j].mPixels) {
+				fprintf(stderr, "Sprite %d %d of %s does not survive compaction\n", sprites[j].mGroup, sprites[j].mItem, argv[i]);
+				return 1;
+			}
+		}
+
+		const uint32_t compactSize = getCompactSpriteSheetSize(sheet);
+		printf("%-48s %10u %10u %10u %8d ", argv[i], uint32_t(data.size()), expandedSize, compactSize, int(sprites.size()));
+		for (int format = 0; format < 4; format++) {
+			if (formatAmounts[format]) printf(" %s:%d", getCompactSpriteFormatName(CompactSpriteFormat(format)), formatAmounts[format]);
+		}
+		printf("\n");
+
+		totalSource += data.size();
+		totalExpanded += expandedSize;
+		totalCompact += compactSize;
+	}
+	printf("%-48s %10llu %10llu %10llu\n", "total", (unsigned long long)totalSource, (unsigned long long)totalExpanded, (unsigned long long)totalCompact);
+	return 0;
+}
@@ -1,19 +1,57 @@
 #include "uihandler.h"
 
+#include <string.h>
+
 #include <prism/blitz.h>
+#include <prism/drawing.h>
+#include <prism/texture.h>
 
+#include "assetpack.h"
+#include "debug.h"
+#include "hudframe.h"
 #include "player.h"
 #include "dialoghandler.h"
+#include "resourcecache.h"
+#include "spritedecoder.h"
+#include "profiler.h"
 
 #define UI_BASE_Z 85
 
+#define UI_ICON_AMOUNT 8
+#define UI_ICON_X 259
+#define UI_ICON_STEP 6
+#define UI_HEART_Y 50
+#define UI_BOMB_Y 69
+
+// Sprites of UI.air animations 1, 2 and 3.
+#define UI_FRAME_SPRITE 1, 0
+#define UI_HEART_SPRITE 2, 1
+#define UI_BOMB_SPRITE 2, 0
+
+// The frame is sliced at load into the opaque rectangles around the playfield, so the transparent centre
+// is not blended over every gameplay pixel. The hearts and bombs are baked into the region that holds them
+// and only that region is uploaded again when the life or bomb count changes.
+// The slices are not power of two sized (320x8, 16x224, 112x224), so each is padded to the next power of two on upload
+// and drawn from the top left of its texture.
+// When the frame cannot be sliced the frame and icons are animations like before.
+
 static struct {
-	MugenSpriteFile mSprites;
-	MugenAnimations mAnimations;
+	MugenSpriteFile* mSprites;
+	MugenAnimations* mAnimations;
 
 	int mBGID;
-	int mHeartAnimations[8];
-	int mBombAnimations[8];
+	int mHeartAnimations[UI_ICON_AMOUNT];
+	int mBombAnimations[UI_ICON_AMOUNT];
+
+	int mIsFrameSliced;
+	vector<HUDFrameRegion> mFrameRegions;
+	vector<TextureData> mFrameTextures;
+	DecodedSprite mHeartSprite;
+	DecodedSprite mBombSprite;
+	int mIconRegion;
+	vector<uint8_t> mIconRegionPixels;
+	int mShownLives;
+	int mShownBombs;
 
 	int mHighScoreTextID;
 	int mScoreTextID;
@@ -30,19 +68,101 @@ static string getPointText()
 	return ss.str();
 }
 
-static void loadUIHandler(void* tData) {
-	(void)tData;
-	gUIHandler.mSprites = loadMugenSpriteFileWithoutPalette("data/UI.sff");
-	gUIHandler.mAnimations = loadMugenAnimationFile("data/UI.air");
+static int decodeUISprite(const uint8_t* tData, const vector<DecodedSprite>& tSprites, const vector<SpriteFileNode>& tNodes, int tGroup, int tItem, DecodedSprite& oSprite) {
+	for (size_t i = 0; i < tSprites.size(); i++) {
+		if (tSprites[i].mGroup == tGroup && tSprites[i].mItem == tItem) {
+			oSprite = tSprites[i];
+			return decodeSpriteFileSprite(tData, tNodes[i], oSprite);
+		}
+	}
+	return 0;
+}
+
+static int getPowerOfTwoSize(int tSize) {
+	int ret = 1;
+	while (ret < tSize) ret *= 2;
+	return ret;
+}
 
-	gUIHandler.mBGID = addMugenAnimation(getMugenAnimation(&gUIHandler.mAnimations, 1), &gUIHandler.mSprites, makePosition(0, 0, UI_BASE_Z));
+static TextureData uploadFrameRegion(const HUDFrameRegion& tRegion) {
+	const int width = getPowerOfTwoSize(tRegion.mWidth);
+	const int height = getPowerOfTwoSize(tRegion.mHeight);
+	vector<uint8_t> padded(size_t(width) * height * 4, 0);
+	for (int y = 0; y < tRegion.mHeight; y++) {
+		memcpy(padded.data() + size_t(y) * width * 4, tRegion.mPixels.data() + size_t(y) * tRegion.mWidth * 4, size_t(tRegion.mWidth) * 4);
+	}
 
-	for (int i = 0; i < 8; i++) {
-		gUIHandler.mHeartAnimations[i] = addMugenAnimation(getMugenAnimation(&gUIHandler.mAnimations, 2), &gUIHandler.mSprites, makePosition(259 + i * 6, 50, UI_BASE_Z + 2));
+	Buffer pixels = makeBuffer(padded.data(), uint32_t(padded.size()));
+	return loadTextureFromARGB32Buffer(pixels, width, height);
+}
+
+static int loadSlicedFrame() {
+	Buffer buffer = getAssetPackFileBuffer("data/UI.sff");
+	const uint8_t* data = (const uint8_t*)buffer.mData;
+	vector<DecodedSprite> sprites;
+	vector<SpriteFileNode> nodes;
+	DecodedSprite frame;
+	const int isDecoded = readSpriteFileIndex(data, buffer.mLength, sprites, nodes)
+		&& decodeUISprite(data, sprites, nodes, UI_FRAME_SPRITE, frame)
+		&& decodeUISprite(data, sprites, nodes, UI_HEART_SPRITE, gUIHandler.mHeartSprite)
+		&& decodeUISprite(data, sprites, nodes, UI_BOMB_SPRITE, gUIHandler.mBombSprite);
+	freeBuffer(buffer);
+	if (!isDecoded) return 0;
+
+	const auto& offset = gGameVars.gameScreenOffset;
+	const auto& size = gGameVars.gameScreen;
+	if (!sliceHUDFrame(frame, offset.x + frame.mAxisX, offset.y + frame.mAxisY, size.x, size.y, gUIHandler.mFrameRegions)) return 0;
+	for (auto& region : gUIHandler.mFrameRegions) {
+		region.mX -= frame.mAxisX;
+		region.mY -= frame.mAxisY;
+	}
+
+	const int lastIconX = UI_ICON_X + (UI_ICON_AMOUNT - 1) * UI_ICON_STEP;
+	gUIHandler.mIconRegion = findHUDFrameRegion(gUIHandler.mFrameRegions, UI_ICON_X, UI_HEART_Y);
+	if (gUIHandler.mIconRegion < 0 || findHUDFrameRegion(gUIHandler.mFrameRegions, lastIconX, UI_BOMB_Y) != gUIHandler.mIconRegion) {
+		gUIHandler.mFrameRegions.clear();
+		return 0;
+	}
+	gUIHandler.mIconRegionPixels = gUIHandler.mFrameRegions[gUIHandler.mIconRegion].mPixels;
+
+	for (auto& region : gUIHandler.mFrameRegions) {
+		if (!region.mIsOpaque) logWarningFormat("HUD frame region %d %d %d %d is not opaque.", region.mX, region.mY, region.mWidth, region.mHeight);
+		gUIHandler.mFrameTextures.push_back(uploadFrameRegion(region));
+	}
+	gUIHandler.mShownLives = gUIHandler.mShownBombs = -1;
+	return 1;
+}
+
+static void unloadSlicedFrame() {
+	for (auto& texture : gUIHandler.mFrameTextures) {
+		unloadTexture(texture);
+	}
+	gUIHandler.mFrameTextures.clear();
+	gUIHandler.mFrameRegions.clear();
+	gUIHandler.mIconRegionPixels.clear();
+}
+
+static void loadFrameAnimations() {
+	gUIHandler.mBGID = addMugenAnimation(getMugenAnimation(gUIHandler.mAnimations, 1), gUIHandler.mSprites, makePosition(0, 0, UI_BASE_Z));
+
+	for (int i = 0; i < UI_ICON_AMOUNT; i++) {
+		gUIHandler.mHeartAnimations[i] = addMugenAnimation(getMugenAnimation(gUIHandler.mAnimations, 2), gUIHandler.mSprites, makePosition(UI_ICON_X + i * UI_ICON_STEP, UI_HEART_Y, UI_BASE_Z + 2));
 		setMugenAnimationVisibility(gUIHandler.mHeartAnimations[i], 0);
-		gUIHandler.mBombAnimations[i] = addMugenAnimation(getMugenAnimation(&gUIHandler.mAnimations, 3), &gUIHandler.mSprites, makePosition(259 + i * 6, 69, UI_BASE_Z + 2));
+		gUIHandler.mBombAnimations[i] = addMugenAnimation(getMugenAnimation(gUIHandler.mAnimations, 3), gUIHandler.mSprites, makePosition(UI_ICON_X + i * UI_ICON_STEP, UI_BOMB_Y, UI_BASE_Z + 2));
 		setMugenAnimationVisibility(gUIHandler.mBombAnimations[i], 0);
 	}
+}
+
+static void loadUIHandler(void* tData) {
+	(void)tData;
+	gUIHandler.mSprites = acquireCachedMugenSpriteFile("data/UI.sff");
+	gUIHandler.mAnimations = acquireCachedMugenAnimationFile("data/UI.air");
+
+	gUIHandler.mIsFrameSliced = loadSlicedFrame();
+	if (!gUIHandler.mIsFrameSliced) {
+		logWarning("Unable to slice the HUD frame, drawing it in full.");
+		loadFrameAnimations();
+	}
 
 	gUIHandler.mHighScoreTextID = addMugenTextMugenStyle("232,124,241", makePosition(315, 29, UI_BASE_Z + 2), makeVector3DI(2, 0, -1));
 	setMugenTextScale(gUIHandler.mHighScoreTextID, 0.7);
@@ -56,13 +176,40 @@ static void loadUIHandler(void* tData) {
 	setMugenTextColorRGB(gUIHandler.mPointTextID, 75/ 255.0, 214 / 255.0, 1.0);
 }
 
+static void unloadUIHandler(void* tData) {
+	(void)tData;
+	unloadSlicedFrame();
+	releaseCachedMugenSpriteFile("data/UI.sff");
+	releaseCachedMugenAnimationFile("data/UI.air");
+}
+
+static void updateIconRegion() {
+	const int lifeAmount = std::min(getPlayerLife(), UI_ICON_AMOUNT);
+	const int bombAmount = std::min(getPlayerBombs(), UI_ICON_AMOUNT);
+	if (lifeAmount == gUIHandler.mShownLives && bombAmount == gUIHandler.mShownBombs) return;
+	gUIHandler.mShownLives = lifeAmount;
+	gUIHandler.mShownBombs = bombAmount;
+
+	auto& region = gUIHandler.mFrameRegions[gUIHandler.mIconRegion];
+	region.mPixels = gUIHandler.mIconRegionPixels;
+	for (int i = 0; i < lifeAmount; i++) {
+		blendHUDFrameSprite(region, gUIHandler.mHeartSprite, UI_ICON_X + i * UI_ICON_STEP, UI_HEART_Y);
+	}
+	for (int i = 0; i < bombAmount; i++) {
+		blendHUDFrameSprite(region, gUIHandler.mBombSprite, UI_ICON_X + i * UI_ICON_STEP, UI_BOMB_Y);
+	}
+
+	unloadTexture(gUIHandler.mFrameTextures[gUIHandler.mIconRegion]);
+	gUIHandler.mFrameTextures[gUIHandler.mIconRegion] = uploadFrameRegion(region);
+}
+
 static void updateLives() {
 	int lifeAmount = getPlayerLife();
 	int i;
 	for (i = 0; i < lifeAmount; i++) {
 		setMugenAnimationVisibility(gUIHandler.mHeartAnimations[i], 1);
 	}
-	for (; i < 8; i++) {
+	for (; i < UI_ICON_AMOUNT; i++) {
 		setMugenAnimationVisibility(gUIHandler.mHeartAnimations[i], 0);
 	}
 }
@@ -73,7 +220,7 @@ static void updateBombs() {
 	for (i = 0; i < bombAmount; i++) {
 		setMugenAnimationVisibility(gUIHandler.mBombAnimations[i], 1);
 	}
-	for (; i < 8; i++) {
+	for (; i < UI_ICON_AMOUNT; i++) {
 		setMugenAnimationVisibility(gUIHandler.mBombAnimations[i], 0);
 	}
 }
@@ -127,26 +274,44 @@ static void updateHighScore()
 
 static void updateUIHandler(void* tData) {
 	(void)tData;
-	updateLives();
-	updateBombs();
+	ProfileScope profileScope(PROFILE_ZONE_UI);
+	if (gUIHandler.mIsFrameSliced) {
+		updateIconRegion();
+	}
+	else {
+		updateLives();
+		updateBombs();
+	}
 	updateScore();
 	updatePower();
 	updateItemText();
 	updateHighScore();
 }
 
+static void drawUIHandler(void* tData) {
+	(void)tData;
+	ProfileScope profileScope(PROFILE_ZONE_DRAW_UI);
+	if (!gUIHandler.mIsFrameSliced) return;
+
+	// Texture rectangles are inclusive of their bottom right pixel.
+	for (size_t i = 0; i < gUIHandler.mFrameRegions.size(); i++) {
+		const auto& region = gUIHandler.mFrameRegions[i];
+		drawSprite(gUIHandler.mFrameTextures[i], makePosition(region.mX, region.mY, UI_BASE_Z), makeRectangle(0, 0, region.mWidth - 1, region.mHeight - 1));
+	}
+}
+
 ActorBlueprint getUIHandler()
 {
-	return makeActorBlueprint(loadUIHandler, NULL, updateUIHandler);
+	return makeActorBlueprint(loadUIHandler, unloadUIHandler, updateUIHandler, drawUIHandler);
 }
 
 MugenSpriteFile* getUISprites()
 {
-	return &gUIHandler.mSprites;
+	return gUIHandler.mSprites;
 }
 
 MugenAnimations* getUIAnimations()
 {
-	return &gUIHandler.mAnimations;
+	return gUIHandler.mAnimations;
 }
 
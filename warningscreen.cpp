@@ -2,6 +2,7 @@
 
 #include <prism/blitz.h>
 #include "menuscreen.h"
+#include "assetprefetch.h"
 static 	void gotoTitleScreen(void*)
 {
 	setNewScreen(getMenuScreen());
@@ -17,7 +18,7 @@ struct WarningScreen
 
 	WarningScreen()
 	{
-		mSprites = loadMugenSpriteFileWithoutPalette("title/WARNING.sff");
+		mSprites = loadPrefetchedMugenSpriteFileWithoutPalette("title/WARNING.sff");
 		mTimelineAnimations = loadBlitzTimelineAnimations("title/WARNING.taf");
 
 		mEntityID1 = addBlitzEntity(makePosition(0, 0, 1));